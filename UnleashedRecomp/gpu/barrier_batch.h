@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Collects layout transitions until the command list actually needs them. Only the layout a resource had
+// when it entered the batch and the last requested one matter, so a resource that ends up where it
+// started is dropped entirely. Batches rarely hold more than a handful of resources, which makes a
+// linear search cheaper than hashing.
+template<typename TResource, typename TLayout>
+struct BarrierBatch
+{
+    struct Entry
+    {
+        TResource resource;
+        TLayout initialLayout;
+        TLayout layout;
+        bool discard;
+    };
+
+    std::vector<Entry> entries;
+
+    // Discarding means the contents the resource had before the batch don't need to be kept.
+    void Add(TResource resource, TLayout previousLayout, TLayout layout, bool discard = false)
+    {
+        for (auto& entry : entries)
+        {
+            if (entry.resource == resource)
+            {
+                entry.layout = layout;
+                entry.discard |= discard;
+                return;
+            }
+        }
+
+        entries.push_back({ resource, previousLayout, layout, discard });
+    }
+
+    bool IsEmpty() const
+    {
+        return entries.empty();
+    }
+
+    // Appends a barrier for every resource whose layout changed and clears the batch.
+    // Returns how many resources were dropped for ending up in their initial layout.
+    template<typename TBarrier>
+    size_t Resolve(std::vector<TBarrier>& barriers)
+    {
+        size_t elidedCount = 0;
+
+        for (auto& entry : entries)
+        {
+            if (entry.initialLayout == entry.layout && !entry.discard)
+                ++elidedCount;
+            else
+                barriers.emplace_back(entry.resource, entry.layout, entry.discard);
+        }
+
+        entries.clear();
+        return elidedCount;
+    }
+};
+
+struct BarrierStats
+{
+    uint32_t batchCount = 0;
+    uint32_t transitionCount = 0;
+    uint32_t elidedCount = 0;
+    uint32_t prefetchedCount = 0;
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include <ankerl/unordered_dense.h>
+
+// Insert only registry of objects keyed by a 64 bit content hash, for lookups that vastly outnumber
+// insertions. Readers probe a fixed open addressed table with atomic loads and never lock, writers are
+// serialized by a mutex so every object gets created exactly once. Nothing is ever removed, so a pointer
+// that was found stays valid. A zero hash is reserved to mark empty slots.
+//
+// Past the capacity new objects go into a locked overflow map, which keeps it correct if a game
+// creates more objects than expected at the cost of locking for the ones that didn't fit.
+template<typename T, size_t Capacity>
+struct ConcurrentHashRegistry
+{
+    // Kept at most half full so probes stay short.
+    static constexpr size_t SLOT_COUNT = Capacity * 2;
+    static_assert((SLOT_COUNT & (SLOT_COUNT - 1)) == 0);
+
+    struct Slot
+    {
+        std::atomic<uint64_t> hash{ 0 };
+        std::atomic<T*> value{ nullptr };
+    };
+
+    std::unique_ptr<Slot[]> slots = std::make_unique<Slot[]>(SLOT_COUNT);
+    std::atomic<size_t> count = 0;
+
+    std::mutex mutex;
+    ankerl::unordered_dense::map<uint64_t, T*> overflow;
+    std::atomic<bool> overflowed = false;
+
+    static size_t GetSlot(uint64_t hash)
+    {
+        return size_t(hash) & (SLOT_COUNT - 1);
+    }
+
+    T* FindInTable(uint64_t hash) const
+    {
+        for (size_t slot = GetSlot(hash); ; slot = (slot + 1) & (SLOT_COUNT - 1))
+        {
+            uint64_t slotHash = slots[slot].hash.load(std::memory_order_acquire);
+            if (slotHash == hash)
+                return slots[slot].value.load(std::memory_order_relaxed);
+
+            if (slotHash == 0)
+                return nullptr;
+        }
+    }
+
+    T* Find(uint64_t hash)
+    {
+        T* value = FindInTable(hash);
+        if (value != nullptr || !overflowed.load(std::memory_order_acquire))
+            return value;
+
+        std::lock_guard lock(mutex);
+        auto findResult = overflow.find(hash);
+        return findResult != overflow.end() ? findResult->second : nullptr;
+    }
+
+    // Calls the function to create the object when the hash isn't registered yet. It runs with the writer
+    // mutex held, so it doesn't need to be reentrant, but it mustn't touch the registry itself.
+    template<typename TCreate>
+    T* FindOrCreate(uint64_t hash, TCreate&& create)
+    {
+        T* value = Find(hash);
+        if (value != nullptr)
+            return value;
+
+        std::lock_guard lock(mutex);
+
+        value = FindInTable(hash);
+        if (value != nullptr)
+            return value;
+
+        auto overflowResult = overflow.find(hash);
+        if (overflowResult != overflow.end())
+            return overflowResult->second;
+
+        value = create();
+
+        if (count.load(std::memory_order_relaxed) < Capacity)
+        {
+            size_t slot = GetSlot(hash);
+            while (slots[slot].hash.load(std::memory_order_relaxed) != 0)
+                slot = (slot + 1) & (SLOT_COUNT - 1);
+
+            // The value has to be visible before the hash that readers match on.
+            slots[slot].value.store(value, std::memory_order_relaxed);
+            slots[slot].hash.store(hash, std::memory_order_release);
+            count.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            overflow.emplace(hash, value);
+            overflowed.store(true, std::memory_order_release);
+        }
+
+        return value;
+    }
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Lock-free allocator of descriptor indices. Indices that were never handed out come from a bump counter,
+// freed ones go on an intrusive stack threaded through a next array. The stack head carries a tag that
+// changes on every update, so a pop can't succeed against a head that was popped and pushed back
+// in the meantime. Callers are responsible for only freeing an index once the GPU is done with it.
+struct DescriptorIndexAllocator
+{
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+
+    uint32_t capacity;
+    uint32_t firstIndex;
+    std::atomic<uint32_t> nextFresh;
+    std::atomic<uint64_t> freeHead;
+    std::unique_ptr<std::atomic<uint32_t>[]> freeNext;
+    std::atomic<uint32_t> freeCount = 0;
+
+    // Indices below firstIndex are reserved by the caller and never handed out.
+    DescriptorIndexAllocator(uint32_t capacity, uint32_t firstIndex = 0)
+        : capacity(capacity), firstIndex(firstIndex), nextFresh(firstIndex), freeHead(Pack(EMPTY, 0)), freeNext(std::make_unique<std::atomic<uint32_t>[]>(capacity))
+    {
+    }
+
+    static uint64_t Pack(uint32_t index, uint32_t tag)
+    {
+        return (uint64_t(tag) << 32) | index;
+    }
+
+    uint32_t allocate()
+    {
+        uint64_t head = freeHead.load(std::memory_order_acquire);
+
+        while (uint32_t(head) != EMPTY)
+        {
+            uint32_t index = uint32_t(head);
+            uint32_t next = freeNext[index].load(std::memory_order_relaxed);
+
+            if (freeHead.compare_exchange_weak(head, Pack(next, uint32_t(head >> 32) + 1), std::memory_order_acquire, std::memory_order_acquire))
+            {
+                freeCount.fetch_sub(1, std::memory_order_relaxed);
+                return index;
+            }
+        }
+
+        uint32_t index = nextFresh.fetch_add(1, std::memory_order_relaxed);
+        assert(index < capacity && "Ran out of descriptor indices.");
+        return index;
+    }
+
+    void free(uint32_t index)
+    {
+        assert(index < capacity);
+
+        uint64_t head = freeHead.load(std::memory_order_relaxed);
+
+        do
+        {
+            freeNext[index].store(uint32_t(head), std::memory_order_relaxed);
+        } while (!freeHead.compare_exchange_weak(head, Pack(index, uint32_t(head >> 32) + 1), std::memory_order_release, std::memory_order_relaxed));
+
+        freeCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Number of indices currently handed out, only approximate while other threads are allocating.
+    uint32_t getUsedCount() const
+    {
+        return nextFresh.load(std::memory_order_relaxed) - firstIndex - freeCount.load(std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif !defined(__APPLE__)
+#include <time.h>
+#endif
+
+// Sleeps until the given time with the best timer the platform has. Windows uses a high resolution
+// waitable timer, which wakes up within a fraction of a millisecond unlike Sleep. Linux and Android
+// sleep against an absolute CLOCK_MONOTONIC deadline, which is what steady_clock counts with there.
+inline void SleepUntil(std::chrono::steady_clock::time_point time)
+{
+#if defined(_WIN32)
+    thread_local HANDLE s_timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+
+    auto remaining = time - std::chrono::steady_clock::now();
+    if (remaining <= std::chrono::steady_clock::duration::zero())
+        return;
+
+    if (s_timer != nullptr)
+    {
+        // Negative values are relative, in 100 nanosecond units.
+        LARGE_INTEGER dueTime;
+        dueTime.QuadPart = -std::max<int64_t>(1, std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count() / 100);
+
+        if (SetWaitableTimer(s_timer, &dueTime, 0, nullptr, nullptr, FALSE))
+        {
+            WaitForSingleObject(s_timer, INFINITE);
+            return;
+        }
+    }
+
+    std::this_thread::sleep_until(time);
+#elif !defined(__APPLE__)
+    auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+
+    timespec deadline;
+    deadline.tv_sec = time_t(nanoseconds / 1000000000);
+    deadline.tv_nsec = long(nanoseconds % 1000000000);
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR)
+        ;
+#else
+    std::this_thread::sleep_until(time);
+#endif
+}
+
+// Frame intervals over a sliding window. Jitter is the standard deviation of the intervals.
+struct FrameTimingStats
+{
+    static constexpr size_t WINDOW_SIZE = 120;
+
+    double values[WINDOW_SIZE]{};
+    size_t count = 0;
+    size_t index = 0;
+
+    void Add(double value)
+    {
+        values[index] = value;
+        index = (index + 1) % WINDOW_SIZE;
+        count = std::min(count + 1, WINDOW_SIZE);
+    }
+
+    double GetAverage() const
+    {
+        if (count == 0)
+            return 0.0;
+
+        double sum = 0.0;
+        for (size_t i = 0; i < count; i++)
+            sum += values[i];
+
+        return sum / count;
+    }
+
+    double GetJitter() const
+    {
+        if (count < 2)
+            return 0.0;
+
+        double average = GetAverage();
+        double sum = 0.0;
+        for (size_t i = 0; i < count; i++)
+            sum += (values[i] - average) * (values[i] - average);
+
+        return std::sqrt(sum / count);
+    }
+
+    double GetMax() const
+    {
+        return count != 0 ? *std::max_element(values, values + count) : 0.0;
+    }
+};
+
+// Throttles the caller to a target frame time. Instead of sleeping a fixed margin short and spinning
+// through the rest, it learns how late the OS tends to wake it up and sleeps until just before the
+// deadline by that much, so the remaining spin is usually a few microseconds. The estimate is a mean
+// and deviation pair of moving averages, the same way TCP estimates round trip times. Only the wake up
+// latency is predicted, how long the frame itself takes to render doesn't move the deadline.
+struct FramePacer
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Starting guess before any wake ups were measured, errs on the side of waking up early.
+    static constexpr double INITIAL_WAKE_LATENCY_NS = 1000000.0;
+
+    Clock::time_point next;
+    Clock::time_point lastFrame;
+
+    double wakeLatency = INITIAL_WAKE_LATENCY_NS;
+    double wakeLatencyDeviation = INITIAL_WAKE_LATENCY_NS / 2.0;
+
+    FrameTimingStats intervalStats;
+    FrameTimingStats wakeLatencyStats;
+    uint64_t spinNanoseconds = 0;
+
+    // Never negative, sleeping past the deadline would always make the frame late.
+    Clock::duration GetSleepMargin() const
+    {
+        return std::chrono::nanoseconds(int64_t(std::max(0.0, wakeLatency + 2.0 * wakeLatencyDeviation)));
+    }
+
+    void AddWakeLatency(double latency)
+    {
+        wakeLatencyStats.Add(latency / 1000000.0);
+
+        double error = latency - wakeLatency;
+        wakeLatency += error / 8.0;
+        wakeLatencyDeviation += (std::abs(error) - wakeLatencyDeviation) / 4.0;
+    }
+
+    // Frames that arrive after their deadline resynchronize instead of trying to catch up.
+    template<typename TSleepUntil>
+    void Wait(Clock::duration frameTime, TSleepUntil&& sleepUntil)
+    {
+        auto now = Clock::now();
+
+        if (now < next)
+        {
+            auto sleepTarget = next - GetSleepMargin();
+
+            if (now < sleepTarget)
+            {
+                sleepUntil(sleepTarget);
+                now = Clock::now();
+                AddWakeLatency(double(std::chrono::duration_cast<std::chrono::nanoseconds>(now - sleepTarget).count()));
+            }
+
+            auto spinStart = now;
+            while ((now = Clock::now()) < next)
+                std::this_thread::yield();
+
+            spinNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(now - spinStart).count();
+        }
+        else
+        {
+            next = now;
+            spinNanoseconds = 0;
+        }
+
+        next += frameTime;
+        MarkFrame(now);
+    }
+
+    void Wait(Clock::duration frameTime)
+    {
+        Wait(frameTime, SleepUntil);
+    }
+
+    // Also called on unthrottled frames so the interval statistics stay meaningful.
+    void MarkFrame(Clock::time_point now)
+    {
+        if (lastFrame != Clock::time_point())
+            intervalStats.Add(std::chrono::duration<double, std::milli>(now - lastFrame).count());
+
+        lastFrame = now;
+    }
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Index patterns for primitive types the host can't draw directly. The patterns only depend on the
+// primitive index, so a buffer generated for N primitives serves every draw with up to N primitives.
+
+inline void GenerateTriangleFanIndices(uint16_t* indices, size_t firstPrimitive, size_t primitiveCount)
+{
+    for (size_t i = firstPrimitive; i < firstPrimitive + primitiveCount; i++)
+    {
+        indices[i * 3 + 0] = 0;
+        indices[i * 3 + 1] = static_cast<uint16_t>(i + 1);
+        indices[i * 3 + 2] = static_cast<uint16_t>(i + 2);
+    }
+}
+
+inline void GenerateQuadListIndices(uint16_t* indices, size_t firstPrimitive, size_t primitiveCount)
+{
+    for (size_t i = firstPrimitive; i < firstPrimitive + primitiveCount; i++)
+    {
+        indices[i * 6 + 0] = static_cast<uint16_t>(i * 4 + 0);
+        indices[i * 6 + 1] = static_cast<uint16_t>(i * 4 + 1);
+        indices[i * 6 + 2] = static_cast<uint16_t>(i * 4 + 2);
+
+        indices[i * 6 + 3] = static_cast<uint16_t>(i * 4 + 0);
+        indices[i * 6 + 4] = static_cast<uint16_t>(i * 4 + 2);
+        indices[i * 6 + 5] = static_cast<uint16_t>(i * 4 + 3);
+    }
+}
+
+// Rewrites a triangle strip with restart indices into a single strip joined by degenerate triangles.
+// Only compares against the restart index and copies values around, so it works on guest indices
+// without swapping them first. The output needs room for three times the input, returns how much got written.
+inline uint32_t ConvertStripRestartsToDegenerates(const uint16_t* indices, uint32_t indexCount, uint16_t* newIndices)
+{
+    uint32_t newIndexCount = 0;
+
+    bool stripStart = true;
+    uint32_t stripSize = 0;
+    uint16_t lastIndex = 0;
+
+    for (uint32_t i = 0; i < indexCount; i++)
+    {
+        uint16_t index = indices[i];
+        if (index == 0xFFFF)
+        {
+            if ((stripSize % 2) != 0)
+                newIndices[newIndexCount++] = lastIndex;
+
+            stripStart = true;
+            stripSize = 0;
+        }
+        else
+        {
+            if (stripStart && newIndexCount != 0)
+            {
+                newIndices[newIndexCount++] = lastIndex;
+                newIndices[newIndexCount++] = index;
+            }
+
+            newIndices[newIndexCount++] = index;
+            stripStart = false;
+            ++stripSize;
+            lastIndex = index;
+        }
+    }
+
+    return newIndexCount;
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <ankerl/unordered_dense.h>
+
+// Bounded map that evicts the least recently used entry once the capacity is exceeded.
+// Entries live in a vector and are linked into the recency list by index, so inserting
+// doesn't allocate a node per entry. Erased slots get reused by later insertions.
+// Not thread safe, callers are expected to use it from a single thread or lock around it.
+template<typename TKey, typename TValue, typename THash = ankerl::unordered_dense::hash<TKey>>
+struct LruMap
+{
+    static constexpr uint32_t INVALID_INDEX = ~0u;
+
+    struct Node
+    {
+        TKey key;
+        TValue value;
+        uint32_t prev;
+        uint32_t next;
+    };
+
+    std::vector<Node> nodes;
+    ankerl::unordered_dense::map<TKey, uint32_t, THash> entries;
+    uint32_t head = INVALID_INDEX; // Most recently used.
+    uint32_t tail = INVALID_INDEX; // Least recently used.
+    uint32_t freeHead = INVALID_INDEX; // Erased slots, chained through their next index.
+    size_t capacity;
+
+    uint64_t hitCount = 0;
+    uint64_t missCount = 0;
+    uint64_t evictionCount = 0;
+
+    LruMap(size_t capacity) : capacity(capacity)
+    {
+    }
+
+    void Unlink(uint32_t index)
+    {
+        auto& node = nodes[index];
+
+        if (node.prev != INVALID_INDEX)
+            nodes[node.prev].next = node.next;
+        else
+            head = node.next;
+
+        if (node.next != INVALID_INDEX)
+            nodes[node.next].prev = node.prev;
+        else
+            tail = node.prev;
+    }
+
+    void LinkFront(uint32_t index)
+    {
+        auto& node = nodes[index];
+        node.prev = INVALID_INDEX;
+        node.next = head;
+
+        if (head != INVALID_INDEX)
+            nodes[head].prev = index;
+        else
+            tail = index;
+
+        head = index;
+    }
+
+    void MoveToFront(uint32_t index)
+    {
+        if (head != index)
+        {
+            Unlink(index);
+            LinkFront(index);
+        }
+    }
+
+    void Free(uint32_t index)
+    {
+        Unlink(index);
+        nodes[index].value = TValue();
+        nodes[index].next = freeHead;
+        freeHead = index;
+    }
+
+    // Returns true if the key was not present. An existing entry only gets marked as recently used.
+    bool Insert(const TKey& key, const TValue& value)
+    {
+        auto findResult = entries.find(key);
+        if (findResult != entries.end())
+        {
+            MoveToFront(findResult->second);
+            ++hitCount;
+            return false;
+        }
+
+        ++missCount;
+
+        uint32_t index;
+        if (freeHead != INVALID_INDEX)
+        {
+            index = freeHead;
+            freeHead = nodes[index].next;
+            nodes[index].key = key;
+            nodes[index].value = value;
+        }
+        else
+        {
+            index = uint32_t(nodes.size());
+            nodes.push_back({ key, value, INVALID_INDEX, INVALID_INDEX });
+        }
+
+        LinkFront(index);
+        entries.emplace(key, index);
+
+        while (entries.size() > capacity)
+        {
+            uint32_t evicted = tail;
+            entries.erase(nodes[evicted].key);
+            Free(evicted);
+            ++evictionCount;
+        }
+
+        return true;
+    }
+
+    TValue* Find(const TKey& key)
+    {
+        auto findResult = entries.find(key);
+        if (findResult == entries.end())
+            return nullptr;
+
+        MoveToFront(findResult->second);
+        return &nodes[findResult->second].value;
+    }
+
+    bool Erase(const TKey& key)
+    {
+        auto findResult = entries.find(key);
+        if (findResult == entries.end())
+            return false;
+
+        uint32_t index = findResult->second;
+        entries.erase(findResult);
+        Free(index);
+        return true;
+    }
+
+    // Visits the entries from the most to the least recently used one, without changing their recency.
+    template<typename TFunction>
+    void ForEach(TFunction&& function) const
+    {
+        for (uint32_t index = head; index != INVALID_INDEX; index = nodes[index].next)
+            function(nodes[index].key, nodes[index].value);
+    }
+
+    size_t Size() const
+    {
+        return entries.size();
+    }
+
+    // Rough footprint of the bookkeeping, excluding whatever the values point to.
+    size_t MemoryUsage() const
+    {
+        return nodes.capacity() * sizeof(Node) + entries.values().capacity() * (sizeof(TKey) + sizeof(uint32_t)) +
+            entries.bucket_count() * sizeof(uint64_t);
+    }
+};
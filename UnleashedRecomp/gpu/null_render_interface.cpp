@@ -0,0 +1,595 @@
+#include "null_render_interface.h"
+
+namespace plume {
+    NullRenderStats g_nullRenderStats;
+
+    int64_t NullRenderStats::getTotalLiveCount() const {
+        int64_t count = 0;
+        for (auto &live : liveResources) {
+            count += live.load();
+        }
+
+        return count;
+    }
+
+    void NullRenderStats::reset() {
+        // Live counts are left alone, resetting them while objects are alive would make them go negative.
+        for (auto &created : createdResources) {
+            created = 0;
+        }
+
+        submittedCommandLists = 0;
+        submittedCommands = 0;
+        submittedDraws = 0;
+        submittedDispatches = 0;
+        submittedBarriers = 0;
+        submittedCopies = 0;
+        presentCount = 0;
+    }
+
+    // NullBuffer
+
+    NullBuffer::NullBuffer(NullDevice *device, const RenderBufferDesc &desc) : desc(desc) {
+        deviceAddress = device->nextDeviceAddress.fetch_add((desc.size + 0xFFFF) & ~0xFFFFull);
+        g_nullRenderStats.liveBufferBytes += desc.size;
+    }
+
+    NullBuffer::~NullBuffer() {
+        g_nullRenderStats.liveBufferBytes -= desc.size;
+    }
+
+    void *NullBuffer::map(uint32_t subresource, const RenderRange *readRange) {
+        // Host memory only gets allocated once something actually writes to the buffer.
+        if (data == nullptr) {
+            data.reset(new uint8_t[desc.size]);
+        }
+
+        return data.get();
+    }
+
+    void NullBuffer::unmap(uint32_t subresource, const RenderRange *writtenRange) {
+    }
+
+    std::unique_ptr<RenderBufferFormattedView> NullBuffer::createBufferFormattedView(RenderFormat format) {
+        return std::make_unique<NullBufferFormattedView>(this, format);
+    }
+
+    void NullBuffer::setName(const std::string &name) {
+    }
+
+    uint64_t NullBuffer::getDeviceAddress() const {
+        return deviceAddress;
+    }
+
+    // NullBufferFormattedView
+
+    NullBufferFormattedView::NullBufferFormattedView(NullBuffer *buffer, RenderFormat format) : buffer(buffer), format(format) {
+    }
+
+    // NullTexture
+
+    NullTexture::NullTexture(const RenderTextureDesc &desc) : desc(desc) {
+    }
+
+    std::unique_ptr<RenderTextureView> NullTexture::createTextureView(const RenderTextureViewDesc &desc) const {
+        return std::make_unique<NullTextureView>(this, desc);
+    }
+
+    void NullTexture::setName(const std::string &name) {
+    }
+
+    // NullTextureView
+
+    NullTextureView::NullTextureView(const NullTexture *texture, const RenderTextureViewDesc &desc) : texture(texture), desc(desc) {
+    }
+
+    // NullAccelerationStructure
+
+    NullAccelerationStructure::NullAccelerationStructure(const RenderAccelerationStructureDesc &desc) : type(desc.type) {
+    }
+
+    // NullShader
+
+    NullShader::NullShader(uint64_t size, RenderShaderFormat format) : format(format), size(size) {
+    }
+
+    void NullShader::setName(const std::string &name) {
+    }
+
+    // NullSampler
+
+    NullSampler::NullSampler(const RenderSamplerDesc &desc) : desc(desc) {
+    }
+
+    // NullPipeline
+
+    void NullPipeline::setName(const std::string &name) {
+    }
+
+    RenderPipelineProgram NullPipeline::getProgram(const std::string &name) const {
+        return RenderPipelineProgram();
+    }
+
+    // NullDescriptorSet
+
+    void NullDescriptorSet::setBuffer(uint32_t descriptorIndex, const RenderBuffer *buffer, uint64_t bufferSize, const RenderBufferStructuredView *bufferStructuredView, const RenderBufferFormattedView *bufferFormattedView) {
+        ++updateCount;
+    }
+
+    void NullDescriptorSet::setTexture(uint32_t descriptorIndex, const RenderTexture *texture, RenderTextureLayout textureLayout, const RenderTextureView *textureView) {
+        ++updateCount;
+    }
+
+    void NullDescriptorSet::setSampler(uint32_t descriptorIndex, const RenderSampler *sampler) {
+        ++updateCount;
+    }
+
+    void NullDescriptorSet::setAccelerationStructure(uint32_t descriptorIndex, const RenderAccelerationStructure *accelerationStructure) {
+        ++updateCount;
+    }
+
+    // NullSwapChain
+
+    NullSwapChain::NullSwapChain(RenderWindow renderWindow, uint32_t textureCount, RenderFormat format) : renderWindow(renderWindow) {
+        RenderTextureDesc desc = RenderTextureDesc::ColorTarget(WIDTH, HEIGHT, format);
+        textures.reserve(textureCount);
+
+        for (uint32_t i = 0; i < textureCount; i++) {
+            textures.emplace_back(desc);
+        }
+    }
+
+    bool NullSwapChain::present(uint32_t textureIndex, RenderCommandSemaphore **waitSemaphores, uint32_t waitSemaphoreCount) {
+        ++g_nullRenderStats.presentCount;
+        return true;
+    }
+
+    void NullSwapChain::wait() {
+    }
+
+    bool NullSwapChain::resize() {
+        return true;
+    }
+
+    bool NullSwapChain::needsResize() const {
+        return false;
+    }
+
+    void NullSwapChain::setVsyncEnabled(bool vsyncEnabled) {
+        this->vsyncEnabled = vsyncEnabled;
+    }
+
+    bool NullSwapChain::isVsyncEnabled() const {
+        return vsyncEnabled;
+    }
+
+    uint32_t NullSwapChain::getWidth() const {
+        return WIDTH;
+    }
+
+    uint32_t NullSwapChain::getHeight() const {
+        return HEIGHT;
+    }
+
+    RenderTexture *NullSwapChain::getTexture(uint32_t textureIndex) {
+        return &textures[textureIndex];
+    }
+
+    uint32_t NullSwapChain::getTextureCount() const {
+        return uint32_t(textures.size());
+    }
+
+    bool NullSwapChain::acquireTexture(RenderCommandSemaphore *signalSemaphore, uint32_t *textureIndex) {
+        *textureIndex = nextTextureIndex;
+        nextTextureIndex = (nextTextureIndex + 1) % uint32_t(textures.size());
+        return true;
+    }
+
+    RenderWindow NullSwapChain::getWindow() const {
+        return renderWindow;
+    }
+
+    bool NullSwapChain::isEmpty() const {
+        return false;
+    }
+
+    uint32_t NullSwapChain::getRefreshRate() const {
+        return 60;
+    }
+
+    // NullFramebuffer
+
+    NullFramebuffer::NullFramebuffer(const RenderFramebufferDesc &desc) {
+        const RenderTexture *attachment = desc.colorAttachmentsCount > 0 ? desc.colorAttachments[0] : desc.depthAttachment;
+        if (attachment != nullptr) {
+            const NullTexture *texture = static_cast<const NullTexture *>(attachment);
+            width = texture->desc.width;
+            height = texture->desc.height;
+        }
+    }
+
+    uint32_t NullFramebuffer::getWidth() const {
+        return width;
+    }
+
+    uint32_t NullFramebuffer::getHeight() const {
+        return height;
+    }
+
+    // NullQueryPool
+
+    NullQueryPool::NullQueryPool(uint32_t queryCount) : results(queryCount) {
+    }
+
+    void NullQueryPool::queryResults() {
+    }
+
+    const uint64_t *NullQueryPool::getResults() const {
+        return results.data();
+    }
+
+    uint32_t NullQueryPool::getCount() const {
+        return uint32_t(results.size());
+    }
+
+    // NullCommandList
+
+    void NullCommandList::begin() {
+        stats = {};
+        recording = true;
+    }
+
+    void NullCommandList::end() {
+        recording = false;
+    }
+
+    void NullCommandList::barriers(RenderBarrierStages stages, const RenderBufferBarrier *bufferBarriers, uint32_t bufferBarriersCount, const RenderTextureBarrier *textureBarriers, uint32_t textureBarriersCount) {
+        ++stats.commandCount;
+        stats.barrierCount += bufferBarriersCount + textureBarriersCount;
+    }
+
+    void NullCommandList::dispatch(uint32_t threadGroupCountX, uint32_t threadGroupCountY, uint32_t threadGroupCountZ) {
+        ++stats.commandCount;
+        ++stats.dispatchCount;
+    }
+
+    void NullCommandList::traceRays(uint32_t width, uint32_t height, uint32_t depth, RenderBufferReference shaderBindingTable, const RenderShaderBindingGroupsInfo &shaderBindingGroupsInfo) {
+        ++stats.commandCount;
+        ++stats.dispatchCount;
+    }
+
+    void NullCommandList::drawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation) {
+        ++stats.commandCount;
+        ++stats.drawCount;
+    }
+
+    void NullCommandList::drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation) {
+        ++stats.commandCount;
+        ++stats.drawCount;
+    }
+
+    void NullCommandList::setPipeline(const RenderPipeline *pipeline) {
+        ++stats.commandCount;
+        ++stats.stateChangeCount;
+    }
+
+    void NullCommandList::setComputePipelineLayout(const RenderPipelineLayout *pipelineLayout) {
+        ++stats.commandCount;
+        ++stats.stateChangeCount;
+    }
+
+    void NullCommandList::setComputePushConstants(uint32_t rangeIndex, const void *data, uint32_t offset, uint32_t size) {
+        ++stats.commandCount;
+        ++stats.stateChangeCount;
+    }
+
+    void NullCommandList::setComputeDescriptorSet(RenderDescriptorSet *descriptorSet, uint32_t setIndex) {
+        ++stats.commandCount;
+        ++stats.stateChangeCount;
+    }
+
+    void NullCommandList::setGraphicsPipelineLayout(const RenderPipelineLayout *pipelineLayout) {
+        ++stats.commandCount;
+        ++stats.stateChangeCount;
+    }
+
+    void NullCommandList::setGraphicsPushConstants(uint32_t rangeIndex, const void *data, uint32_t offset, uint32_t size) {
+        ++stats.commandCount;
+        ++stats.stateChangeCount;
+    }
+
+    void NullCommandList::setGraphicsDescriptorSet(RenderDescriptorSet *descriptorSet, uint32_t setIndex) {
+        ++stats.commandCount;
+        ++stats.stateChangeCount;
+    }
+
+    void NullCommandList::setGraphicsRootDescriptor(RenderBufferReference bufferReference, uint32_t rootDescriptorIndex) {
+        ++stats.commandCount;
+        ++stats.stateChangeCount;
+    }
+
+    void NullCommandList::setRaytracingPipelineLayout(const RenderPipelineLayout *pipelineLayout) {
+        ++stats.commandCount;
+        ++stats.stateChangeCount;
+    }
+
+    void NullCommandList::setRaytracingPushConstants(uint32_t rangeIndex, const void *data, uint32_t offset, uint32_t size) {
+        ++stats.commandCount;
+        ++stats.stateChangeCount;
+    }
+
+    void NullCommandList::setRaytracingDescriptorSet(RenderDescriptorSet *descriptorSet, uint32_t setIndex) {
+        ++stats.commandCount;
+        ++stats.stateChangeCount;
+    }
+
+    void NullCommandList::setIndexBuffer(const RenderIndexBufferView *view) {
+        ++stats.commandCount;
+        ++stats.stateChangeCount;
+    }
+
+    void NullCommandList::setVertexBuffers(uint32_t startSlot, const RenderVertexBufferView *views, uint32_t viewCount, const RenderInputSlot *inputSlots) {
+        ++stats.commandCount;
+        ++stats.stateChangeCount;
+    }
+
+    void NullCommandList::setViewports(const RenderViewport *viewports, uint32_t count) {
+        ++stats.commandCount;
+        ++stats.stateChangeCount;
+    }
+
+    void NullCommandList::setScissors(const RenderRect *scissorRects, uint32_t count) {
+        ++stats.commandCount;
+        ++stats.stateChangeCount;
+    }
+
+    void NullCommandList::setFramebuffer(const RenderFramebuffer *framebuffer) {
+        ++stats.commandCount;
+        ++stats.stateChangeCount;
+    }
+
+    void NullCommandList::setDepthBias(float depthBias, float depthBiasClamp, float slopeScaledDepthBias) {
+        ++stats.commandCount;
+        ++stats.stateChangeCount;
+    }
+
+    void NullCommandList::clearColor(uint32_t attachmentIndex, RenderColor colorValue, const RenderRect *clearRects, uint32_t clearRectsCount) {
+        ++stats.commandCount;
+        ++stats.clearCount;
+    }
+
+    void NullCommandList::clearDepthStencil(bool clearDepth, bool clearStencil, float depthValue, uint32_t stencilValue, const RenderRect *clearRects, uint32_t clearRectsCount) {
+        ++stats.commandCount;
+        ++stats.clearCount;
+    }
+
+    void NullCommandList::copyBufferRegion(RenderBufferReference dstBuffer, RenderBufferReference srcBuffer, uint64_t size) {
+        ++stats.commandCount;
+        ++stats.copyCount;
+    }
+
+    void NullCommandList::copyTextureRegion(const RenderTextureCopyLocation &dstLocation, const RenderTextureCopyLocation &srcLocation, uint32_t dstX, uint32_t dstY, uint32_t dstZ, const RenderBox *srcBox) {
+        ++stats.commandCount;
+        ++stats.copyCount;
+    }
+
+    void NullCommandList::copyBuffer(const RenderBuffer *dstBuffer, const RenderBuffer *srcBuffer) {
+        ++stats.commandCount;
+        ++stats.copyCount;
+    }
+
+    void NullCommandList::copyTexture(const RenderTexture *dstTexture, const RenderTexture *srcTexture) {
+        ++stats.commandCount;
+        ++stats.copyCount;
+    }
+
+    void NullCommandList::resolveTexture(const RenderTexture *dstTexture, const RenderTexture *srcTexture) {
+        ++stats.commandCount;
+        ++stats.copyCount;
+    }
+
+    void NullCommandList::resolveTextureRegion(const RenderTexture *dstTexture, uint32_t dstX, uint32_t dstY, const RenderTexture *srcTexture, const RenderRect *srcRect, RenderResolveMode resolveMode) {
+        ++stats.commandCount;
+        ++stats.copyCount;
+    }
+
+    void NullCommandList::buildBottomLevelAS(const RenderAccelerationStructure *dstAccelerationStructure, RenderBufferReference scratchBuffer, const RenderBottomLevelASBuildInfo &buildInfo) {
+        ++stats.commandCount;
+    }
+
+    void NullCommandList::buildTopLevelAS(const RenderAccelerationStructure *dstAccelerationStructure, RenderBufferReference scratchBuffer, RenderBufferReference instancesBuffer, const RenderTopLevelASBuildInfo &buildInfo) {
+        ++stats.commandCount;
+    }
+
+    void NullCommandList::discardTexture(const RenderTexture *texture) {
+        ++stats.commandCount;
+    }
+
+    void NullCommandList::resetQueryPool(const RenderQueryPool *queryPool, uint32_t queryFirstIndex, uint32_t queryCount) {
+        ++stats.commandCount;
+    }
+
+    void NullCommandList::writeTimestamp(const RenderQueryPool *queryPool, uint32_t queryIndex) {
+        ++stats.commandCount;
+    }
+
+    // NullCommandQueue
+
+    NullCommandQueue::NullCommandQueue(RenderCommandListType type) : type(type) {
+    }
+
+    std::unique_ptr<RenderCommandList> NullCommandQueue::createCommandList() {
+        return std::make_unique<NullCommandList>();
+    }
+
+    std::unique_ptr<RenderSwapChain> NullCommandQueue::createSwapChain(RenderWindow renderWindow, uint32_t bufferCount, RenderFormat format, uint32_t maxFrameLatency) {
+        return std::make_unique<NullSwapChain>(renderWindow, bufferCount, format);
+    }
+
+    void NullCommandQueue::executeCommandLists(const RenderCommandList **commandLists, uint32_t commandListCount, RenderCommandSemaphore **waitSemaphores, uint32_t waitSemaphoreCount, RenderCommandSemaphore **signalSemaphores, uint32_t signalSemaphoreCount, RenderCommandFence *signalFence) {
+        for (uint32_t i = 0; i < commandListCount; i++) {
+            const NullCommandStats &stats = static_cast<const NullCommandList *>(commandLists[i])->stats;
+            g_nullRenderStats.submittedCommands += stats.commandCount;
+            g_nullRenderStats.submittedDraws += stats.drawCount;
+            g_nullRenderStats.submittedDispatches += stats.dispatchCount;
+            g_nullRenderStats.submittedBarriers += stats.barrierCount;
+            g_nullRenderStats.submittedCopies += stats.copyCount;
+        }
+
+        g_nullRenderStats.submittedCommandLists += commandListCount;
+    }
+
+    void NullCommandQueue::waitForCommandFence(RenderCommandFence *fence) {
+        // Submissions complete immediately, there is never anything to wait for.
+    }
+
+    // NullPool
+
+    NullPool::NullPool(NullDevice *device) : device(device) {
+    }
+
+    std::unique_ptr<RenderBuffer> NullPool::createBuffer(const RenderBufferDesc &desc) {
+        return device->createBuffer(desc);
+    }
+
+    std::unique_ptr<RenderTexture> NullPool::createTexture(const RenderTextureDesc &desc) {
+        return device->createTexture(desc);
+    }
+
+    // NullDevice
+
+    NullDevice::NullDevice() {
+        description.name = "Null Device";
+        description.type = RenderDeviceType::CPU;
+        description.vendor = RenderDeviceVendor::UNKNOWN;
+
+        // Report plenty of memory so the low end defaults don't kick in and skew measurements.
+        description.dedicatedVideoMemory = 8ULL * 1024ULL * 1024ULL * 1024ULL;
+
+        capabilities.descriptorIndexing = true;
+        capabilities.scalarBlockLayout = true;
+        capabilities.bufferDeviceAddress = true;
+        capabilities.resolveModes = true;
+        capabilities.dynamicDepthBias = true;
+        capabilities.queryPools = true;
+        capabilities.maxTextureSize = 16384;
+        capabilities.textureCompressionBC = true;
+    }
+
+    std::unique_ptr<RenderDescriptorSet> NullDevice::createDescriptorSet(const RenderDescriptorSetDesc &desc) {
+        return std::make_unique<NullDescriptorSet>();
+    }
+
+    std::unique_ptr<RenderShader> NullDevice::createShader(const void *data, uint64_t size, const char *entryPointName, RenderShaderFormat format) {
+        return std::make_unique<NullShader>(size, format);
+    }
+
+    std::unique_ptr<RenderSampler> NullDevice::createSampler(const RenderSamplerDesc &desc) {
+        return std::make_unique<NullSampler>(desc);
+    }
+
+    std::unique_ptr<RenderPipeline> NullDevice::createComputePipeline(const RenderComputePipelineDesc &desc) {
+        return std::make_unique<NullPipeline>();
+    }
+
+    std::unique_ptr<RenderPipeline> NullDevice::createGraphicsPipeline(const RenderGraphicsPipelineDesc &desc) {
+        return std::make_unique<NullPipeline>();
+    }
+
+    std::unique_ptr<RenderPipeline> NullDevice::createRaytracingPipeline(const RenderRaytracingPipelineDesc &desc, const RenderPipeline *previousPipeline) {
+        return std::make_unique<NullPipeline>();
+    }
+
+    std::unique_ptr<RenderCommandQueue> NullDevice::createCommandQueue(RenderCommandListType type) {
+        return std::make_unique<NullCommandQueue>(type);
+    }
+
+    std::unique_ptr<RenderBuffer> NullDevice::createBuffer(const RenderBufferDesc &desc) {
+        return std::make_unique<NullBuffer>(this, desc);
+    }
+
+    std::unique_ptr<RenderTexture> NullDevice::createTexture(const RenderTextureDesc &desc) {
+        return std::make_unique<NullTexture>(desc);
+    }
+
+    std::unique_ptr<RenderAccelerationStructure> NullDevice::createAccelerationStructure(const RenderAccelerationStructureDesc &desc) {
+        return std::make_unique<NullAccelerationStructure>(desc);
+    }
+
+    std::unique_ptr<RenderPool> NullDevice::createPool(const RenderPoolDesc &desc) {
+        return std::make_unique<NullPool>(this);
+    }
+
+    std::unique_ptr<RenderPipelineLayout> NullDevice::createPipelineLayout(const RenderPipelineLayoutDesc &desc) {
+        return std::make_unique<NullPipelineLayout>();
+    }
+
+    std::unique_ptr<RenderCommandFence> NullDevice::createCommandFence() {
+        return std::make_unique<NullCommandFence>();
+    }
+
+    std::unique_ptr<RenderCommandSemaphore> NullDevice::createCommandSemaphore() {
+        return std::make_unique<NullCommandSemaphore>();
+    }
+
+    std::unique_ptr<RenderFramebuffer> NullDevice::createFramebuffer(const RenderFramebufferDesc &desc) {
+        return std::make_unique<NullFramebuffer>(desc);
+    }
+
+    std::unique_ptr<RenderQueryPool> NullDevice::createQueryPool(uint32_t queryCount) {
+        return std::make_unique<NullQueryPool>(queryCount);
+    }
+
+    void NullDevice::setBottomLevelASBuildInfo(RenderBottomLevelASBuildInfo &buildInfo, const RenderBottomLevelASMesh *meshes, uint32_t meshCount, bool preferFastBuild, bool preferFastTrace) {
+    }
+
+    void NullDevice::setTopLevelASBuildInfo(RenderTopLevelASBuildInfo &buildInfo, const RenderTopLevelASInstance *instances, uint32_t instanceCount, bool preferFastBuild, bool preferFastTrace) {
+    }
+
+    void NullDevice::setShaderBindingTableInfo(RenderShaderBindingTableInfo &tableInfo, const RenderShaderBindingGroups &groups, const RenderPipeline *pipeline, RenderDescriptorSet **descriptorSets, uint32_t descriptorSetCount) {
+    }
+
+    const RenderDeviceCapabilities &NullDevice::getCapabilities() const {
+        return capabilities;
+    }
+
+    const RenderDeviceDescription &NullDevice::getDescription() const {
+        return description;
+    }
+
+    RenderSampleCounts NullDevice::getSampleCountsSupported(RenderFormat format) const {
+        return RenderSampleCount::COUNT_1 | RenderSampleCount::COUNT_2 | RenderSampleCount::COUNT_4 | RenderSampleCount::COUNT_8;
+    }
+
+    bool NullDevice::beginCapture() {
+        return false;
+    }
+
+    bool NullDevice::endCapture() {
+        return false;
+    }
+
+    // NullInterface
+
+    NullInterface::NullInterface() {
+        // Report SPIR-V so the video layer takes the same shader path as it does on Vulkan.
+        capabilities.shaderFormat = RenderShaderFormat::SPIRV;
+        deviceNames.emplace_back("Null Device");
+    }
+
+    std::unique_ptr<RenderDevice> NullInterface::createDevice(const std::string &preferredDeviceName) {
+        return std::make_unique<NullDevice>();
+    }
+
+    const RenderInterfaceCapabilities &NullInterface::getCapabilities() const {
+        return capabilities;
+    }
+
+    const std::vector<std::string> &NullInterface::getDeviceNames() const {
+        return deviceNames;
+    }
+
+    std::unique_ptr<RenderInterface> CreateNullInterface() {
+        return std::make_unique<NullInterface>();
+    }
+};
@@ -0,0 +1,340 @@
+#pragma once
+
+#include <plume_render_interface.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Headless backend that accepts every creation and recording call without touching a GPU.
+// Useful for measuring the CPU side of the video layer in isolation, and for running the
+// game on machines without a usable driver. Buffers are backed by host memory so upload
+// paths keep working, everything else is just bookkeeping.
+namespace plume {
+    enum class NullResourceType {
+        Buffer,
+        BufferFormattedView,
+        Texture,
+        TextureView,
+        AccelerationStructure,
+        PipelineLayout,
+        Shader,
+        Sampler,
+        Pipeline,
+        DescriptorSet,
+        SwapChain,
+        Framebuffer,
+        QueryPool,
+        CommandList,
+        CommandFence,
+        CommandSemaphore,
+        CommandQueue,
+        Pool,
+        Count
+    };
+
+    struct NullCommandStats {
+        uint64_t commandCount = 0;
+        uint64_t drawCount = 0;
+        uint64_t dispatchCount = 0;
+        uint64_t barrierCount = 0;
+        uint64_t copyCount = 0;
+        uint64_t clearCount = 0;
+        uint64_t stateChangeCount = 0;
+    };
+
+    struct NullRenderStats {
+        std::atomic<int64_t> liveResources[size_t(NullResourceType::Count)];
+        std::atomic<uint64_t> createdResources[size_t(NullResourceType::Count)];
+        std::atomic<uint64_t> liveBufferBytes;
+
+        // Totals of every command list that got submitted to a queue.
+        std::atomic<uint64_t> submittedCommandLists;
+        std::atomic<uint64_t> submittedCommands;
+        std::atomic<uint64_t> submittedDraws;
+        std::atomic<uint64_t> submittedDispatches;
+        std::atomic<uint64_t> submittedBarriers;
+        std::atomic<uint64_t> submittedCopies;
+        std::atomic<uint64_t> presentCount;
+
+        void onCreate(NullResourceType type) {
+            ++liveResources[size_t(type)];
+            ++createdResources[size_t(type)];
+        }
+
+        void onDestroy(NullResourceType type) {
+            --liveResources[size_t(type)];
+        }
+
+        int64_t getLiveCount(NullResourceType type) const {
+            return liveResources[size_t(type)].load();
+        }
+
+        int64_t getTotalLiveCount() const;
+        void reset();
+    };
+
+    // Global so objects outliving their device (eg. at shutdown) can still be accounted for safely.
+    extern NullRenderStats g_nullRenderStats;
+
+    template<NullResourceType Type>
+    struct NullTracked {
+        NullTracked() { g_nullRenderStats.onCreate(Type); }
+        NullTracked(const NullTracked &) { g_nullRenderStats.onCreate(Type); }
+        ~NullTracked() { g_nullRenderStats.onDestroy(Type); }
+    };
+
+    struct NullCommandQueue;
+    struct NullDevice;
+    struct NullInterface;
+
+    struct NullBuffer : RenderBuffer {
+        NullTracked<NullResourceType::Buffer> tracked;
+        RenderBufferDesc desc;
+        std::unique_ptr<uint8_t[]> data;
+        uint64_t deviceAddress = 0;
+
+        NullBuffer(NullDevice *device, const RenderBufferDesc &desc);
+        ~NullBuffer() override;
+        void *map(uint32_t subresource, const RenderRange *readRange) override;
+        void unmap(uint32_t subresource, const RenderRange *writtenRange) override;
+        std::unique_ptr<RenderBufferFormattedView> createBufferFormattedView(RenderFormat format) override;
+        void setName(const std::string &name) override;
+        uint64_t getDeviceAddress() const override;
+    };
+
+    struct NullBufferFormattedView : RenderBufferFormattedView {
+        NullTracked<NullResourceType::BufferFormattedView> tracked;
+        NullBuffer *buffer = nullptr;
+        RenderFormat format = RenderFormat::UNKNOWN;
+
+        NullBufferFormattedView(NullBuffer *buffer, RenderFormat format);
+    };
+
+    struct NullTexture : RenderTexture {
+        NullTracked<NullResourceType::Texture> tracked;
+        RenderTextureDesc desc;
+
+        NullTexture() = default;
+        NullTexture(const RenderTextureDesc &desc);
+        std::unique_ptr<RenderTextureView> createTextureView(const RenderTextureViewDesc &desc) const override;
+        void setName(const std::string &name) override;
+    };
+
+    struct NullTextureView : RenderTextureView {
+        NullTracked<NullResourceType::TextureView> tracked;
+        const NullTexture *texture = nullptr;
+        RenderTextureViewDesc desc;
+
+        NullTextureView(const NullTexture *texture, const RenderTextureViewDesc &desc);
+    };
+
+    struct NullAccelerationStructure : RenderAccelerationStructure {
+        NullTracked<NullResourceType::AccelerationStructure> tracked;
+        RenderAccelerationStructureType type = RenderAccelerationStructureType::UNKNOWN;
+
+        NullAccelerationStructure(const RenderAccelerationStructureDesc &desc);
+    };
+
+    struct NullPipelineLayout : RenderPipelineLayout {
+        NullTracked<NullResourceType::PipelineLayout> tracked;
+    };
+
+    struct NullShader : RenderShader {
+        NullTracked<NullResourceType::Shader> tracked;
+        RenderShaderFormat format = RenderShaderFormat::UNKNOWN;
+        uint64_t size = 0;
+
+        NullShader(uint64_t size, RenderShaderFormat format);
+        void setName(const std::string &name) override;
+    };
+
+    struct NullSampler : RenderSampler {
+        NullTracked<NullResourceType::Sampler> tracked;
+        RenderSamplerDesc desc;
+
+        NullSampler(const RenderSamplerDesc &desc);
+    };
+
+    struct NullPipeline : RenderPipeline {
+        NullTracked<NullResourceType::Pipeline> tracked;
+
+        void setName(const std::string &name) override;
+        RenderPipelineProgram getProgram(const std::string &name) const override;
+    };
+
+    struct NullDescriptorSet : RenderDescriptorSet {
+        NullTracked<NullResourceType::DescriptorSet> tracked;
+        uint64_t updateCount = 0;
+
+        void setBuffer(uint32_t descriptorIndex, const RenderBuffer *buffer, uint64_t bufferSize, const RenderBufferStructuredView *bufferStructuredView, const RenderBufferFormattedView *bufferFormattedView) override;
+        void setTexture(uint32_t descriptorIndex, const RenderTexture *texture, RenderTextureLayout textureLayout, const RenderTextureView *textureView) override;
+        void setSampler(uint32_t descriptorIndex, const RenderSampler *sampler) override;
+        void setAccelerationStructure(uint32_t descriptorIndex, const RenderAccelerationStructure *accelerationStructure) override;
+    };
+
+    struct NullSwapChain : RenderSwapChain {
+        static constexpr uint32_t WIDTH = 1280;
+        static constexpr uint32_t HEIGHT = 720;
+
+        NullTracked<NullResourceType::SwapChain> tracked;
+        RenderWindow renderWindow = {};
+        std::vector<NullTexture> textures;
+        uint32_t nextTextureIndex = 0;
+        bool vsyncEnabled = false;
+
+        NullSwapChain(RenderWindow renderWindow, uint32_t textureCount, RenderFormat format);
+        bool present(uint32_t textureIndex, RenderCommandSemaphore **waitSemaphores, uint32_t waitSemaphoreCount) override;
+        void wait() override;
+        bool resize() override;
+        bool needsResize() const override;
+        void setVsyncEnabled(bool vsyncEnabled) override;
+        bool isVsyncEnabled() const override;
+        uint32_t getWidth() const override;
+        uint32_t getHeight() const override;
+        RenderTexture *getTexture(uint32_t textureIndex) override;
+        uint32_t getTextureCount() const override;
+        bool acquireTexture(RenderCommandSemaphore *signalSemaphore, uint32_t *textureIndex) override;
+        RenderWindow getWindow() const override;
+        bool isEmpty() const override;
+        uint32_t getRefreshRate() const override;
+    };
+
+    struct NullFramebuffer : RenderFramebuffer {
+        NullTracked<NullResourceType::Framebuffer> tracked;
+        uint32_t width = 0;
+        uint32_t height = 0;
+
+        NullFramebuffer(const RenderFramebufferDesc &desc);
+        uint32_t getWidth() const override;
+        uint32_t getHeight() const override;
+    };
+
+    struct NullQueryPool : RenderQueryPool {
+        NullTracked<NullResourceType::QueryPool> tracked;
+        std::vector<uint64_t> results;
+
+        NullQueryPool(uint32_t queryCount);
+        void queryResults() override;
+        const uint64_t *getResults() const override;
+        uint32_t getCount() const override;
+    };
+
+    struct NullCommandList : RenderCommandList {
+        NullTracked<NullResourceType::CommandList> tracked;
+        NullCommandStats stats;
+        bool recording = false;
+
+        void begin() override;
+        void end() override;
+        void barriers(RenderBarrierStages stages, const RenderBufferBarrier *bufferBarriers, uint32_t bufferBarriersCount, const RenderTextureBarrier *textureBarriers, uint32_t textureBarriersCount) override;
+        void dispatch(uint32_t threadGroupCountX, uint32_t threadGroupCountY, uint32_t threadGroupCountZ) override;
+        void traceRays(uint32_t width, uint32_t height, uint32_t depth, RenderBufferReference shaderBindingTable, const RenderShaderBindingGroupsInfo &shaderBindingGroupsInfo) override;
+        void drawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation) override;
+        void drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation) override;
+        void setPipeline(const RenderPipeline *pipeline) override;
+        void setComputePipelineLayout(const RenderPipelineLayout *pipelineLayout) override;
+        void setComputePushConstants(uint32_t rangeIndex, const void *data, uint32_t offset = 0, uint32_t size = 0) override;
+        void setComputeDescriptorSet(RenderDescriptorSet *descriptorSet, uint32_t setIndex) override;
+        void setGraphicsPipelineLayout(const RenderPipelineLayout *pipelineLayout) override;
+        void setGraphicsPushConstants(uint32_t rangeIndex, const void *data, uint32_t offset = 0, uint32_t size = 0) override;
+        void setGraphicsDescriptorSet(RenderDescriptorSet *descriptorSet, uint32_t setIndex) override;
+        void setGraphicsRootDescriptor(RenderBufferReference bufferReference, uint32_t rootDescriptorIndex) override;
+        void setRaytracingPipelineLayout(const RenderPipelineLayout *pipelineLayout) override;
+        void setRaytracingPushConstants(uint32_t rangeIndex, const void *data, uint32_t offset = 0, uint32_t size = 0) override;
+        void setRaytracingDescriptorSet(RenderDescriptorSet *descriptorSet, uint32_t setIndex) override;
+        void setIndexBuffer(const RenderIndexBufferView *view) override;
+        void setVertexBuffers(uint32_t startSlot, const RenderVertexBufferView *views, uint32_t viewCount, const RenderInputSlot *inputSlots) override;
+        void setViewports(const RenderViewport *viewports, uint32_t count) override;
+        void setScissors(const RenderRect *scissorRects, uint32_t count) override;
+        void setFramebuffer(const RenderFramebuffer *framebuffer) override;
+        void setDepthBias(float depthBias, float depthBiasClamp, float slopeScaledDepthBias) override;
+        void clearColor(uint32_t attachmentIndex, RenderColor colorValue, const RenderRect *clearRects, uint32_t clearRectsCount) override;
+        void clearDepthStencil(bool clearDepth, bool clearStencil, float depthValue, uint32_t stencilValue, const RenderRect *clearRects, uint32_t clearRectsCount) override;
+        void copyBufferRegion(RenderBufferReference dstBuffer, RenderBufferReference srcBuffer, uint64_t size) override;
+        void copyTextureRegion(const RenderTextureCopyLocation &dstLocation, const RenderTextureCopyLocation &srcLocation, uint32_t dstX, uint32_t dstY, uint32_t dstZ, const RenderBox *srcBox) override;
+        void copyBuffer(const RenderBuffer *dstBuffer, const RenderBuffer *srcBuffer) override;
+        void copyTexture(const RenderTexture *dstTexture, const RenderTexture *srcTexture) override;
+        void resolveTexture(const RenderTexture *dstTexture, const RenderTexture *srcTexture) override;
+        void resolveTextureRegion(const RenderTexture *dstTexture, uint32_t dstX, uint32_t dstY, const RenderTexture *srcTexture, const RenderRect *srcRect, RenderResolveMode resolveMode) override;
+        void buildBottomLevelAS(const RenderAccelerationStructure *dstAccelerationStructure, RenderBufferReference scratchBuffer, const RenderBottomLevelASBuildInfo &buildInfo) override;
+        void buildTopLevelAS(const RenderAccelerationStructure *dstAccelerationStructure, RenderBufferReference scratchBuffer, RenderBufferReference instancesBuffer, const RenderTopLevelASBuildInfo &buildInfo) override;
+        void discardTexture(const RenderTexture* texture) override;
+        void resetQueryPool(const RenderQueryPool *queryPool, uint32_t queryFirstIndex, uint32_t queryCount) override;
+        void writeTimestamp(const RenderQueryPool *queryPool, uint32_t queryIndex) override;
+    };
+
+    struct NullCommandFence : RenderCommandFence {
+        NullTracked<NullResourceType::CommandFence> tracked;
+    };
+
+    struct NullCommandSemaphore : RenderCommandSemaphore {
+        NullTracked<NullResourceType::CommandSemaphore> tracked;
+    };
+
+    struct NullCommandQueue : RenderCommandQueue {
+        NullTracked<NullResourceType::CommandQueue> tracked;
+        RenderCommandListType type = RenderCommandListType::UNKNOWN;
+
+        NullCommandQueue(RenderCommandListType type);
+        std::unique_ptr<RenderCommandList> createCommandList() override;
+        std::unique_ptr<RenderSwapChain> createSwapChain(RenderWindow renderWindow, uint32_t bufferCount, RenderFormat format, uint32_t maxFrameLatency) override;
+        void executeCommandLists(const RenderCommandList **commandLists, uint32_t commandListCount, RenderCommandSemaphore **waitSemaphores, uint32_t waitSemaphoreCount, RenderCommandSemaphore **signalSemaphores, uint32_t signalSemaphoreCount, RenderCommandFence *signalFence) override;
+        void waitForCommandFence(RenderCommandFence *fence) override;
+    };
+
+    struct NullPool : RenderPool {
+        NullTracked<NullResourceType::Pool> tracked;
+        NullDevice *device = nullptr;
+
+        NullPool(NullDevice *device);
+        std::unique_ptr<RenderBuffer> createBuffer(const RenderBufferDesc &desc) override;
+        std::unique_ptr<RenderTexture> createTexture(const RenderTextureDesc &desc) override;
+    };
+
+    struct NullDevice : RenderDevice {
+        RenderDeviceCapabilities capabilities;
+        RenderDeviceDescription description;
+        std::atomic<uint64_t> nextDeviceAddress = 0x10000;
+
+        NullDevice();
+        std::unique_ptr<RenderDescriptorSet> createDescriptorSet(const RenderDescriptorSetDesc &desc) override;
+        std::unique_ptr<RenderShader> createShader(const void *data, uint64_t size, const char *entryPointName, RenderShaderFormat format) override;
+        std::unique_ptr<RenderSampler> createSampler(const RenderSamplerDesc &desc) override;
+        std::unique_ptr<RenderPipeline> createComputePipeline(const RenderComputePipelineDesc &desc) override;
+        std::unique_ptr<RenderPipeline> createGraphicsPipeline(const RenderGraphicsPipelineDesc &desc) override;
+        std::unique_ptr<RenderPipeline> createRaytracingPipeline(const RenderRaytracingPipelineDesc &desc, const RenderPipeline *previousPipeline) override;
+        std::unique_ptr<RenderCommandQueue> createCommandQueue(RenderCommandListType type) override;
+        std::unique_ptr<RenderBuffer> createBuffer(const RenderBufferDesc &desc) override;
+        std::unique_ptr<RenderTexture> createTexture(const RenderTextureDesc &desc) override;
+        std::unique_ptr<RenderAccelerationStructure> createAccelerationStructure(const RenderAccelerationStructureDesc &desc) override;
+        std::unique_ptr<RenderPool> createPool(const RenderPoolDesc &desc) override;
+        std::unique_ptr<RenderPipelineLayout> createPipelineLayout(const RenderPipelineLayoutDesc &desc) override;
+        std::unique_ptr<RenderCommandFence> createCommandFence() override;
+        std::unique_ptr<RenderCommandSemaphore> createCommandSemaphore() override;
+        std::unique_ptr<RenderFramebuffer> createFramebuffer(const RenderFramebufferDesc &desc) override;
+        std::unique_ptr<RenderQueryPool> createQueryPool(uint32_t queryCount) override;
+        void setBottomLevelASBuildInfo(RenderBottomLevelASBuildInfo &buildInfo, const RenderBottomLevelASMesh *meshes, uint32_t meshCount, bool preferFastBuild, bool preferFastTrace) override;
+        void setTopLevelASBuildInfo(RenderTopLevelASBuildInfo &buildInfo, const RenderTopLevelASInstance *instances, uint32_t instanceCount, bool preferFastBuild, bool preferFastTrace) override;
+        void setShaderBindingTableInfo(RenderShaderBindingTableInfo &tableInfo, const RenderShaderBindingGroups &groups, const RenderPipeline *pipeline, RenderDescriptorSet **descriptorSets, uint32_t descriptorSetCount) override;
+        const RenderDeviceCapabilities &getCapabilities() const override;
+        const RenderDeviceDescription &getDescription() const override;
+        RenderSampleCounts getSampleCountsSupported(RenderFormat format) const override;
+        bool beginCapture() override;
+        bool endCapture() override;
+    };
+
+    struct NullInterface : RenderInterface {
+        RenderInterfaceCapabilities capabilities;
+        std::vector<std::string> deviceNames;
+
+        NullInterface();
+        std::unique_ptr<RenderDevice> createDevice(const std::string &preferredDeviceName) override;
+        const RenderInterfaceCapabilities &getCapabilities() const override;
+        const std::vector<std::string> &getDeviceNames() const override;
+    };
+
+    extern std::unique_ptr<RenderInterface> CreateNullInterface();
+};
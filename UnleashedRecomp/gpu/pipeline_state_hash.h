@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Hash of a trivially copyable struct that can be kept up to date one field at a time. The struct is
+// split into 8 byte words that get hashed separately and summed, so a field change only rehashes the
+// words it covers instead of the whole struct. Padding has to be zeroed or packed away by the caller.
+template<typename T>
+struct IncrementalStateHash
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    static constexpr size_t WORD_COUNT = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    uint64_t wordHashes[WORD_COUNT]{};
+    uint64_t hash = 0;
+
+    IncrementalStateHash() = default;
+
+    explicit IncrementalStateHash(const T& state)
+    {
+        Reset(state);
+    }
+
+    // Murmur3 finalizer, with the word index mixed in so equal words in different places don't cancel out.
+    static uint64_t HashWord(uint64_t word, size_t index)
+    {
+        word ^= (index + 1) * 0x9E3779B97F4A7C15ull;
+        word ^= word >> 33;
+        word *= 0xFF51AFD7ED558CCDull;
+        word ^= word >> 33;
+        word *= 0xC4CEB9FE1A85EC53ull;
+        word ^= word >> 33;
+        return word;
+    }
+
+    static uint64_t LoadWord(const T& state, size_t index)
+    {
+        uint64_t word = 0;
+        size_t offset = index * sizeof(uint64_t);
+        size_t size = sizeof(T) - offset < sizeof(uint64_t) ? sizeof(T) - offset : sizeof(uint64_t);
+        memcpy(&word, reinterpret_cast<const uint8_t*>(&state) + offset, size);
+        return word;
+    }
+
+    void UpdateWord(const T& state, size_t index)
+    {
+        uint64_t wordHash = HashWord(LoadWord(state, index), index);
+        hash += wordHash - wordHashes[index];
+        wordHashes[index] = wordHash;
+    }
+
+    void Reset(const T& state)
+    {
+        hash = 0;
+
+        for (size_t i = 0; i < WORD_COUNT; i++)
+        {
+            wordHashes[i] = HashWord(LoadWord(state, i), i);
+            hash += wordHashes[i];
+        }
+    }
+
+    // Call after changing the bytes in [offset, offset + size) of the state.
+    void Update(const T& state, size_t offset, size_t size)
+    {
+        size_t last = (offset + size - 1) / sizeof(uint64_t);
+        for (size_t i = offset / sizeof(uint64_t); i <= last; i++)
+            UpdateWord(state, i);
+    }
+
+    uint64_t Get() const
+    {
+        return hash;
+    }
+};
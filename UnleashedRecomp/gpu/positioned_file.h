@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// File read and written at explicit offsets, so several threads can access it at once
+// without sharing a file pointer.
+struct PositionedFile
+{
+#ifdef _WIN32
+    HANDLE handle = INVALID_HANDLE_VALUE;
+#else
+    int fd = -1;
+#endif
+
+    PositionedFile() = default;
+    PositionedFile(const PositionedFile&) = delete;
+    PositionedFile& operator=(const PositionedFile&) = delete;
+
+    ~PositionedFile()
+    {
+        Close();
+    }
+
+    // Opens an existing file, or creates an empty one when creating.
+    bool Open(const std::filesystem::path& path, bool create)
+    {
+        Close();
+
+#ifdef _WIN32
+        handle = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+            create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+#else
+        fd = open(path.c_str(), create ? (O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC) : (O_RDWR | O_CLOEXEC), 0644);
+#endif
+
+        return IsOpen();
+    }
+
+    bool IsOpen() const
+    {
+#ifdef _WIN32
+        return handle != INVALID_HANDLE_VALUE;
+#else
+        return fd != -1;
+#endif
+    }
+
+    void Close()
+    {
+        if (!IsOpen())
+            return;
+
+#ifdef _WIN32
+        CloseHandle(handle);
+        handle = INVALID_HANDLE_VALUE;
+#else
+        close(fd);
+        fd = -1;
+#endif
+    }
+
+    bool ReadAt(void* data, size_t size, uint64_t offset) const
+    {
+        auto bytes = reinterpret_cast<uint8_t*>(data);
+        while (size > 0)
+        {
+#ifdef _WIN32
+            OVERLAPPED overlapped{};
+            overlapped.Offset = DWORD(offset);
+            overlapped.OffsetHigh = DWORD(offset >> 32);
+
+            DWORD result = 0;
+            if (!ReadFile(handle, bytes, DWORD(std::min<size_t>(size, 0x40000000)), &result, &overlapped) || result == 0)
+                return false;
+#else
+            ssize_t result = pread(fd, bytes, size, off_t(offset));
+            if (result <= 0)
+                return false;
+#endif
+
+            bytes += result;
+            size -= size_t(result);
+            offset += uint64_t(result);
+        }
+
+        return true;
+    }
+
+    bool WriteAt(const void* data, size_t size, uint64_t offset) const
+    {
+        auto bytes = reinterpret_cast<const uint8_t*>(data);
+        while (size > 0)
+        {
+#ifdef _WIN32
+            OVERLAPPED overlapped{};
+            overlapped.Offset = DWORD(offset);
+            overlapped.OffsetHigh = DWORD(offset >> 32);
+
+            DWORD result = 0;
+            if (!WriteFile(handle, bytes, DWORD(std::min<size_t>(size, 0x40000000)), &result, &overlapped) || result == 0)
+                return false;
+#else
+            ssize_t result = pwrite(fd, bytes, size, off_t(offset));
+            if (result <= 0)
+                return false;
+#endif
+
+            bytes += result;
+            size -= size_t(result);
+            offset += uint64_t(result);
+        }
+
+        return true;
+    }
+
+    bool Truncate(uint64_t size) const
+    {
+#ifdef _WIN32
+        FILE_END_OF_FILE_INFO info{};
+        info.EndOfFile.QuadPart = LONGLONG(size);
+        return SetFileInformationByHandle(handle, FileEndOfFileInfo, &info, sizeof(info)) != FALSE;
+#else
+        return ftruncate(fd, off_t(size)) == 0;
+#endif
+    }
+};
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <unordered_set>
+#include <vector>
+
+// Serialized stream of render commands that can be fed back into the render thread later.
+// The file is a header followed by records, each record being a small header and its payload.
+// Commands are stored as raw RenderCommand structs with the guest object pointers kept as IDs,
+// every object gets described once before the first command that references it. Data the
+// commands point to (shader constants, vertex data, buffer contents) follows as blob records.
+enum class RenderCaptureRecordKind : uint32_t
+{
+    Object,
+    Command,
+    Blob,
+    FrameEnd
+};
+
+struct RenderCaptureObject
+{
+    // Set when the object is the swap chain back buffer, which gets mapped to the one of the replaying device.
+    static constexpr uint32_t FLAG_BACK_BUFFER = 1 << 0;
+    static constexpr uint32_t FLAG_CUBE = 1 << 1;
+
+    uint64_t id;
+    uint64_t hash;
+    uint32_t resourceType;
+    uint32_t flags;
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;
+    uint32_t format;
+    uint32_t sampleCount;
+    uint32_t dataSize;
+};
+
+struct RenderCaptureWriter
+{
+    static constexpr uint32_t MAGIC = 0x30504352; // RCP0
+    static constexpr uint32_t VERSION = 1;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t commandSize;
+        uint32_t frameCount;
+    };
+
+    struct RecordHeader
+    {
+        RenderCaptureRecordKind kind;
+        uint32_t subtype;
+        uint32_t size;
+    };
+
+    FILE* file = nullptr;
+    uint32_t commandSize = 0;
+    uint32_t frameCount = 0;
+    uint64_t recordCount = 0;
+    std::unordered_set<uint64_t> objectIds;
+
+    ~RenderCaptureWriter()
+    {
+        Close();
+    }
+
+    bool Open(const std::filesystem::path& path, uint32_t commandSize)
+    {
+        Close();
+
+        file = fopen(path.string().c_str(), "wb");
+        if (file == nullptr)
+            return false;
+
+        this->commandSize = commandSize;
+        frameCount = 0;
+        recordCount = 0;
+        objectIds.clear();
+
+        Header header{ MAGIC, VERSION, commandSize, 0 };
+        return fwrite(&header, sizeof(header), 1, file) == 1;
+    }
+
+    bool IsOpen() const
+    {
+        return file != nullptr;
+    }
+
+    // Returns true if the object wasn't described yet, in which case the caller has to write it.
+    bool MarkObject(uint64_t id)
+    {
+        return id != 0 && objectIds.emplace(id).second;
+    }
+
+    void Write(RenderCaptureRecordKind kind, uint32_t subtype, const void* data, uint32_t size)
+    {
+        if (file == nullptr)
+            return;
+
+        RecordHeader record{ kind, subtype, size };
+        fwrite(&record, sizeof(record), 1, file);
+
+        if (size != 0)
+            fwrite(data, 1, size, file);
+
+        ++recordCount;
+    }
+
+    void WriteObject(const RenderCaptureObject& object, const void* data = nullptr)
+    {
+        if (file == nullptr)
+            return;
+
+        RecordHeader record{ RenderCaptureRecordKind::Object, object.resourceType, uint32_t(sizeof(object) + object.dataSize) };
+        fwrite(&record, sizeof(record), 1, file);
+        fwrite(&object, sizeof(object), 1, file);
+
+        if (object.dataSize != 0)
+            fwrite(data, 1, object.dataSize, file);
+
+        ++recordCount;
+    }
+
+    void EndFrame()
+    {
+        Write(RenderCaptureRecordKind::FrameEnd, 0, nullptr, 0);
+        ++frameCount;
+    }
+
+    bool Close()
+    {
+        if (file == nullptr)
+            return false;
+
+        // Patch the frame count now that it's known.
+        fseek(file, offsetof(Header, frameCount), SEEK_SET);
+        fwrite(&frameCount, sizeof(frameCount), 1, file);
+
+        bool result = ferror(file) == 0;
+        fclose(file);
+        file = nullptr;
+
+        return result;
+    }
+};
+
+struct RenderCaptureReader
+{
+    struct Record
+    {
+        RenderCaptureRecordKind kind;
+        uint32_t subtype;
+        uint32_t size;
+        const uint8_t* data;
+    };
+
+    std::vector<uint8_t> data;
+    RenderCaptureWriter::Header header{};
+    std::vector<Record> records;
+
+    bool Open(const std::filesystem::path& path, uint32_t commandSize)
+    {
+        data.clear();
+        records.clear();
+
+        FILE* file = fopen(path.string().c_str(), "rb");
+        if (file == nullptr)
+            return false;
+
+        fseek(file, 0, SEEK_END);
+        long fileSize = ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        if (fileSize > 0)
+        {
+            data.resize(size_t(fileSize));
+            data.resize(fread(data.data(), 1, data.size(), file));
+        }
+
+        fclose(file);
+
+        if (data.size() < sizeof(header))
+            return false;
+
+        memcpy(&header, data.data(), sizeof(header));
+
+        // Commands are raw structs, so captures only replay on a build with the same layout.
+        if (header.magic != RenderCaptureWriter::MAGIC || header.version != RenderCaptureWriter::VERSION || header.commandSize != commandSize)
+            return false;
+
+        size_t offset = sizeof(header);
+        while (offset + sizeof(RenderCaptureWriter::RecordHeader) <= data.size())
+        {
+            RenderCaptureWriter::RecordHeader recordHeader;
+            memcpy(&recordHeader, data.data() + offset, sizeof(recordHeader));
+            offset += sizeof(recordHeader);
+
+            // A capture that got cut off still replays up to the last complete record.
+            if (offset + recordHeader.size > data.size())
+                break;
+
+            records.push_back({ recordHeader.kind, recordHeader.subtype, recordHeader.size, data.data() + offset });
+            offset += recordHeader.size;
+        }
+
+        return true;
+    }
+};
+
+// Accumulates how long the render thread spends on each command type.
+struct RenderCommandTimings
+{
+    static constexpr size_t MAX_TYPES = 64;
+
+    struct Entry
+    {
+        uint64_t count = 0;
+        uint64_t totalNs = 0;
+        uint64_t minNs = UINT64_MAX;
+        uint64_t maxNs = 0;
+    };
+
+    Entry entries[MAX_TYPES];
+
+    void Add(uint32_t type, uint64_t durationNs)
+    {
+        auto& entry = entries[type % MAX_TYPES];
+        ++entry.count;
+        entry.totalNs += durationNs;
+        entry.minNs = std::min(entry.minNs, durationNs);
+        entry.maxNs = std::max(entry.maxNs, durationNs);
+    }
+
+    void Reset()
+    {
+        for (auto& entry : entries)
+            entry = {};
+    }
+
+    // Writes a table sorted by total time, getName maps a command type to a printable name.
+    template<typename TGetName>
+    void WriteReport(FILE* file, TGetName&& getName) const
+    {
+        std::vector<uint32_t> types;
+        uint64_t totalNs = 0;
+
+        for (uint32_t i = 0; i < MAX_TYPES; i++)
+        {
+            if (entries[i].count != 0)
+            {
+                types.push_back(i);
+                totalNs += entries[i].totalNs;
+            }
+        }
+
+        std::sort(types.begin(), types.end(), [&](uint32_t lhs, uint32_t rhs) { return entries[lhs].totalNs > entries[rhs].totalNs; });
+
+        fprintf(file, "%-36s %10s %12s %10s %10s %10s %7s\n", "Command", "Count", "Total (ms)", "Avg (us)", "Min (us)", "Max (us)", "%");
+
+        for (uint32_t type : types)
+        {
+            auto& entry = entries[type];
+            fprintf(file, "%-36s %10llu %12.3f %10.3f %10.3f %10.3f %6.2f%%\n",
+                getName(type),
+                (unsigned long long)entry.count,
+                double(entry.totalNs) / 1000000.0,
+                double(entry.totalNs) / double(entry.count) / 1000.0,
+                double(entry.minNs) / 1000.0,
+                double(entry.maxNs) / 1000.0,
+                totalNs != 0 ? double(entry.totalNs) * 100.0 / double(totalNs) : 0.0);
+        }
+
+        fprintf(file, "%-36s %10s %12.3f\n", "Total", "", double(totalNs) / 1000000.0);
+    }
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+// Attachments that a render pass overwrites in full before anything reads them, so whatever they held
+// before the pass doesn't need to be loaded. Tiled GPUs can then skip copying them from memory into
+// tile storage at the start of the pass.
+enum RenderPassDiscard : uint32_t
+{
+    RENDER_PASS_DISCARD_NONE = 0,
+    RENDER_PASS_DISCARD_COLOR = 1 << 0,
+    RENDER_PASS_DISCARD_DEPTH = 1 << 1,
+    RENDER_PASS_DISCARD_VARIANT_COUNT = 1 << 2
+};
+
+// Framebuffers for the same attachments that only differ in what the first render pass after binding
+// them discards. Indexed by the discarded attachments.
+template<typename TFramebuffer>
+struct FramebufferVariants
+{
+    std::array<std::unique_ptr<TFramebuffer>, RENDER_PASS_DISCARD_VARIANT_COUNT> variants;
+
+    // Picks the variant for a pass that's going to discard the given attachments. If one of the variants is
+    // bound already, its pass may have drawn into the attachments since, so that one stays bound instead of
+    // starting a new pass that'd throw those draws away.
+    uint32_t Select(const TFramebuffer* bound, uint32_t discard) const
+    {
+        if (bound != nullptr)
+        {
+            for (uint32_t i = 0; i < RENDER_PASS_DISCARD_VARIANT_COUNT; i++)
+            {
+                if (variants[i].get() == bound)
+                    return i;
+            }
+        }
+
+        return discard;
+    }
+
+    std::unique_ptr<TFramebuffer>& operator[](uint32_t discard)
+    {
+        return variants[discard];
+    }
+};
+
+// Attachments a clear covers entirely, with the flags of the guest clear call. Depth surfaces have
+// no stencil, so clearing depth is enough to overwrite all of it.
+inline uint32_t GetClearDiscard(bool hasRenderTarget, bool hasDepthStencil, bool clearTarget, bool clearDepth)
+{
+    uint32_t discard = RENDER_PASS_DISCARD_NONE;
+
+    if (hasRenderTarget && clearTarget)
+        discard |= RENDER_PASS_DISCARD_COLOR;
+
+    if (hasDepthStencil && clearDepth)
+        discard |= RENDER_PASS_DISCARD_DEPTH;
+
+    return discard;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Guest sampler state packed into the bits the host sampler is made from: the address modes and filters
+// from the fetch constant words and the anisotropy setting. Two states with the same key always turn into
+// the same sampler, so the key can stand in for the descriptor without building or hashing one.
+inline uint32_t PackSamplerKey(uint32_t data0, uint32_t data3, uint32_t data5, uint32_t maxAnisotropy)
+{
+    return ((data0 >> 10) & 0x1FF) |
+        (((data3 >> 19) & 0x3F) << 9) |
+        ((data5 & 0x3) << 15) |
+        ((maxAnisotropy & 0x1F) << 17);
+}
+
+// Interns sampler keys to compact IDs that index a preallocated descriptor table. Lookups are a multiply
+// and a short probe into a fixed open addressed table, with no allocation after construction. ID 0 is
+// reserved for the default sampler. Only meant to be used from the render thread.
+template<size_t Capacity>
+struct SamplerTable
+{
+    static_assert(Capacity <= 0x10000);
+
+    static constexpr uint16_t INVALID_ID = 0xFFFF;
+
+    // Kept at most half full so probes stay short.
+    static constexpr size_t SLOT_COUNT = Capacity * 2;
+    static_assert((SLOT_COUNT & (SLOT_COUNT - 1)) == 0);
+
+    static constexpr uint32_t EMPTY_KEY = ~0u;
+
+    uint32_t keys[SLOT_COUNT];
+    uint16_t ids[SLOT_COUNT]{};
+    uint32_t useCounts[Capacity]{};
+    uint32_t count = 1;
+    uint32_t lookupCount = 0;
+    uint32_t missCount = 0;
+
+    SamplerTable()
+    {
+        for (auto& key : keys)
+            key = EMPTY_KEY;
+    }
+
+    static size_t GetSlot(uint32_t key)
+    {
+        return size_t((key * 0x9E3779B1u) >> 16) & (SLOT_COUNT - 1);
+    }
+
+    // Returns the ID of the key, and whether it was assigned by this call, in which case the caller has to
+    // fill in the descriptor for it. Returns INVALID_ID when the table is full.
+    std::pair<uint16_t, bool> Intern(uint32_t key)
+    {
+        ++lookupCount;
+
+        for (size_t slot = GetSlot(key); ; slot = (slot + 1) & (SLOT_COUNT - 1))
+        {
+            if (keys[slot] == key)
+            {
+                ++useCounts[ids[slot]];
+                return { ids[slot], false };
+            }
+
+            if (keys[slot] == EMPTY_KEY)
+            {
+                if (count == Capacity)
+                    return { INVALID_ID, false };
+
+                ++missCount;
+
+                uint16_t id = uint16_t(count++);
+                keys[slot] = key;
+                ids[slot] = id;
+                useCounts[id] = 1;
+
+                return { id, true };
+            }
+        }
+    }
+};
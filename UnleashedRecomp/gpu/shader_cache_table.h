@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Lookups into the open addressed shader cache table XenosRecomp emits next to the cache entries.
+// The table is kept at most half full and indexed by the low bits of the hash, so a lookup usually
+// touches a single slot. Returns the entry index, or UINT32_MAX if the hash isn't in the cache.
+template<typename TSlot>
+inline uint32_t FindShaderCacheTableIndex(const TSlot* table, size_t mask, uint64_t hash)
+{
+    for (size_t slot = hash & mask; ; slot = (slot + 1) & mask)
+    {
+        if (table[slot].entryIndex == UINT32_MAX || table[slot].hash == hash)
+            return table[slot].entryIndex;
+    }
+}
+
+// Builds the same layout XenosRecomp emits, for hashes sorted the way the entries are.
+template<typename TSlot>
+inline std::vector<TSlot> BuildShaderCacheTable(const uint64_t* hashes, size_t hashCount)
+{
+    size_t tableSize = 1;
+    while (tableSize < hashCount * 2)
+        tableSize <<= 1;
+
+    std::vector<TSlot> table(tableSize, TSlot{ 0, UINT32_MAX });
+
+    for (size_t i = 0; i < hashCount; i++)
+    {
+        size_t slot = hashes[i] & (tableSize - 1);
+        while (table[slot].entryIndex != UINT32_MAX)
+            slot = (slot + 1) & (tableSize - 1);
+
+        table[slot] = TSlot{ hashes[i], uint32_t(i) };
+    }
+
+    return table;
+}
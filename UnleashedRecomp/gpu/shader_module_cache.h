@@ -0,0 +1,194 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <xxhash.h>
+
+#include "mutex.h"
+#include "positioned_file.h"
+
+// Persistent storage for shader modules that are ready to be handed to the device,
+// eg. decoded SPIR-V or linked DXIL. Entries are keyed by the shader hash and the
+// specialization constants baked into the module. The whole file gets discarded
+// when the build hash changes, so stale modules never survive an update.
+//
+// The mutex only guards the index and the append offset. Records are read and written
+// with positioned IO outside of it, so pipeline compiler threads don't wait on each
+// other's disk access. A record is only added to the index once it's fully written.
+//
+// Getting killed in the middle of that can leave a torn record, a gap or records written
+// after one that never made it. Every record carries the hash of its data, and opening
+// the file drops the first record that doesn't match together with everything after it.
+struct ShaderModuleCache
+{
+    static constexpr uint32_t MAGIC = 0x30434D53; // SMC0
+    static constexpr uint32_t VERSION = 2;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t buildHash;
+    };
+
+    struct RecordHeader
+    {
+        uint64_t shaderHash;
+        uint32_t specConstants;
+        uint32_t size;
+        uint64_t dataHash;
+    };
+
+    struct Entry
+    {
+        uint64_t offset;
+        uint32_t size;
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const std::pair<uint64_t, uint32_t>& key) const noexcept
+        {
+            return key.first ^ (uint64_t(key.second) * 0x9E3779B97F4A7C15ull);
+        }
+    };
+
+    Mutex mutex;
+    PositionedFile file;
+    std::unordered_map<std::pair<uint64_t, uint32_t>, Entry, KeyHash> entries;
+    uint64_t appendOffset = 0;
+    bool appendFailed = false;
+    std::atomic<uint32_t> hitCount = 0;
+    std::atomic<uint32_t> missCount = 0;
+
+    bool Open(const std::filesystem::path& path, uint64_t buildHash)
+    {
+        std::lock_guard lock(mutex);
+
+        file.Close();
+        entries.clear();
+        appendOffset = 0;
+        appendFailed = false;
+
+        std::error_code ec;
+        uint64_t fileSize = std::filesystem::exists(path, ec) ? std::filesystem::file_size(path, ec) : 0;
+
+        if (fileSize >= sizeof(Header))
+        {
+            Header header{};
+            if (file.Open(path, false) && file.ReadAt(&header, sizeof(header), 0) &&
+                header.magic == MAGIC && header.version == VERSION && header.buildHash == buildHash)
+            {
+                appendOffset = sizeof(Header);
+
+                RecordHeader record{};
+                std::vector<uint8_t> data;
+                while (appendOffset + sizeof(RecordHeader) <= fileSize && file.ReadAt(&record, sizeof(record), appendOffset))
+                {
+                    uint64_t dataOffset = appendOffset + sizeof(RecordHeader);
+
+                    // Stop at a record that got cut off or never got written, it'll be overwritten by the next store.
+                    if (dataOffset + record.size > fileSize)
+                        break;
+
+                    data.resize(record.size);
+                    if (!file.ReadAt(data.data(), data.size(), dataOffset) || XXH3_64bits(data.data(), data.size()) != record.dataHash)
+                        break;
+
+                    entries[{ record.shaderHash, record.specConstants }] = { dataOffset, record.size };
+                    appendOffset = dataOffset + record.size;
+                }
+
+                // Drop whatever follows the last intact record, stores write past it out of order.
+                if (appendOffset < fileSize && !file.Truncate(appendOffset))
+                    appendFailed = true;
+
+                return true;
+            }
+
+            file.Close();
+        }
+
+        // Missing, corrupted or outdated, start over.
+        entries.clear();
+        if (!file.Open(path, true))
+            return false;
+
+        Header header{ MAGIC, VERSION, buildHash };
+        if (!file.WriteAt(&header, sizeof(header), 0))
+        {
+            file.Close();
+            return false;
+        }
+
+        appendOffset = sizeof(Header);
+        return true;
+    }
+
+    bool Load(uint64_t shaderHash, uint32_t specConstants, std::vector<uint8_t>& data)
+    {
+        Entry entry;
+        {
+            std::lock_guard lock(mutex);
+
+            auto findResult = entries.find({ shaderHash, specConstants });
+            if (findResult == entries.end() || !file.IsOpen())
+            {
+                ++missCount;
+                return false;
+            }
+
+            entry = findResult->second;
+        }
+
+        data.resize(entry.size);
+
+        if (!file.ReadAt(data.data(), data.size(), entry.offset))
+        {
+            std::lock_guard lock(mutex);
+            entries.erase({ shaderHash, specConstants });
+            ++missCount;
+            return false;
+        }
+
+        ++hitCount;
+        return true;
+    }
+
+    void Store(uint64_t shaderHash, uint32_t specConstants, const void* data, size_t size)
+    {
+        uint64_t offset;
+        {
+            std::lock_guard lock(mutex);
+
+            if (!file.IsOpen() || appendFailed || size > UINT32_MAX || entries.contains({ shaderHash, specConstants }))
+                return;
+
+            // Reserve the space up front, so other stores can write next to this one at the same time.
+            offset = appendOffset;
+            appendOffset += sizeof(RecordHeader) + size;
+        }
+
+        RecordHeader record{ shaderHash, specConstants, uint32_t(size), XXH3_64bits(data, size) };
+
+        bool written = file.WriteAt(&record, sizeof(record), offset) &&
+            file.WriteAt(data, size, offset + sizeof(RecordHeader));
+
+        std::lock_guard lock(mutex);
+
+        // A partial record would break parsing everything after it, so stop appending. The file stays
+        // open, other threads may still be reading the records before it.
+        if (!written)
+        {
+            appendFailed = true;
+            return;
+        }
+
+        entries.emplace(std::make_pair(shaderHash, specConstants), Entry{ offset + sizeof(RecordHeader), uint32_t(size) });
+    }
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <plume_render_interface.h>
+
+// Finds the rows of a lockable texture that changed since its last upload. The guest lock doesn't
+// tell which region it's going to write, so the mapped memory gets compared against a copy of what
+// was uploaded last time. Comparing is much cheaper than uploading, and dynamic textures usually
+// only touch a handful of rows per lock. Textures that get mostly rewritten every time drop the copy
+// and upload in full.
+struct TextureDirtyRows
+{
+    struct Span
+    {
+        uint32_t firstRow;
+        uint32_t rowCount;
+        uint64_t uploadOffset;
+    };
+
+    // Clean gaps up to this many rows get uploaded along with the spans around them,
+    // a few redundant rows are cheaper than another copy command.
+    static constexpr uint32_t MERGE_DISTANCE = 4;
+
+    // Consecutive mostly dirty updates after which the copy is freed and comparing stops.
+    static constexpr uint32_t FULL_UPDATES_BEFORE_UNSHADOW = 8;
+
+    std::vector<uint8_t> uploadedData;
+    std::vector<Span> spans;
+    uint32_t fullUpdateCount = 0;
+    bool shadowed = true;
+
+    // Only rowSize bytes of each row are compared, the rest of the pitch is padding. Updates the copy
+    // to match the data, so the returned spans have to be uploaded before the next call. Once half the
+    // rows are dirty, the rest isn't compared and the whole slice is returned as one span.
+    const std::vector<Span>& Update(const uint8_t* data, uint32_t pitch, uint32_t rowSize, uint32_t rowCount)
+    {
+        spans.clear();
+
+        if (!shadowed)
+        {
+            spans.push_back({ 0, rowCount, 0 });
+            return spans;
+        }
+
+        size_t dataSize = size_t(pitch) * rowCount;
+        if (uploadedData.size() != dataSize)
+        {
+            uploadedData.assign(data, data + dataSize);
+            spans.push_back({ 0, rowCount, 0 });
+            return spans;
+        }
+
+        uint32_t dirtyRowCount = 0;
+        for (uint32_t i = 0; i < rowCount; i++)
+        {
+            size_t offset = size_t(i) * pitch;
+            if (memcmp(uploadedData.data() + offset, data + offset, rowSize) == 0)
+                continue;
+
+            if (++dirtyRowCount * 2 >= rowCount)
+                return UpdateAll(data, dataSize, rowCount);
+
+            memcpy(uploadedData.data() + offset, data + offset, rowSize);
+
+            if (!spans.empty() && i <= spans.back().firstRow + spans.back().rowCount + MERGE_DISTANCE)
+                spans.back().rowCount = i - spans.back().firstRow + 1;
+            else
+                spans.push_back({ i, 1, 0 });
+        }
+
+        fullUpdateCount = 0;
+        return spans;
+    }
+
+    const std::vector<Span>& UpdateAll(const uint8_t* data, size_t dataSize, uint32_t rowCount)
+    {
+        spans.clear();
+        spans.push_back({ 0, rowCount, 0 });
+
+        if (++fullUpdateCount >= FULL_UPDATES_BEFORE_UNSHADOW)
+        {
+            shadowed = false;
+            uploadedData.clear();
+            uploadedData.shrink_to_fit();
+        }
+        else
+        {
+            memcpy(uploadedData.data(), data, dataSize);
+        }
+
+        return spans;
+    }
+
+    // Packs the spans into one upload allocation, each starting at the placement alignment. Returns the allocation size.
+    uint64_t PlaceSpans(uint32_t pitch, uint32_t placementAlignment)
+    {
+        uint64_t size = 0;
+        for (auto& span : spans)
+        {
+            span.uploadOffset = (size + placementAlignment - 1) & ~uint64_t(placementAlignment - 1);
+            size = span.uploadOffset + uint64_t(pitch) * span.rowCount;
+        }
+
+        return size;
+    }
+};
+
+// Records one copy per placed span, from an upload allocation holding the rows at the same pitch as the source.
+inline void CopyTextureDirtyRows(plume::RenderCommandList* commandList, const plume::RenderTexture* texture, plume::RenderFormat format,
+    uint32_t width, uint32_t pitch, const std::vector<TextureDirtyRows::Span>& spans, const plume::RenderBuffer* buffer, uint64_t offset)
+{
+    for (auto& span : spans)
+    {
+        commandList->copyTextureRegion(
+            plume::RenderTextureCopyLocation::Subresource(texture, 0),
+            plume::RenderTextureCopyLocation::PlacedFootprint(buffer, format, width, span.rowCount, 1, pitch / plume::RenderFormatSize(format), offset + span.uploadOffset),
+            0, span.firstRow, 0);
+    }
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include <xxhash.h>
+
+// Texture data along with its content hash, which only gets computed the first time someone asks for it.
+// Everything that needs the hash of the same data shares one instance, so it's computed at most once.
+struct TextureIdentity
+{
+    const uint8_t* data;
+    size_t size;
+    bool blockCompressed = false; // Filled in by whoever parses the texture header.
+    std::optional<XXH64_hash_t> hash;
+
+    TextureIdentity(const uint8_t* data, size_t size)
+        : data(data), size(size)
+    {
+    }
+
+    XXH64_hash_t GetHash()
+    {
+        if (!hash.has_value())
+            hash = XXH3_64bits(data, size);
+
+        return *hash;
+    }
+};
+
+// Matches textures against known content hashes. Every fixup also carries a cheap precondition, and the hash
+// is only computed for textures that pass one of them. An exact size is rarely shared with any other texture,
+// so it should be used whenever the size is known. A minimum size and alignment only rules out small and
+// uncompressed textures, most block compressed ones still pass it. Entries are all added up front, after
+// which lookups are safe from any thread.
+template<typename TFixup>
+struct TextureFixupRegistry
+{
+    struct Entry
+    {
+        XXH64_hash_t hash;
+        size_t size;
+        size_t alignment;
+        TFixup fixup;
+    };
+
+    // Exact size matches, sorted by size then hash.
+    std::vector<Entry> exactEntries;
+
+    // Minimum size matches, sorted by hash. Only block compressed textures get checked against these.
+    std::vector<Entry> minimumEntries;
+    size_t minimumSize = SIZE_MAX;
+    size_t minimumAlignment = 1;
+
+    std::atomic<uint32_t> hashCount = 0;
+    std::atomic<uint32_t> skipCount = 0;
+
+    void Add(size_t size, XXH64_hash_t hash, TFixup fixup)
+    {
+        auto entry = Entry{ hash, size, 1, fixup };
+        exactEntries.insert(std::upper_bound(exactEntries.begin(), exactEntries.end(), entry, [](const Entry& lhs, const Entry& rhs)
+            {
+                return lhs.size != rhs.size ? lhs.size < rhs.size : lhs.hash < rhs.hash;
+            }), entry);
+    }
+
+    // The alignment has to be the same for every entry added this way.
+    void AddMinimumSize(size_t minSize, size_t alignment, XXH64_hash_t hash, TFixup fixup)
+    {
+        auto entry = Entry{ hash, minSize, alignment, fixup };
+        minimumEntries.insert(std::upper_bound(minimumEntries.begin(), minimumEntries.end(), entry, [](const Entry& lhs, const Entry& rhs)
+            {
+                return lhs.hash < rhs.hash;
+            }), entry);
+
+        minimumSize = std::min(minimumSize, minSize);
+        minimumAlignment = alignment;
+    }
+
+    bool IsCandidate(size_t size, bool blockCompressed) const
+    {
+        if (blockCompressed && size >= minimumSize && (size % minimumAlignment) == 0)
+            return true;
+
+        auto findResult = std::lower_bound(exactEntries.begin(), exactEntries.end(), size, [](const Entry& lhs, size_t rhs)
+            {
+                return lhs.size < rhs;
+            });
+
+        return findResult != exactEntries.end() && findResult->size == size;
+    }
+
+    const TFixup* Find(TextureIdentity& identity)
+    {
+        if (!IsCandidate(identity.size, identity.blockCompressed))
+        {
+            // Transcoding hashes the texture beforehand, only count the hashes that were actually avoided.
+            if (!identity.hash.has_value())
+                ++skipCount;
+
+            return nullptr;
+        }
+
+        if (!identity.hash.has_value())
+            ++hashCount;
+
+        XXH64_hash_t hash = identity.GetHash();
+
+        auto exactResult = std::lower_bound(exactEntries.begin(), exactEntries.end(), std::make_pair(identity.size, hash), [](const Entry& lhs, const std::pair<size_t, XXH64_hash_t>& rhs)
+            {
+                return lhs.size != rhs.first ? lhs.size < rhs.first : lhs.hash < rhs.second;
+            });
+
+        if (exactResult != exactEntries.end() && exactResult->size == identity.size && exactResult->hash == hash)
+            return &exactResult->fixup;
+
+        auto minimumResult = std::lower_bound(minimumEntries.begin(), minimumEntries.end(), hash, [](const Entry& lhs, XXH64_hash_t rhs)
+            {
+                return lhs.hash < rhs;
+            });
+
+        if (identity.blockCompressed && minimumResult != minimumEntries.end() && minimumResult->hash == hash && identity.size >= minimumResult->size)
+            return &minimumResult->fixup;
+
+        return nullptr;
+    }
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Size of a texture with all of its mip levels. Block compressed formats pass their block dimensions
+// and the bits per block, everything else passes a 1x1 block and the bits per pixel.
+inline uint64_t ComputeTextureMemorySize(uint32_t width, uint32_t height, uint32_t depth, uint32_t mipLevels, uint32_t arraySize,
+    uint32_t bitsPerPixelOrBlock, uint32_t blockWidth = 1, uint32_t blockHeight = 1)
+{
+    uint64_t size = 0;
+
+    for (uint32_t level = 0; level < mipLevels; level++)
+    {
+        uint64_t blocksX = (std::max(1u, width >> level) + blockWidth - 1) / blockWidth;
+        uint64_t blocksY = (std::max(1u, height >> level) + blockHeight - 1) / blockHeight;
+        size += (blocksX * blocksY * std::max(1u, depth >> level) * bitsPerPixelOrBlock + 7) / 8;
+    }
+
+    return size * arraySize;
+}
+
+// Keeps a tally of the device memory taken by tracked resources against a budget. Resources are
+// expected to stamp their own lastUsedFrame whenever they get bound, which keeps binding free of
+// any lookups. Not thread safe, callers lock around it.
+template<typename TResource>
+struct ResidencyTracker
+{
+    std::unordered_map<TResource*, uint64_t> sizes;
+    uint64_t usage = 0;
+    uint64_t peakUsage = 0;
+    uint64_t budget = 0;
+
+    uint32_t downgradeCount = 0;
+    uint64_t reclaimedBytes = 0;
+    uint32_t restoreCount = 0;
+
+    // Tracking an already tracked resource replaces its size.
+    void Track(TResource* resource, uint64_t size)
+    {
+        auto& trackedSize = sizes[resource];
+        usage = usage - trackedSize + size;
+        trackedSize = size;
+        peakUsage = std::max(peakUsage, usage);
+    }
+
+    void Untrack(TResource* resource)
+    {
+        auto findResult = sizes.find(resource);
+        if (findResult != sizes.end())
+        {
+            usage -= findResult->second;
+            sizes.erase(findResult);
+        }
+    }
+
+    // Records a resource being rebuilt at a smaller size.
+    void Shrink(TResource* resource, uint64_t size)
+    {
+        auto findResult = sizes.find(resource);
+        if (findResult != sizes.end() && size < findResult->second)
+        {
+            reclaimedBytes += findResult->second - size;
+            usage -= findResult->second - size;
+            findResult->second = size;
+            ++downgradeCount;
+        }
+    }
+
+    // Records a downgraded resource being rebuilt at its full size again.
+    void Restore(TResource* resource, uint64_t size)
+    {
+        auto findResult = sizes.find(resource);
+        if (findResult != sizes.end() && size > findResult->second)
+        {
+            usage += size - findResult->second;
+            findResult->second = size;
+            peakUsage = std::max(peakUsage, usage);
+            ++restoreCount;
+        }
+    }
+
+    uint64_t GetOverBudget() const
+    {
+        return (budget != 0 && usage > budget) ? (usage - budget) : 0;
+    }
+
+    // Returns resources that weren't used for at least minIdleFrames and pass the filter, least recently used first.
+    template<typename TFilter>
+    std::vector<TResource*> FindLeastRecentlyUsed(uint32_t currentFrame, uint32_t minIdleFrames, TFilter&& filter) const
+    {
+        std::vector<TResource*> candidates;
+
+        for (auto& [resource, size] : sizes)
+        {
+            if (currentFrame - resource->lastUsedFrame >= minIdleFrames && filter(resource))
+                candidates.push_back(resource);
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [&](TResource* lhs, TResource* rhs)
+            {
+                return (currentFrame - lhs->lastUsedFrame) > (currentFrame - rhs->lastUsedFrame);
+            });
+
+        return candidates;
+    }
+};
@@ -0,0 +1,530 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// CPU decoders for BC1-BC5 and encoders for the ETC2/EAC formats that replace them on devices without BC
+// support. Every BC format here has an ETC2/EAC counterpart with 4x4 blocks of the same size, so transcoding
+// maps blocks one to one and mip layouts carry over unchanged. The only exception is BC1 with punch-through
+// alpha, which goes to ETC2 RGBA8 and doubles in size.
+
+enum class TranscodeFormat
+{
+    BC1,
+    BC2,
+    BC3,
+    BC4,
+    BC5
+};
+
+enum class TranscodeTarget
+{
+    ETC2_RGB8,
+    ETC2_RGBA8,
+    EAC_R11,
+    EAC_RG11
+};
+
+inline size_t GetTranscodeBlockSize(TranscodeFormat format)
+{
+    return (format == TranscodeFormat::BC1 || format == TranscodeFormat::BC4) ? 8 : 16;
+}
+
+inline size_t GetTranscodeBlockSize(TranscodeTarget target)
+{
+    return (target == TranscodeTarget::ETC2_RGB8 || target == TranscodeTarget::EAC_R11) ? 8 : 16;
+}
+
+inline void DecodeBC1ColorBlock(const uint8_t* block, uint8_t* rgba, bool allowTransparency)
+{
+    uint16_t color0 = block[0] | (block[1] << 8);
+    uint16_t color1 = block[2] | (block[3] << 8);
+    uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (uint32_t(block[7]) << 24);
+
+    uint8_t palette[4][4];
+
+    auto expand = [](uint16_t color, uint8_t* dst)
+        {
+            uint32_t r = (color >> 11) & 0x1F;
+            uint32_t g = (color >> 5) & 0x3F;
+            uint32_t b = color & 0x1F;
+            dst[0] = uint8_t((r << 3) | (r >> 2));
+            dst[1] = uint8_t((g << 2) | (g >> 4));
+            dst[2] = uint8_t((b << 3) | (b >> 2));
+            dst[3] = 0xFF;
+        };
+
+    expand(color0, palette[0]);
+    expand(color1, palette[1]);
+
+    // BC2 and BC3 always interpolate four colors, only BC1 has the transparent mode.
+    if (color0 > color1 || !allowTransparency)
+    {
+        for (size_t i = 0; i < 3; i++)
+        {
+            palette[2][i] = uint8_t((2 * palette[0][i] + palette[1][i]) / 3);
+            palette[3][i] = uint8_t((palette[0][i] + 2 * palette[1][i]) / 3);
+        }
+
+        palette[2][3] = 0xFF;
+        palette[3][3] = 0xFF;
+    }
+    else
+    {
+        for (size_t i = 0; i < 3; i++)
+        {
+            palette[2][i] = uint8_t((palette[0][i] + palette[1][i]) / 2);
+            palette[3][i] = 0;
+        }
+
+        palette[2][3] = 0xFF;
+        palette[3][3] = 0;
+    }
+
+    for (size_t i = 0; i < 16; i++)
+        memcpy(rgba + i * 4, palette[(indices >> (i * 2)) & 0x3], 4);
+}
+
+// Also decodes BC3 alpha.
+inline void DecodeBC4Block(const uint8_t* block, uint8_t* values, size_t stride)
+{
+    uint32_t value0 = block[0];
+    uint32_t value1 = block[1];
+
+    uint8_t palette[8];
+    palette[0] = uint8_t(value0);
+    palette[1] = uint8_t(value1);
+
+    if (value0 > value1)
+    {
+        for (uint32_t i = 1; i < 7; i++)
+            palette[i + 1] = uint8_t(((7 - i) * value0 + i * value1) / 7);
+    }
+    else
+    {
+        for (uint32_t i = 1; i < 5; i++)
+            palette[i + 1] = uint8_t(((5 - i) * value0 + i * value1) / 5);
+
+        palette[6] = 0;
+        palette[7] = 0xFF;
+    }
+
+    uint64_t indices = 0;
+    for (size_t i = 0; i < 6; i++)
+        indices |= uint64_t(block[2 + i]) << (i * 8);
+
+    for (size_t i = 0; i < 16; i++)
+        values[i * stride] = palette[(indices >> (i * 3)) & 0x7];
+}
+
+inline void DecodeBC2AlphaBlock(const uint8_t* block, uint8_t* values, size_t stride)
+{
+    for (size_t i = 0; i < 16; i++)
+        values[i * stride] = uint8_t(((block[i / 2] >> ((i % 2) * 4)) & 0xF) * 17);
+}
+
+// Decodes a block into 16 RGBA8 pixels in row major order. Single and dual channel formats
+// fill the remaining channels like the GPU would sample them.
+inline void DecodeBCBlock(TranscodeFormat format, const uint8_t* block, uint8_t* rgba)
+{
+    switch (format)
+    {
+    case TranscodeFormat::BC1:
+        DecodeBC1ColorBlock(block, rgba, true);
+        break;
+
+    case TranscodeFormat::BC2:
+        DecodeBC1ColorBlock(block + 8, rgba, false);
+        DecodeBC2AlphaBlock(block, rgba + 3, 4);
+        break;
+
+    case TranscodeFormat::BC3:
+        DecodeBC1ColorBlock(block + 8, rgba, false);
+        DecodeBC4Block(block, rgba + 3, 4);
+        break;
+
+    case TranscodeFormat::BC4:
+        DecodeBC4Block(block, rgba, 4);
+        for (size_t i = 0; i < 16; i++)
+        {
+            rgba[i * 4 + 1] = 0;
+            rgba[i * 4 + 2] = 0;
+            rgba[i * 4 + 3] = 0xFF;
+        }
+        break;
+
+    case TranscodeFormat::BC5:
+        DecodeBC4Block(block, rgba, 4);
+        DecodeBC4Block(block + 8, rgba + 1, 4);
+        for (size_t i = 0; i < 16; i++)
+        {
+            rgba[i * 4 + 2] = 0;
+            rgba[i * 4 + 3] = 0xFF;
+        }
+        break;
+    }
+}
+
+inline constexpr int32_t ETC1_MODIFIER_TABLES[8][2] =
+{
+    { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 }
+};
+
+inline constexpr int32_t EAC_MODIFIER_TABLES[16][8] =
+{
+    { -3, -6, -9, -15, 2, 5, 8, 14 },
+    { -3, -7, -10, -13, 2, 6, 9, 12 },
+    { -2, -5, -8, -13, 1, 4, 7, 12 },
+    { -2, -4, -6, -13, 1, 3, 5, 12 },
+    { -3, -6, -8, -12, 2, 5, 7, 11 },
+    { -3, -7, -9, -11, 2, 6, 8, 10 },
+    { -4, -7, -8, -11, 3, 6, 7, 10 },
+    { -3, -5, -8, -11, 2, 4, 7, 10 },
+    { -2, -6, -8, -10, 1, 5, 7, 9 },
+    { -2, -5, -8, -10, 1, 4, 7, 9 },
+    { -2, -4, -8, -10, 1, 3, 7, 9 },
+    { -2, -5, -7, -10, 1, 4, 6, 9 },
+    { -3, -4, -7, -10, 2, 3, 6, 9 },
+    { -1, -2, -3, -10, 0, 1, 2, 9 },
+    { -4, -6, -8, -9, 3, 5, 7, 8 },
+    { -3, -5, -7, -9, 2, 4, 6, 8 }
+};
+
+// Fits the 8 pixels of a sub-block around a base color. Returns the squared error and fills in the table
+// and the 2 bit pixel indices, which ETC stores as sign and magnitude bits.
+inline uint32_t FitETC1SubBlock(const uint8_t* rgba, const uint8_t (&pixels)[8], const int32_t (&base)[3], uint32_t& bestTable, uint32_t (&bestIndices)[8])
+{
+    uint32_t bestError = UINT32_MAX;
+
+    for (uint32_t table = 0; table < 8; table++)
+    {
+        const int32_t modifiers[4] = { ETC1_MODIFIER_TABLES[table][0], ETC1_MODIFIER_TABLES[table][1], -ETC1_MODIFIER_TABLES[table][0], -ETC1_MODIFIER_TABLES[table][1] };
+
+        uint32_t error = 0;
+        uint32_t indices[8];
+
+        for (size_t i = 0; i < 8 && error < bestError; i++)
+        {
+            const uint8_t* pixel = rgba + pixels[i] * 4;
+            uint32_t bestPixelError = UINT32_MAX;
+
+            for (uint32_t index = 0; index < 4; index++)
+            {
+                uint32_t pixelError = 0;
+                for (size_t channel = 0; channel < 3; channel++)
+                {
+                    int32_t difference = std::clamp(base[channel] + modifiers[index], 0, 255) - pixel[channel];
+                    pixelError += uint32_t(difference * difference);
+                }
+
+                if (pixelError < bestPixelError)
+                {
+                    bestPixelError = pixelError;
+                    indices[i] = index;
+                }
+            }
+
+            error += bestPixelError;
+        }
+
+        if (error < bestError)
+        {
+            bestError = error;
+            bestTable = table;
+            memcpy(bestIndices, indices, sizeof(indices));
+        }
+    }
+
+    return bestError;
+}
+
+// Encodes 16 row major RGBA8 pixels as an ETC2 RGB8 block, ignoring alpha. Only uses the modes ETC1
+// already had, which are enough for the smooth colors BC1 can hold, and searches both sub-block
+// orientations and both base color encodings.
+inline void EncodeETC2RGBBlock(const uint8_t* rgba, uint8_t* block)
+{
+    uint64_t bestBits = 0;
+    uint32_t bestError = UINT32_MAX;
+
+    for (uint32_t flip = 0; flip < 2; flip++)
+    {
+        // Pixels are numbered column major in the index bits.
+        uint8_t subBlockPixels[2][8];
+        uint32_t subBlockIndices[2][8];
+
+        for (uint32_t subBlock = 0; subBlock < 2; subBlock++)
+        {
+            for (uint32_t i = 0; i < 8; i++)
+            {
+                uint32_t x = flip ? (i % 4) : (subBlock * 2 + i / 4);
+                uint32_t y = flip ? (subBlock * 2 + i / 4) : (i % 4);
+                subBlockPixels[subBlock][i] = uint8_t(y * 4 + x);
+            }
+        }
+
+        int32_t averages[2][3];
+        for (uint32_t subBlock = 0; subBlock < 2; subBlock++)
+        {
+            for (size_t channel = 0; channel < 3; channel++)
+            {
+                int32_t sum = 0;
+                for (size_t i = 0; i < 8; i++)
+                    sum += rgba[subBlockPixels[subBlock][i] * 4 + channel];
+
+                averages[subBlock][channel] = (sum + 4) / 8;
+            }
+        }
+
+        for (uint32_t differential = 0; differential < 2; differential++)
+        {
+            int32_t quantized[2][3];
+            int32_t bases[2][3];
+            bool representable = true;
+
+            for (uint32_t subBlock = 0; subBlock < 2; subBlock++)
+            {
+                for (size_t channel = 0; channel < 3; channel++)
+                {
+                    int32_t value = averages[subBlock][channel];
+
+                    if (differential)
+                    {
+                        quantized[subBlock][channel] = (value * 31 + 127) / 255;
+                        bases[subBlock][channel] = (quantized[subBlock][channel] << 3) | (quantized[subBlock][channel] >> 2);
+                    }
+                    else
+                    {
+                        quantized[subBlock][channel] = (value * 15 + 127) / 255;
+                        bases[subBlock][channel] = quantized[subBlock][channel] * 17;
+                    }
+                }
+            }
+
+            // Deltas out of range would be read back as one of the ETC2 modes.
+            if (differential)
+            {
+                for (size_t channel = 0; channel < 3; channel++)
+                {
+                    int32_t delta = quantized[1][channel] - quantized[0][channel];
+                    representable &= (delta >= -4 && delta <= 3);
+                }
+            }
+
+            if (!representable)
+                continue;
+
+            uint32_t tables[2];
+            uint32_t error = 0;
+
+            for (uint32_t subBlock = 0; subBlock < 2; subBlock++)
+                error += FitETC1SubBlock(rgba, subBlockPixels[subBlock], bases[subBlock], tables[subBlock], subBlockIndices[subBlock]);
+
+            if (error >= bestError)
+                continue;
+
+            bestError = error;
+
+            uint64_t bits = 0;
+            for (size_t channel = 0; channel < 3; channel++)
+            {
+                uint64_t channelBits;
+                if (differential)
+                    channelBits = (quantized[0][channel] << 3) | ((quantized[1][channel] - quantized[0][channel]) & 0x7);
+                else
+                    channelBits = (quantized[0][channel] << 4) | quantized[1][channel];
+
+                bits |= channelBits << (56 - channel * 8);
+            }
+
+            bits |= uint64_t((tables[0] << 5) | (tables[1] << 2) | (differential << 1) | flip) << 32;
+
+            for (uint32_t subBlock = 0; subBlock < 2; subBlock++)
+            {
+                for (size_t i = 0; i < 8; i++)
+                {
+                    uint32_t pixel = subBlockPixels[subBlock][i];
+                    uint32_t bitIndex = (pixel % 4) * 4 + (pixel / 4);
+                    uint32_t index = subBlockIndices[subBlock][i];
+
+                    // Indices 0 and 1 are the positive modifiers, 2 and 3 the negative ones.
+                    bits |= uint64_t(index >> 1) << (bitIndex + 16);
+                    bits |= uint64_t(index & 1) << bitIndex;
+                }
+            }
+
+            bestBits = bits;
+        }
+    }
+
+    for (size_t i = 0; i < 8; i++)
+        block[i] = uint8_t(bestBits >> (56 - i * 8));
+}
+
+// Encodes 16 row major values as an EAC block. The same block serves as ETC2 alpha and as an R11 channel,
+// which decodes it at a higher precision that stays within rounding of the 8 bit values.
+inline void EncodeEACBlock(const uint8_t* values, size_t stride, uint8_t* block)
+{
+    int32_t minValue = 255;
+    int32_t maxValue = 0;
+
+    for (size_t i = 0; i < 16; i++)
+    {
+        minValue = std::min<int32_t>(minValue, values[i * stride]);
+        maxValue = std::max<int32_t>(maxValue, values[i * stride]);
+    }
+
+    uint32_t bestError = UINT32_MAX;
+    uint64_t bestBits = 0;
+
+    for (uint32_t table = 0; table < 16; table++)
+    {
+        const auto& modifiers = EAC_MODIFIER_TABLES[table];
+        int32_t range = modifiers[7] - modifiers[3];
+        int32_t center = modifiers[7] + modifiers[3];
+        int32_t estimatedMultiplier = std::clamp((maxValue - minValue + range - 1) / range, 1, 15);
+
+        for (int32_t multiplier = std::max(1, estimatedMultiplier - 1); multiplier <= std::min(15, estimatedMultiplier + 1); multiplier++)
+        {
+            int32_t estimatedBase = std::clamp((minValue + maxValue - center * multiplier + 1) / 2, 0, 255);
+
+            for (int32_t base = std::max(0, estimatedBase - 1); base <= std::min(255, estimatedBase + 1); base++)
+            {
+                uint32_t error = 0;
+                uint64_t indexBits = 0;
+
+                for (size_t i = 0; i < 16 && error < bestError; i++)
+                {
+                    int32_t value = values[i * stride];
+                    uint32_t bestPixelError = UINT32_MAX;
+                    uint32_t bestIndex = 0;
+
+                    for (uint32_t index = 0; index < 8; index++)
+                    {
+                        int32_t difference = std::clamp(base + modifiers[index] * multiplier, 0, 255) - value;
+                        uint32_t pixelError = uint32_t(difference * difference);
+
+                        if (pixelError < bestPixelError)
+                        {
+                            bestPixelError = pixelError;
+                            bestIndex = index;
+                        }
+                    }
+
+                    // Column major, first pixel in the highest bits.
+                    uint32_t bitIndex = (i % 4) * 4 + (i / 4);
+                    indexBits |= uint64_t(bestIndex) << (45 - bitIndex * 3);
+                    error += bestPixelError;
+                }
+
+                if (error < bestError)
+                {
+                    bestError = error;
+                    bestBits = (uint64_t(base) << 56) | (uint64_t(multiplier) << 52) | (uint64_t(table) << 48) | indexBits;
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < 8; i++)
+        block[i] = uint8_t(bestBits >> (56 - i * 8));
+}
+
+// BC1 blocks only need alpha in the target format if one of them actually uses the transparent color.
+inline TranscodeTarget GetTranscodeTarget(TranscodeFormat format, const uint8_t* data, size_t blockCount)
+{
+    switch (format)
+    {
+    case TranscodeFormat::BC1:
+        for (size_t i = 0; i < blockCount; i++)
+        {
+            const uint8_t* block = data + i * 8;
+            uint16_t color0 = block[0] | (block[1] << 8);
+            uint16_t color1 = block[2] | (block[3] << 8);
+
+            if (color0 <= color1)
+            {
+                for (size_t j = 0; j < 16; j++)
+                {
+                    if (((block[4 + j / 4] >> ((j % 4) * 2)) & 0x3) == 0x3)
+                        return TranscodeTarget::ETC2_RGBA8;
+                }
+            }
+        }
+
+        return TranscodeTarget::ETC2_RGB8;
+
+    case TranscodeFormat::BC2:
+    case TranscodeFormat::BC3:
+        return TranscodeTarget::ETC2_RGBA8;
+
+    case TranscodeFormat::BC4:
+        return TranscodeTarget::EAC_R11;
+
+    default:
+        return TranscodeTarget::EAC_RG11;
+    }
+}
+
+inline void TranscodeBlock(TranscodeFormat format, TranscodeTarget target, const uint8_t* src, uint8_t* dst)
+{
+    uint8_t rgba[64];
+    DecodeBCBlock(format, src, rgba);
+
+    switch (target)
+    {
+    case TranscodeTarget::ETC2_RGB8:
+        EncodeETC2RGBBlock(rgba, dst);
+        break;
+
+    case TranscodeTarget::ETC2_RGBA8:
+        EncodeEACBlock(rgba + 3, 4, dst);
+        EncodeETC2RGBBlock(rgba, dst + 8);
+        break;
+
+    case TranscodeTarget::EAC_R11:
+        EncodeEACBlock(rgba, 4, dst);
+        break;
+
+    case TranscodeTarget::EAC_RG11:
+        EncodeEACBlock(rgba, 4, dst);
+        EncodeEACBlock(rgba + 1, 4, dst + 8);
+        break;
+    }
+}
+
+// Blocks are transcoded in order, so whole mip chains can be passed in at once.
+inline void TranscodeBlocks(TranscodeFormat format, TranscodeTarget target, const uint8_t* src, uint8_t* dst, size_t blockCount)
+{
+    size_t srcBlockSize = GetTranscodeBlockSize(format);
+    size_t dstBlockSize = GetTranscodeBlockSize(target);
+
+    for (size_t i = 0; i < blockCount; i++)
+        TranscodeBlock(format, target, src + i * srcBlockSize, dst + i * dstBlockSize);
+}
+
+// Decodes an image of width x height x depth pixels stored as blocks into tightly packed RGBA8.
+inline void DecodeBCImage(TranscodeFormat format, const uint8_t* src, uint32_t width, uint32_t height, uint32_t depth, uint8_t* dst)
+{
+    size_t blockSize = GetTranscodeBlockSize(format);
+    uint8_t rgba[64];
+
+    for (uint32_t z = 0; z < depth; z++)
+    {
+        for (uint32_t blockY = 0; blockY < height; blockY += 4)
+        {
+            for (uint32_t blockX = 0; blockX < width; blockX += 4)
+            {
+                DecodeBCBlock(format, src, rgba);
+                src += blockSize;
+
+                for (uint32_t y = 0; y < std::min(4u, height - blockY); y++)
+                {
+                    uint8_t* row = dst + ((size_t(z) * height + blockY + y) * width + blockX) * 4;
+                    memcpy(row, rgba + y * 16, std::min(4u, width - blockX) * 4);
+                }
+            }
+        }
+    }
+}
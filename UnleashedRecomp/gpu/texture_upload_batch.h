@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Threads decoding images for the texture loader. Decoding is CPU bound and independent per image, so it
+// scales with the cores, but half of them are left to the game, render and pipeline compiler threads.
+// A configured count of zero picks one from the hardware.
+inline uint32_t GetTextureDecodeThreadCount(uint32_t configuredCount, uint32_t hardwareConcurrency)
+{
+    if (configuredCount != 0)
+        return std::min(configuredCount, 64u);
+
+    return std::clamp(hardwareConcurrency / 2, 2u, 8u);
+}
+
+// Places decoded RGBA8 images back to back in a single upload buffer, so a batch of them can go to the GPU
+// with one copy submission instead of one per image.
+struct TextureUploadBatchLayout
+{
+    struct Image
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t rowPitch;
+        uint64_t offset;
+    };
+
+    uint32_t pitchAlignment;
+    uint32_t placementAlignment;
+    std::vector<Image> images;
+    uint64_t size = 0;
+
+    TextureUploadBatchLayout(uint32_t pitchAlignment, uint32_t placementAlignment)
+        : pitchAlignment(pitchAlignment), placementAlignment(placementAlignment)
+    {
+    }
+
+    // Refuses images that would take the batch past maxSize, except for the first one, which always fits
+    // so that an image bigger than the limit still gets uploaded on its own.
+    bool Add(uint32_t width, uint32_t height, uint64_t maxSize)
+    {
+        uint32_t rowPitch = (width * 4 + pitchAlignment - 1) & ~(pitchAlignment - 1);
+        uint64_t offset = (size + placementAlignment - 1) & ~uint64_t(placementAlignment - 1);
+        uint64_t newSize = offset + uint64_t(rowPitch) * height;
+
+        if (!images.empty() && newSize > maxSize)
+            return false;
+
+        images.push_back({ width, height, rowPitch, offset });
+        size = newSize;
+        return true;
+    }
+
+    void Clear()
+    {
+        images.clear();
+        size = 0;
+    }
+};
@@ -0,0 +1,93 @@
+#include "trace_profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+
+TraceRecorder g_traceRecorder;
+
+static void WriteJsonString(FILE* file, const char* str)
+{
+    fputc('"', file);
+
+    for (; *str != '\0'; str++)
+    {
+        switch (*str)
+        {
+        case '"':
+            fputs("\\\"", file);
+            break;
+        case '\\':
+            fputs("\\\\", file);
+            break;
+        default:
+            if (uint8_t(*str) >= 0x20)
+                fputc(*str, file);
+
+            break;
+        }
+    }
+
+    fputc('"', file);
+}
+
+bool TraceRecorder::WriteChromeTrace(const std::filesystem::path& path)
+{
+    FILE* file = fopen(path.string().c_str(), "wb");
+    if (file == nullptr)
+        return false;
+
+    uint64_t end = writeIndex.load();
+    uint64_t begin = end > CAPACITY ? end - CAPACITY : 0;
+
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+
+    bool first = true;
+
+    {
+        std::lock_guard lock(threadNameMutex);
+        for (auto& [threadId, threadName] : threadNames)
+        {
+            fprintf(file, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", first ? "" : ",", threadId);
+            WriteJsonString(file, threadName.c_str());
+            fputs("}}", file);
+            first = false;
+        }
+    }
+
+    for (uint64_t i = begin; i < end; i++)
+    {
+        auto& event = events[i % CAPACITY];
+
+        // Skip slots that are still being written or already got overwritten.
+        if (event.sequence.load(std::memory_order_acquire) != i + 1)
+            continue;
+
+        TraceEvent copy;
+        copy.name = event.name;
+        copy.category = event.category;
+        copy.startNs = event.startNs;
+        copy.durationNs = event.durationNs;
+        copy.threadId = event.threadId;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (event.sequence.load(std::memory_order_relaxed) != i + 1)
+            continue;
+
+        fprintf(file, "%s{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"name\":", first ? "" : ",",
+            copy.threadId, double(copy.startNs) / 1000.0, double(copy.durationNs) / 1000.0);
+
+        WriteJsonString(file, copy.name);
+        fputs(",\"cat\":", file);
+        WriteJsonString(file, copy.category);
+        fputc('}', file);
+
+        first = false;
+    }
+
+    fputs("]}", file);
+
+    bool result = ferror(file) == 0;
+    fclose(file);
+
+    return result;
+}
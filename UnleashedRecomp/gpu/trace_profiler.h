@@ -0,0 +1,147 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "mutex.h"
+
+// Lightweight timeline recorder. Scopes are written into a ring buffer from any thread
+// and can be dumped as Chrome trace JSON, which both chrome://tracing and Perfetto open.
+// Recording is off until enabled, disabled scopes only cost a relaxed load.
+struct TraceEvent
+{
+    std::atomic<uint64_t> sequence;
+    const char* name;
+    const char* category;
+    uint64_t startNs;
+    uint64_t durationNs;
+    uint32_t threadId;
+    uint32_t depth;
+};
+
+struct TraceRecorder
+{
+    static constexpr size_t CAPACITY = 1 << 16;
+
+    // Thread ID reserved for GPU timestamps, so they show up on their own track.
+    static constexpr uint32_t GPU_THREAD_ID = 0;
+
+    std::unique_ptr<TraceEvent[]> events = std::make_unique<TraceEvent[]>(CAPACITY);
+    std::atomic<uint64_t> writeIndex;
+    std::atomic<bool> enabled;
+    std::atomic<uint32_t> nextThreadId{ GPU_THREAD_ID + 1 };
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+    Mutex threadNameMutex;
+    std::vector<std::pair<uint32_t, std::string>> threadNames{ { GPU_THREAD_ID, "GPU" } };
+
+    bool IsEnabled() const
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    void SetEnabled(bool value)
+    {
+        enabled.store(value, std::memory_order_relaxed);
+    }
+
+    uint64_t Now() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    uint64_t ToTraceTime(std::chrono::steady_clock::time_point time) const
+    {
+        return time > epoch ? std::chrono::duration_cast<std::chrono::nanoseconds>(time - epoch).count() : 0;
+    }
+
+    uint32_t GetThreadId()
+    {
+        thread_local uint32_t s_threadId = nextThreadId++;
+        return s_threadId;
+    }
+
+    void SetThreadName(const char* name)
+    {
+        uint32_t threadId = GetThreadId();
+
+        std::lock_guard lock(threadNameMutex);
+        for (auto& [id, threadName] : threadNames)
+        {
+            if (id == threadId)
+            {
+                threadName = name;
+                return;
+            }
+        }
+
+        threadNames.emplace_back(threadId, name);
+    }
+
+    void Record(const char* name, const char* category, uint64_t startNs, uint64_t durationNs, uint32_t threadId, uint32_t depth)
+    {
+        uint64_t index = writeIndex++;
+        auto& event = events[index % CAPACITY];
+
+        // Mark the slot as being written, readers skip it until the sequence matches.
+        event.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        event.name = name;
+        event.category = category;
+        event.startNs = startNs;
+        event.durationNs = durationNs;
+        event.threadId = threadId;
+        event.depth = depth;
+
+        event.sequence.store(index + 1, std::memory_order_release);
+    }
+
+    bool WriteChromeTrace(const std::filesystem::path& path);
+};
+
+extern TraceRecorder g_traceRecorder;
+
+struct TraceScope
+{
+    const char* name;
+    const char* category;
+    uint64_t start = 0;
+    bool recording;
+
+    static uint32_t& Depth()
+    {
+        thread_local uint32_t s_depth;
+        return s_depth;
+    }
+
+    // Whether the scope records is decided once here, toggling recording never leaves the depth unbalanced.
+    TraceScope(const char* name, const char* category = "cpu")
+        : name(name), category(category), recording(g_traceRecorder.IsEnabled())
+    {
+        if (!recording)
+            return;
+
+        start = g_traceRecorder.Now();
+        ++Depth();
+    }
+
+    ~TraceScope()
+    {
+        if (!recording)
+            return;
+
+        uint32_t depth = --Depth();
+        g_traceRecorder.Record(name, category, start, g_traceRecorder.Now() - start, g_traceRecorder.GetThreadId(), depth);
+    }
+};
+
+#define TRACE_SCOPE_CONCAT_INNER(x, y) x##y
+#define TRACE_SCOPE_CONCAT(x, y) TRACE_SCOPE_CONCAT_INNER(x, y)
+#define TRACE_SCOPE(...) TraceScope TRACE_SCOPE_CONCAT(traceScope, __LINE__)(__VA_ARGS__)
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include <ankerl/unordered_dense.h>
+
+// A resource that only needs its memory between two points of a frame.
+struct TransientResource
+{
+    uint64_t size;
+    uint32_t firstUse;
+    uint32_t lastUse;
+    uint64_t offset = 0;
+};
+
+// Assigns heap offsets so that resources alive at the same time never share memory, while resources with
+// disjoint lifetimes can. Largest resources get placed first, each at the lowest aligned offset that fits
+// between the already placed resources it overlaps in time with. Returns the heap size, which is the peak
+// memory the resources need when aliased.
+inline uint64_t PlaceTransientResources(std::vector<TransientResource>& resources, uint64_t alignment)
+{
+    std::vector<size_t> order(resources.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) { return resources[lhs].size > resources[rhs].size; });
+
+    auto alignUp = [&](uint64_t value) { return (value + alignment - 1) & ~(alignment - 1); };
+
+    std::vector<size_t> placed;
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    uint64_t heapSize = 0;
+
+    for (size_t index : order)
+    {
+        auto& resource = resources[index];
+
+        ranges.clear();
+        for (size_t placedIndex : placed)
+        {
+            auto& other = resources[placedIndex];
+            if (resource.firstUse <= other.lastUse && other.firstUse <= resource.lastUse)
+                ranges.emplace_back(other.offset, other.offset + other.size);
+        }
+
+        std::sort(ranges.begin(), ranges.end());
+
+        uint64_t offset = 0;
+        for (auto& [begin, end] : ranges)
+        {
+            offset = alignUp(offset);
+            if (offset + resource.size <= begin)
+                break;
+
+            offset = std::max(offset, end);
+        }
+
+        resource.offset = alignUp(offset);
+        heapSize = std::max(heapSize, resource.offset + resource.size);
+        placed.push_back(index);
+    }
+
+    return heapSize;
+}
+
+// Records when each resource gets used within a frame, and places the ones that don't carry their contents
+// over to the next frame in a shared heap. A resource whose first use in a frame doesn't overwrite it (a draw
+// or a read instead of a clear) depends on what an earlier frame left in it, and stays out of the plan from
+// then on. Only meant to be used from the render thread.
+template<typename TKey>
+struct TransientLifetimeTracker
+{
+    struct Lifetime
+    {
+        uint64_t size = 0;
+        uint32_t frame = 0;
+        uint32_t firstUse = 0;
+        uint32_t lastUse = 0;
+        bool persistent = false;
+    };
+
+    struct Plan
+    {
+        uint64_t dedicatedSize = 0;
+        uint64_t aliasedSize = 0;
+        uint64_t transientHeapSize = 0;
+        uint32_t transientCount = 0;
+        uint32_t persistentCount = 0;
+    };
+
+    ankerl::unordered_dense::map<TKey, Lifetime> lifetimes;
+
+    // Placement of the last frame, the keys line up with the resources.
+    std::vector<TKey> keys;
+    std::vector<TransientResource> resources;
+
+    // Frames are counted from 1, so a zero frame means the resource was never used.
+    uint32_t frame = 1;
+    uint32_t useIndex = 0;
+
+    void Use(TKey key, uint64_t size, bool discardsContents)
+    {
+        auto& lifetime = lifetimes[key];
+        ++useIndex;
+
+        if (lifetime.frame != frame)
+        {
+            if (lifetime.frame != 0 && !discardsContents)
+                lifetime.persistent = true;
+
+            lifetime.frame = frame;
+            lifetime.firstUse = useIndex;
+        }
+
+        lifetime.size = size;
+        lifetime.lastUse = useIndex;
+    }
+
+    void Forget(TKey key)
+    {
+        lifetimes.erase(key);
+    }
+
+    // Checks a placement made from earlier frames against the uses of the current one, before it ends. It no longer
+    // holds once a placed resource turned out to be persistent, or placed resources sharing memory were in use at
+    // the same time.
+    bool IsPlacementValid(const std::vector<std::pair<TKey, TransientResource>>& placement) const
+    {
+        for (size_t i = 0; i < placement.size(); i++)
+        {
+            auto& [key, resource] = placement[i];
+            auto findResult = lifetimes.find(key);
+            if (findResult == lifetimes.end() || findResult->second.frame != frame)
+                continue;
+
+            auto& lifetime = findResult->second;
+            if (lifetime.persistent)
+                return false;
+
+            for (size_t j = i + 1; j < placement.size(); j++)
+            {
+                auto& [otherKey, otherResource] = placement[j];
+                auto otherFindResult = lifetimes.find(otherKey);
+                if (otherFindResult == lifetimes.end() || otherFindResult->second.frame != frame)
+                    continue;
+
+                auto& otherLifetime = otherFindResult->second;
+                bool timeOverlap = lifetime.firstUse <= otherLifetime.lastUse && otherLifetime.firstUse <= lifetime.lastUse;
+                bool memoryOverlap = resource.offset < otherResource.offset + otherResource.size && otherResource.offset < resource.offset + resource.size;
+
+                if (timeOverlap && memoryOverlap)
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Places the resources used during the current frame and moves on to the next one. Resources that are
+    // persistent or weren't used this frame keep their own memory.
+    Plan EndFrame(uint64_t alignment)
+    {
+        Plan plan;
+        keys.clear();
+        resources.clear();
+
+        for (auto& [key, lifetime] : lifetimes)
+        {
+            plan.dedicatedSize += lifetime.size;
+
+            if (lifetime.persistent || lifetime.frame != frame)
+            {
+                plan.aliasedSize += lifetime.size;
+                plan.persistentCount += lifetime.persistent;
+            }
+            else
+            {
+                keys.push_back(key);
+                resources.push_back({ lifetime.size, lifetime.firstUse, lifetime.lastUse });
+            }
+        }
+
+        plan.transientCount = uint32_t(resources.size());
+        plan.transientHeapSize = PlaceTransientResources(resources, alignment);
+        plan.aliasedSize += plan.transientHeapSize;
+
+        ++frame;
+        useIndex = 0;
+
+        return plan;
+    }
+};
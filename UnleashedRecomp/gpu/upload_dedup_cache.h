@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ankerl/unordered_dense.h>
+#include <xxhash.h>
+
+// Remembers what got uploaded through a frame's upload allocator by content hash, so an identical block
+// points at the memory of the previous upload instead of being copied again. Consecutive draws tend to
+// share their view, projection and lighting constants. It has to be reset alongside the allocator.
+template<typename TAllocation>
+struct UploadDedupCache
+{
+    ankerl::unordered_dense::map<XXH64_hash_t, TAllocation> allocations;
+
+    uint64_t hitCount = 0;
+    uint64_t missCount = 0;
+    uint64_t uploadedBytes = 0;
+    uint64_t savedBytes = 0;
+
+    // Calls upload only when no block with the same contents was uploaded since the last reset.
+    template<typename TUpload>
+    TAllocation Get(const void* data, size_t size, TUpload&& upload)
+    {
+        // The size goes into the seed, so blocks of different lengths with a common prefix don't collide.
+        XXH64_hash_t hash = XXH3_64bits_withSeed(data, size, size);
+
+        auto [it, inserted] = allocations.try_emplace(hash);
+        if (inserted)
+        {
+            it->second = upload();
+            ++missCount;
+            uploadedBytes += size;
+        }
+        else
+        {
+            ++hitCount;
+            savedBytes += size;
+        }
+
+        return it->second;
+    }
+
+    void Reset()
+    {
+        allocations.clear();
+    }
+
+    void ResetStats()
+    {
+        hitCount = 0;
+        missCount = 0;
+        uploadedBytes = 0;
+        savedBytes = 0;
+    }
+};
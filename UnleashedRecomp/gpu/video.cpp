@@ -3,6 +3,25 @@
 #include "video.h"
 
 #include "video_utils.h"
+#include "shader_module_cache.h"
+#include "lru_map.h"
+#include "trace_profiler.h"
+#include "null_render_interface.h"
+#include "render_capture.h"
+#include "barrier_batch.h"
+#include "upload_dedup_cache.h"
+#include "index_generation.h"
+#include "texture_residency.h"
+#include "descriptor_index_allocator.h"
+#include "frame_pacer.h"
+#include "pipeline_state_hash.h"
+#include "texture_upload_batch.h"
+#include "texture_transcoder.h"
+#include "texture_fixup_registry.h"
+#include "sampler_table.h"
+#include "concurrent_hash_registry.h"
+#include "shader_cache_table.h"
+#include "transient_resource_planner.h"
 using namespace plume;
 
 #ifdef __ANDROID__
@@ -42,9 +61,12 @@ using namespace plume;
 #endif
 #include <patches/aspect_ratio_patches.h>
 #include <user/config.h>
+#include <user/paths.h>
 #include <sdl_listener.h>
 #include <xxHashMap.h>
+#include <os/logger.h>
 #include <os/process.h>
+#include <version.h>
 
 #if defined(ASYNC_PSO_DEBUG) || defined(PSO_CACHING)
 #include <magic_enum/magic_enum.hpp>
@@ -161,7 +183,7 @@ static uint32_t g_vertexShaderConstants[0x400];
 static uint32_t g_pixelShaderConstants[0x380];
 static SharedConstants g_sharedConstants;
 static GuestTexture* g_textures[16];
-static RenderSamplerDesc g_samplerDescs[16];
+static uint32_t g_samplerKeys[16];
 static bool g_scissorTestEnable = false;
 static RenderRect g_scissorRect;
 static RenderVertexBufferView g_vertexBufferViews[16];
@@ -210,6 +232,20 @@ static void SetDirtyValue(bool& dirtyState, T& dest, const T& src)
     }
 }
 
+// Kept in sync with g_pipelineState field by field, so looking up the pipeline doesn't need to hash the whole state.
+static IncrementalStateHash<PipelineState> g_pipelineStateHash(g_pipelineState);
+
+template<typename T>
+static void SetPipelineStateValue(T& dest, const T& src)
+{
+    if (dest != src)
+    {
+        dest = src;
+        g_dirtyStates.pipelineState = true;
+        g_pipelineStateHash.Update(g_pipelineState, reinterpret_cast<uint8_t*>(&dest) - reinterpret_cast<uint8_t*>(&g_pipelineState), sizeof(T));
+    }
+}
+
 static constexpr size_t PROFILER_VALUE_COUNT = 256;
 static size_t g_profilerValueIndex;
 
@@ -256,6 +292,9 @@ static Profiler g_frameFenceProfiler;
 static Profiler g_presentWaitProfiler;
 static Profiler g_swapChainAcquireProfiler;
 
+// Only touched by the presenting thread, which also draws the profiler.
+static FramePacer g_framePacer;
+
 static bool g_profilerVisible;
 static bool g_profilerWasToggled;
 
@@ -267,12 +306,13 @@ static bool g_hardwareResolve = true;
 static bool g_hardwareDepthResolve = true;
 
 static std::unique_ptr<RenderInterface> g_interface;
+static bool g_nullRenderer;
 static std::unique_ptr<RenderDevice> g_device;
 
 static RenderDeviceCapabilities g_capabilities;
 
 static constexpr size_t NUM_FRAMES = 2;
-static constexpr size_t NUM_QUERIES = 2;
+static constexpr size_t NUM_QUERIES = 64;
 
 static uint32_t g_frame = 0;
 static uint32_t g_nextFrame = 1;
@@ -281,6 +321,9 @@ static std::unique_ptr<RenderCommandQueue> g_queue;
 static std::unique_ptr<RenderCommandList> g_commandLists[NUM_FRAMES];
 static std::unique_ptr<RenderCommandFence> g_commandFences[NUM_FRAMES];
 static std::unique_ptr<RenderQueryPool> g_queryPools[NUM_FRAMES];
+static const char* g_queryNames[NUM_FRAMES][NUM_QUERIES];
+static uint32_t g_queryCounts[NUM_FRAMES];
+static std::chrono::steady_clock::time_point g_querySubmitTimes[NUM_FRAMES];
 static bool g_commandListStates[NUM_FRAMES];
 
 static Mutex g_copyMutex;
@@ -317,47 +360,38 @@ enum
     TEXTURE_DESCRIPTOR_NULL_COUNT
 };
 
-struct TextureDescriptorAllocator
-{
-    Mutex mutex;
-    uint32_t capacity = TEXTURE_DESCRIPTOR_NULL_COUNT;
-    std::vector<uint32_t> freed;
-
-    uint32_t allocate()
-    {
-        std::lock_guard lock(mutex);
-
-        uint32_t value;
-        if (!freed.empty())
-        {
-            value = freed.back();
-            freed.pop_back();
-        }
-        else
-        {
-            value = capacity;
-            ++capacity;
-        }
-
-        return value;
-    }
-
-    void free(uint32_t value)
-    {
-        assert(value != 0);
-        std::lock_guard lock(mutex);
-        freed.push_back(value);
-    }
-};
-
 static std::unique_ptr<RenderTexture> g_blankTextures[TEXTURE_DESCRIPTOR_NULL_COUNT];
 static std::unique_ptr<RenderTextureView> g_blankTextureViews[TEXTURE_DESCRIPTOR_NULL_COUNT];
 
-static TextureDescriptorAllocator g_textureDescriptorAllocator;
+static constexpr size_t TEXTURE_DESCRIPTOR_SIZE = 65536;
+static constexpr size_t SAMPLER_DESCRIPTOR_SIZE = 1024;
+
+// Loader threads allocate while the render thread frees, which only happens once the frame
+// that destroyed the texture has retired, so indices never get reused while still in flight.
+static DescriptorIndexAllocator g_textureDescriptorAllocator(TEXTURE_DESCRIPTOR_SIZE, TEXTURE_DESCRIPTOR_NULL_COUNT);
+
+static std::atomic<uint32_t> g_decodedTextureCount;
+static std::atomic<uint32_t> g_cancelledTextureDecodeCount;
+static std::atomic<uint32_t> g_textureUploadBatchCount;
+static std::atomic<uint32_t> g_transcodedTextureCount;
+static std::atomic<uint32_t> g_decodedBCTextureCount;
+static std::atomic<uint32_t> g_lockedTextureRowCount;
+static std::atomic<uint32_t> g_uploadedTextureRowCount;
 
 static std::unique_ptr<RenderPipelineLayout> g_pipelineLayout;
 static xxHashMap<std::unique_ptr<RenderPipeline>> g_pipelines;
 
+// Pipelines the render thread had to compile on its own because a draw needed them
+// immediately. Queued background compilations of these get skipped by the compiler threads.
+static Mutex g_pipelinesCompiledInRenderThreadMutex;
+static ankerl::unordered_dense::set<XXH64_hash_t, xxHash> g_pipelinesCompiledInRenderThread;
+
+// Pipelines the render thread linked out of pipeline libraries instead of compiling them in full.
+// They get replaced as soon as their optimized compilation comes in. Only touched by the render thread.
+static ankerl::unordered_dense::set<XXH64_hash_t, xxHash> g_fastLinkedPipelines;
+static std::atomic<uint32_t> g_fastLinkedPipelineCount;
+static std::atomic<uint32_t> g_optimizedPipelineCount;
+
 #ifdef ASYNC_PSO_DEBUG
 static std::atomic<uint32_t> g_pipelinesCreatedInRenderThread;
 static std::atomic<uint32_t> g_pipelinesCreatedAsynchronously;
@@ -375,6 +409,34 @@ static Mutex g_pipelineCacheMutex;
 static std::atomic<uint32_t> g_compilingPipelineTaskCount;
 static std::atomic<uint32_t> g_pendingPipelineTaskCount;
 
+// Lower values get dequeued first.
+enum class PipelinePriority
+{
+    // Stage loading is waiting on these through the task token.
+    Blocking,
+    // Recompilations caused by config changes.
+    Normal,
+    // Precompiled cache entries nothing is waiting on yet. Never cancelled, since
+    // they wouldn't get queued again and the cache would silently lose them.
+    Speculative,
+    // Full compilations of fast linked pipelines, which are already usable in the meantime.
+    Optimization,
+    Count
+};
+
+static std::atomic<uint32_t> g_pipelineStateQueueDepths[size_t(PipelinePriority::Count)];
+static std::atomic<uint32_t> g_cancelledPipelineCount;
+static std::atomic<uint32_t> g_pipelineCount;
+static std::atomic<uint32_t> g_redundantPipelineCount;
+static std::atomic<uint32_t> g_pipelineLookupHits;
+static std::atomic<uint32_t> g_pipelineLookupMisses;
+static constexpr size_t MAX_ASYNC_PIPELINE_STATES = 65536;
+static std::atomic<uint32_t> g_asyncPipelineStateCount;
+static std::atomic<uint32_t> g_asyncPipelineStateHits;
+static std::atomic<uint32_t> g_asyncPipelineStateEvictions;
+static std::atomic<size_t> g_asyncPipelineStateMemoryUsage;
+static Profiler g_pipelineQueueWaitProfiler;
+
 enum class PipelineTaskType
 {
     Null,
@@ -420,10 +482,12 @@ static uint8_t* const g_vertexDeclarationCache[] =
 #include "cache/vertex_declaration_cache.h"
 };
 
-static xxHashMap<std::pair<uint32_t, std::unique_ptr<RenderSampler>>> g_samplerStates;
+// Sampler states get interned by their packed key to the index of their descriptor, which is what the shaders see.
+static SamplerTable<SAMPLER_DESCRIPTOR_SIZE> g_samplerTable;
+static std::unique_ptr<RenderSampler> g_samplers[SAMPLER_DESCRIPTOR_SIZE];
 
-static Mutex g_vertexDeclarationMutex;
-static xxHashMap<GuestVertexDeclaration*> g_vertexDeclarations;
+// Looked up by the game and the pipeline compiler threads alike, only creating a new declaration locks.
+static ConcurrentHashRegistry<GuestVertexDeclaration, 1024> g_vertexDeclarations;
 
 struct UploadBuffer
 {
@@ -475,16 +539,7 @@ struct UploadAllocator
         auto result = allocate(size, alignment);
 
         if constexpr (TByteSwap)
-        {
-            auto destination = reinterpret_cast<T*>(result.memory);
-
-            for (size_t i = 0; i < size; i += sizeof(T))
-            {
-                *destination = ByteSwap(*memory);
-                ++destination;
-                ++memory;
-            }
-        }
+            CopyAndSwap(reinterpret_cast<T*>(result.memory), memory, size / sizeof(T));
         else
         {
             memcpy(result.memory, memory, size);
@@ -501,6 +556,32 @@ struct UploadAllocator
 };
 
 static UploadAllocator g_uploadAllocators[NUM_FRAMES];
+static UploadDedupCache<UploadAllocation> g_constantUploadCaches[NUM_FRAMES];
+
+// Published once per frame for the profiler.
+static std::atomic<uint32_t> g_constantUploadHitsPerFrame;
+static std::atomic<uint32_t> g_constantUploadMissesPerFrame;
+static std::atomic<uint64_t> g_constantUploadBytesPerFrame;
+static std::atomic<uint64_t> g_constantUploadSavedBytesPerFrame;
+
+template<bool TByteSwap, typename T>
+static UploadAllocation AllocateConstants(const T* memory, uint32_t size)
+{
+    return g_constantUploadCaches[g_frame].Get(memory, size, [&]
+        {
+            return g_uploadAllocators[g_frame].allocate<TByteSwap>(memory, size, 0x100);
+        });
+}
+
+static void PublishConstantUploadStats()
+{
+    auto& cache = g_constantUploadCaches[g_frame];
+    g_constantUploadHitsPerFrame = uint32_t(cache.hitCount);
+    g_constantUploadMissesPerFrame = uint32_t(cache.missCount);
+    g_constantUploadBytesPerFrame = cache.uploadedBytes;
+    g_constantUploadSavedBytesPerFrame = cache.savedBytes;
+    cache.ResetStats();
+}
 
 struct IntermediaryUploadAllocator
 {
@@ -551,13 +632,42 @@ static IntermediaryUploadAllocator g_intermediaryUploadAllocator;
 
 static std::vector<GuestResource*> g_tempResources[NUM_FRAMES];
 static std::vector<std::unique_ptr<RenderBuffer>> g_tempBuffers[NUM_FRAMES];
+static std::vector<std::unique_ptr<RenderTextureView>> g_tempTextureViews[NUM_FRAMES];
+static std::vector<std::shared_ptr<RenderTexture>> g_tempTextures[NUM_FRAMES];
+static std::vector<std::unique_ptr<RenderPipeline>> g_tempPipelines[NUM_FRAMES];
+static std::vector<std::unique_ptr<RenderFramebuffer>> g_tempFramebuffers[NUM_FRAMES];
+
+// Textures that weren't bound for this many frames get their top mip level dropped while over the budget.
+static constexpr uint32_t RESIDENCY_MIN_IDLE_FRAMES = 600;
+static constexpr uint32_t RESIDENCY_MAX_DOWNGRADES_PER_FRAME = 4;
+
+// Downgraded textures get restored to their full size when they're bound again, a few per frame.
+static constexpr uint32_t RESIDENCY_MAX_RESTORES_PER_FRAME = 4;
+
+static Mutex g_textureResidencyMutex;
+static ResidencyTracker<GuestTexture> g_textureResidency;
+// Advanced by the render thread, read by loader threads stamping newly loaded textures.
+static std::atomic<uint32_t> g_residencyFrame;
+
+static uint64_t ComputeTextureMemorySize(const RenderTextureDesc& desc)
+{
+    uint32_t blockWidth = RenderFormatBlockWidth(desc.format);
+    return ComputeTextureMemorySize(desc.width, desc.height, desc.depth, desc.mipLevels, desc.arraySize,
+        RenderFormatSize(desc.format) * 8, blockWidth, blockWidth);
+}
 
+// Pattern buffers outlive the frame and only get replaced when a draw needs more primitives than they hold.
+// The capacity grows geometrically, so a scene ramping up its primitive counts settles after a few draws.
 template<GuestPrimitiveType PrimitiveType>
 struct PrimitiveIndexData
 {
+    static constexpr uint32_t MIN_PRIMITIVE_CAPACITY = 1024;
+
     std::vector<uint16_t> indexData;
+    std::unique_ptr<RenderBuffer> buffer;
     RenderBufferReference indexBuffer;
-    uint32_t currentIndexCount = 0;
+    uint32_t primitiveCapacity = 0;
+    uint32_t growCount = 0;
 
     uint32_t prepare(uint32_t guestPrimCount)
     {
@@ -581,45 +691,29 @@ struct PrimitiveIndexData
 
         uint32_t indexCount = primCount * indexCountPerPrimitive;
 
-        if (indexData.size() < indexCount)
+        if (primitiveCapacity < primCount)
         {
-            const size_t oldPrimCount = indexData.size() / indexCountPerPrimitive;
-            indexData.resize(indexCount);
+            uint32_t newCapacity = std::max({ primCount, primitiveCapacity * 2, MIN_PRIMITIVE_CAPACITY });
 
-            for (size_t i = oldPrimCount; i < primCount; i++)
-            {
-                switch (PrimitiveType)
-                {
-                case D3DPT_TRIANGLEFAN:
-                {
-                    indexData[i * 3 + 0] = 0;
-                    indexData[i * 3 + 1] = static_cast<uint16_t>(i + 1);
-                    indexData[i * 3 + 2] = static_cast<uint16_t>(i + 2);
-                    break;
-                }
-                case D3DPT_QUADLIST:
-                {
-                    indexData[i * 6 + 0] = static_cast<uint16_t>(i * 4 + 0);
-                    indexData[i * 6 + 1] = static_cast<uint16_t>(i * 4 + 1);
-                    indexData[i * 6 + 2] = static_cast<uint16_t>(i * 4 + 2);
+            indexData.resize(newCapacity * indexCountPerPrimitive);
 
-                    indexData[i * 6 + 3] = static_cast<uint16_t>(i * 4 + 0);
-                    indexData[i * 6 + 4] = static_cast<uint16_t>(i * 4 + 2);
-                    indexData[i * 6 + 5] = static_cast<uint16_t>(i * 4 + 3);
-                    break;
-                }
-                default:
-                    assert(false && "Unknown primitive type.");
-                    break;
-                }
-            }
-        }
+            if constexpr (PrimitiveType == D3DPT_TRIANGLEFAN)
+                GenerateTriangleFanIndices(indexData.data(), primitiveCapacity, newCapacity - primitiveCapacity);
+            else
+                GenerateQuadListIndices(indexData.data(), primitiveCapacity, newCapacity - primitiveCapacity);
 
-        if (indexBuffer == NULL || currentIndexCount < indexCount)
-        {
-            auto allocation = g_uploadAllocators[g_frame].allocate<false>(indexData.data(), indexCount * 2, 2);
-            indexBuffer = allocation.buffer->at(allocation.offset);
-            currentIndexCount = indexCount;
+            // Draws recorded for frames still in flight may reference the old buffer.
+            if (buffer != nullptr)
+                g_tempBuffers[g_frame].emplace_back(std::move(buffer));
+
+            size_t size = indexData.size() * sizeof(uint16_t);
+            buffer = g_device->createBuffer(RenderBufferDesc::UploadBuffer(size, RenderBufferFlag::INDEX));
+            memcpy(buffer->map(), indexData.data(), size);
+            buffer->unmap();
+
+            indexBuffer = buffer->at(0);
+            primitiveCapacity = newCapacity;
+            ++growCount;
         }
 
         SetDirtyValue(g_dirtyStates.indices, g_indexBufferView.buffer, indexBuffer);
@@ -628,12 +722,6 @@ struct PrimitiveIndexData
 
         return indexCount;
     }
-
-    void reset()
-    {
-        indexBuffer = {};
-        currentIndexCount = 0;
-    }
 };
 
 static PrimitiveIndexData<D3DPT_TRIANGLEFAN> g_triangleFanIndexData;
@@ -650,6 +738,12 @@ static void DestructTempResources()
         {
             const auto texture = reinterpret_cast<GuestTexture*>(resource);
 
+            if (texture->memorySize != 0)
+            {
+                std::lock_guard lock(g_textureResidencyMutex);
+                g_textureResidency.Untrack(texture);
+            }
+
             if (texture->mappedMemory != nullptr)
                 g_userHeap.Free(texture->mappedMemory);
 
@@ -706,6 +800,10 @@ static void DestructTempResources()
 
     g_tempResources[g_frame].clear();
     g_tempBuffers[g_frame].clear();
+    g_tempTextureViews[g_frame].clear();
+    g_tempTextures[g_frame].clear();
+    g_tempFramebuffers[g_frame].clear();
+    g_tempPipelines[g_frame].clear();
 }
 
 static std::thread::id g_presentThreadId = std::this_thread::get_id();
@@ -720,14 +818,22 @@ PPC_FUNC(sub_824ECA00)
     __imp__sub_824ECA00(ctx, base);
 }
 
-static ankerl::unordered_dense::map<RenderTexture*, RenderTextureLayout> g_barrierMap;
+static BarrierBatch<RenderTexture*, RenderTextureLayout> g_barrierBatch;
+static BarrierStats g_barrierStats;
+
+// Published once per frame for the profiler.
+static std::atomic<uint32_t> g_barrierBatchesPerFrame;
+static std::atomic<uint32_t> g_barrierTransitionsPerFrame;
+static std::atomic<uint32_t> g_barrierElidedPerFrame;
+static std::atomic<uint32_t> g_barrierPrefetchedPerFrame;
 
 static void AddBarrier(GuestBaseTexture* texture, RenderTextureLayout layout)
 {
     if (texture != nullptr && texture->layout != layout)
     {
-        g_barrierMap[texture->texture] = layout;
+        g_barrierBatch.Add(texture->texture, texture->layout, layout, texture->discardOnBarrier);
         texture->layout = layout;
+        texture->discardOnBarrier = false;
     }
 }
 
@@ -735,27 +841,104 @@ static std::vector<RenderTextureBarrier> g_barriers;
 
 static void FlushBarriers()
 {
-    if (!g_barrierMap.empty())
+    if (!g_barrierBatch.IsEmpty())
     {
-        for (auto& [texture, layout] : g_barrierMap)
-            g_barriers.emplace_back(texture, layout);
+        g_barrierStats.elidedCount += g_barrierBatch.Resolve(g_barriers);
+
+        if (!g_barriers.empty())
+        {
+            g_commandLists[g_frame]->barriers(RenderBarrierStage::GRAPHICS | RenderBarrierStage::COPY, g_barriers);
 
-        g_commandLists[g_frame]->barriers(RenderBarrierStage::GRAPHICS | RenderBarrierStage::COPY, g_barriers);
+            ++g_barrierStats.batchCount;
+            g_barrierStats.transitionCount += uint32_t(g_barriers.size());
+        }
 
-        g_barrierMap.clear();
         g_barriers.clear();
     }
 }
 
+static void PublishBarrierStats()
+{
+    g_barrierBatchesPerFrame = g_barrierStats.batchCount;
+    g_barrierTransitionsPerFrame = g_barrierStats.transitionCount;
+    g_barrierElidedPerFrame = g_barrierStats.elidedCount;
+    g_barrierPrefetchedPerFrame = g_barrierStats.prefetchedCount;
+    g_barrierStats = {};
+}
+
 static std::unique_ptr<uint8_t[]> g_shaderCache;
 static std::unique_ptr<uint8_t[]> g_buttonBcDiff;
 
+enum class TextureFixupType
+{
+    ForceCubeMap,
+    DiffPatch
+};
+
+struct TextureFixup
+{
+    TextureFixupType type;
+    const BlockCompressionDiffPatchEntry* diffPatchEntry;
+};
+
+static TextureFixupRegistry<TextureFixup> g_textureFixups;
+static ShaderModuleCache g_shaderModuleCache;
+
+// Same record format as the shader module cache, keyed by the hash of the source DDS and its format.
+// Transcoded data only depends on those and the transcoder, so it survives updates unlike shader modules.
+static constexpr uint64_t TEXTURE_TRANSCODER_VERSION = 1;
+static ShaderModuleCache g_transcodedTextureCache;
+static bool g_transcodeBCTextures;
+
 static void LoadEmbeddedResources()
 {
     g_shaderCache = std::make_unique<uint8_t[]>(g_spirvCacheDecompressedSize);
     ZSTD_decompress(g_shaderCache.get(), g_spirvCacheDecompressedSize, g_compressedSpirvCache, g_spirvCacheCompressedSize);
 
     g_buttonBcDiff = decompressZstd(g_button_bc_diff, g_button_bc_diff_uncompressed_size);
+
+    // The whale in Cool Edge has a 2D texture assigned as a cubemap which makes it not display in recomp.
+    // The hardware duplicates the first face to the remaining 6 faces, so to simulate that we'll recreate the asset.
+    g_textureFixups.Add(0xAB38, 0x160E9E250FDE88A9, { TextureFixupType::ForceCubeMap });
+
+    // Patch files record the size of every patched texture, except for ones made before the tool started doing so.
+    // Those only tell that the texture reaches as far as the furthest patch and is made of whole BC blocks.
+    auto diffPatchHeader = reinterpret_cast<BlockCompressionDiffPatchHeader*>(g_buttonBcDiff.get());
+    auto diffPatchEntries = reinterpret_cast<BlockCompressionDiffPatchEntry*>(g_buttonBcDiff.get() + diffPatchHeader->entriesOffset);
+    uint32_t* diffPatchDataSizes = nullptr;
+
+    if (diffPatchHeader->entriesOffset >= offsetof(BlockCompressionDiffPatchHeader, dataSizesOffset) + sizeof(uint32_t))
+        diffPatchDataSizes = reinterpret_cast<uint32_t*>(g_buttonBcDiff.get() + diffPatchHeader->dataSizesOffset);
+
+    for (uint32_t i = 0; i < diffPatchHeader->entryCount; i++)
+    {
+        auto& entry = diffPatchEntries[i];
+
+        if (diffPatchDataSizes != nullptr)
+        {
+            g_textureFixups.Add(diffPatchDataSizes[i], entry.hash, { TextureFixupType::DiffPatch, &entry });
+            continue;
+        }
+
+        auto patches = reinterpret_cast<BlockCompressionDiffPatch*>(g_buttonBcDiff.get() + entry.patchesOffset);
+
+        size_t minDataSize = 0;
+        for (uint32_t j = 0; j < entry.patchCount; j++)
+            minDataSize = std::max<size_t>(minDataSize, patches[j].destinationOffset + patches[j].patchBytesSize);
+
+        g_textureFixups.AddMinimumSize(minDataSize, 8, entry.hash, { TextureFixupType::DiffPatch, &entry });
+    }
+
+    // Modules are only valid for the exact shader cache and backend they were made with.
+    XXH64_hash_t buildHash = XXH3_64bits_withSeed(g_compressedSpirvCache, g_spirvCacheCompressedSize, 
+        XXH3_64bits(g_commitHash, strlen(g_commitHash)));
+
+    g_shaderModuleCache.Open(GetUserPath() / (g_vulkan ? "shader_module_cache_spirv.bin" : "shader_module_cache_dxil.bin"), buildHash);
+
+    // D3D12 always samples BC, and so does every desktop Vulkan driver. Most mobile ones don't.
+    g_transcodeBCTextures = g_vulkan && !g_capabilities.textureCompressionBC;
+    if (g_transcodeBCTextures && g_capabilities.textureCompressionETC2)
+        g_transcodedTextureCache.Open(GetUserPath() / "transcoded_texture_cache.bin", TEXTURE_TRANSCODER_VERSION);
 }
 
 enum class CsdFilterState
@@ -770,6 +953,53 @@ static CsdFilterState g_csdFilterState;
 static ankerl::unordered_dense::set<GuestSurface*> g_pendingSurfaceCopies;
 static ankerl::unordered_dense::set<GuestSurface*> g_pendingMsaaResolves;
 
+// Lifetimes of the surfaces within a frame. Surfaces that get overwritten before anything reads them every
+// frame share memory in a heap, placed by the lifetimes of earlier frames. A placement is only made once the
+// plan stayed the same for a while, and gets dropped as soon as a frame uses the surfaces in a way it doesn't
+// allow. That frame may still see a surface overwritten by another one sharing its memory.
+static TransientLifetimeTracker<GuestSurface*> g_surfaceLifetimes;
+static constexpr uint64_t SURFACE_MEMORY_ALIGNMENT = 0x10000;
+static constexpr uint32_t SURFACE_PLACEMENT_STABLE_FRAMES = 120;
+
+static bool g_aliasTransientSurfaces;
+static std::shared_ptr<RenderTexture> g_surfaceHeap;
+static std::vector<std::pair<GuestSurface*, TransientResource>> g_placedSurfaces;
+static XXH64_hash_t g_placedSurfaceSignature;
+static XXH64_hash_t g_plannedSurfaceSignature;
+static uint32_t g_plannedSurfaceStableFrames;
+
+// Draws only record their targets again after something else used a surface.
+static bool g_surfaceDrawUseRecorded = false;
+
+static std::atomic<uint64_t> g_surfaceDedicatedMemory;
+static std::atomic<uint64_t> g_surfaceAliasedMemory;
+static std::atomic<uint64_t> g_surfaceTransientHeapMemory;
+static std::atomic<uint32_t> g_transientSurfaceCount;
+static std::atomic<uint32_t> g_placedSurfaceCount;
+
+static void RecordSurfaceUse(GuestSurface* surface, bool discardsContents)
+{
+    if (!g_aliasTransientSurfaces || surface == nullptr || surface == g_backBuffer)
+        return;
+
+    uint64_t size = uint64_t(surface->width) * surface->height * RenderFormatSize(surface->format) * uint32_t(surface->sampleCount);
+    g_surfaceLifetimes.Use(surface, (size + SURFACE_MEMORY_ALIGNMENT - 1) & ~(SURFACE_MEMORY_ALIGNMENT - 1), discardsContents);
+    g_surfaceDrawUseRecorded = false;
+}
+
+// Attachment loads skipped by render passes that start by overwriting the attachment, counted per frame.
+static uint32_t g_frameDiscardedLoadCount;
+static uint64_t g_frameDiscardedLoadMemory;
+
+static std::atomic<uint32_t> g_discardedLoadCount;
+static std::atomic<uint64_t> g_discardedLoadMemory;
+
+static void RecordDiscardedLoad(uint32_t width, uint32_t height, RenderFormat format, RenderSampleCounts sampleCount)
+{
+    ++g_frameDiscardedLoadCount;
+    g_frameDiscardedLoadMemory += uint64_t(width) * height * RenderFormatSize(format) * uint32_t(sampleCount);
+}
+
 enum class RenderCommandType
 {
     SetRenderState,
@@ -804,6 +1034,43 @@ enum class RenderCommandType
     ExecuteLambda,
 };
 
+// For reports, kept next to the enum so it doesn't depend on the debug only magic_enum include.
+static const char* const g_renderCommandTypeNames[] =
+{
+    "SetRenderState",
+    "DestructResource",
+    "UnlockTextureRect",
+    "UnlockBuffer16",
+    "UnlockBuffer32",
+    "DrawImGui",
+    "ExecuteCommandList",
+    "BeginCommandList",
+    "StretchRect",
+    "SetRenderTarget",
+    "SetDepthStencilSurface",
+    "ExecutePendingStretchRectCommands",
+    "Clear",
+    "SetViewport",
+    "SetTexture",
+    "SetScissorRect",
+    "SetSamplerState",
+    "SetBooleans",
+    "SetVertexShaderConstants",
+    "SetPixelShaderConstants",
+    "AddPipeline",
+    "DrawPrimitive",
+    "DrawIndexedPrimitive",
+    "DrawPrimitiveUP",
+    "SetVertexDeclaration",
+    "SetVertexShader",
+    "SetStreamSource",
+    "SetIndices",
+    "SetPixelShader",
+    "ExecuteLambda",
+};
+
+static_assert(std::size(g_renderCommandTypeNames) == size_t(RenderCommandType::ExecuteLambda) + 1);
+
 struct RenderCommand
 {
     RenderCommandType type;
@@ -975,6 +1242,20 @@ struct RenderCommand
 
 static moodycamel::BlockingConcurrentQueue<RenderCommand> g_renderQueue;
 
+// Commands dequeued alongside the one being processed, for handlers that want to plan ahead.
+static const RenderCommand* g_renderCommandLookahead;
+static size_t g_renderCommandLookaheadCount;
+
+static constexpr uint32_t RENDER_CAPTURE_DEFAULT_FRAME_COUNT = 60;
+
+// Capture is only touched by the render thread, other threads just request it.
+static std::atomic<uint32_t> g_renderCaptureRequestedFrames;
+static uint32_t g_renderCaptureFrameCount;
+static RenderCaptureWriter g_renderCaptureWriter;
+
+static std::atomic<bool> g_renderCommandTimingEnabled;
+static RenderCommandTimings g_renderCommandTimings;
+
 static void ProcExecuteLambda(const RenderCommand& cmd)
 {
     cmd.executeLambda.executor(cmd.executeLambda.lambdaPtr);
@@ -1030,8 +1311,8 @@ static void SetAlphaTestMode(bool enable)
 
     specConstants |= (g_pipelineState.specConstants & ~(SPEC_CONSTANT_ALPHA_TEST | SPEC_CONSTANT_ALPHA_TO_COVERAGE));
 
-    SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.enableAlphaToCoverage, enableAlphaToCoverage);
-    SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.specConstants, specConstants);
+    SetPipelineStateValue(g_pipelineState.enableAlphaToCoverage, enableAlphaToCoverage);
+    SetPipelineStateValue(g_pipelineState.specConstants, specConstants);
 }
 
 static RenderBlend ConvertBlendMode(uint32_t blendMode)
@@ -1092,13 +1373,13 @@ static void ProcSetRenderState(const RenderCommand& cmd)
     {
     case D3DRS_ZENABLE:
     {
-        SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.zEnable, value != 0);
+        SetPipelineStateValue(g_pipelineState.zEnable, value != 0);
         g_dirtyStates.renderTargetAndDepthStencil |= g_dirtyStates.pipelineState;
         break;
     }
     case D3DRS_ZWRITEENABLE:
     {
-        SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.zWriteEnable, value != 0);
+        SetPipelineStateValue(g_pipelineState.zWriteEnable, value != 0);
         break;
     }
     case D3DRS_ALPHATESTENABLE:
@@ -1108,12 +1389,12 @@ static void ProcSetRenderState(const RenderCommand& cmd)
     }
     case D3DRS_SRCBLEND:
     {
-        SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.srcBlend, ConvertBlendMode(value));
+        SetPipelineStateValue(g_pipelineState.srcBlend, ConvertBlendMode(value));
         break;
     }
     case D3DRS_DESTBLEND:
     {
-        SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.destBlend, ConvertBlendMode(value));
+        SetPipelineStateValue(g_pipelineState.destBlend, ConvertBlendMode(value));
         break;
     }
     case D3DRS_CULLMODE:
@@ -1137,7 +1418,7 @@ static void ProcSetRenderState(const RenderCommand& cmd)
             break;
         }
 
-        SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.cullMode, cullMode);
+        SetPipelineStateValue(g_pipelineState.cullMode, cullMode);
         break;
     }
     case D3DRS_ZFUNC:
@@ -1176,7 +1457,7 @@ static void ProcSetRenderState(const RenderCommand& cmd)
             break;
         }
 
-        SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.zFunc, comparisonFunc);
+        SetPipelineStateValue(g_pipelineState.zFunc, comparisonFunc);
         break;
     }
     case D3DRS_ALPHAREF:
@@ -1186,12 +1467,12 @@ static void ProcSetRenderState(const RenderCommand& cmd)
     }
     case D3DRS_ALPHABLENDENABLE:
     {
-        SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.alphaBlendEnable, value != 0);
+        SetPipelineStateValue(g_pipelineState.alphaBlendEnable, value != 0);
         break;
     }
     case D3DRS_BLENDOP:
     {
-        SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.blendOp, ConvertBlendOp(value));
+        SetPipelineStateValue(g_pipelineState.blendOp, ConvertBlendOp(value));
         break;
     }
     case D3DRS_SCISSORTESTENABLE:
@@ -1204,7 +1485,7 @@ static void ProcSetRenderState(const RenderCommand& cmd)
         if (g_capabilities.dynamicDepthBias)
             SetDirtyValue(g_dirtyStates.depthBias, g_slopeScaledDepthBias, *reinterpret_cast<float*>(&value));
         else 
-            SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.slopeScaledDepthBias, *reinterpret_cast<float*>(&value));
+            SetPipelineStateValue(g_pipelineState.slopeScaledDepthBias, *reinterpret_cast<float*>(&value));
 
         break;
     }
@@ -1213,28 +1494,28 @@ static void ProcSetRenderState(const RenderCommand& cmd)
         if (g_capabilities.dynamicDepthBias)
             SetDirtyValue(g_dirtyStates.depthBias, g_depthBias, int32_t(*reinterpret_cast<float*>(&value) * (1 << 24)));
         else
-            SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.depthBias, int32_t(*reinterpret_cast<float*>(&value)* (1 << 24)));
+            SetPipelineStateValue(g_pipelineState.depthBias, int32_t(*reinterpret_cast<float*>(&value)* (1 << 24)));
 
         break;
     }
     case D3DRS_SRCBLENDALPHA:
     {
-        SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.srcBlendAlpha, ConvertBlendMode(value));
+        SetPipelineStateValue(g_pipelineState.srcBlendAlpha, ConvertBlendMode(value));
         break;
     }
     case D3DRS_DESTBLENDALPHA:
     {
-        SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.destBlendAlpha, ConvertBlendMode(value));
+        SetPipelineStateValue(g_pipelineState.destBlendAlpha, ConvertBlendMode(value));
         break;
     }
     case D3DRS_BLENDOPALPHA:
     {
-        SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.blendOpAlpha, ConvertBlendOp(value));
+        SetPipelineStateValue(g_pipelineState.blendOpAlpha, ConvertBlendOp(value));
         break;
     }
     case D3DRS_COLORWRITEENABLE:
     {
-        SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.colorWriteEnable, value);
+        SetPipelineStateValue(g_pipelineState.colorWriteEnable, value);
         g_dirtyStates.renderTargetAndDepthStencil |= g_dirtyStates.pipelineState;
         break;
     }
@@ -1291,9 +1572,6 @@ static std::unique_ptr<GuestShader> g_enhancedMotionBlurShader;
 #define CREATE_SHADER(NAME) \
     g_device->createShader(g_##NAME##_spirv, sizeof(g_##NAME##_spirv), "main", RenderShaderFormat::SPIRV)
 
-static constexpr size_t TEXTURE_DESCRIPTOR_SIZE = 65536;
-static constexpr size_t SAMPLER_DESCRIPTOR_SIZE = 1024;
-
 static std::unique_ptr<GuestTexture> g_imFontTexture;
 static std::unique_ptr<RenderPipelineLayout> g_imPipelineLayout;
 static std::unique_ptr<RenderPipeline> g_imPipeline;
@@ -1532,14 +1810,30 @@ static void CheckSwapChain()
     g_backBuffer->height = Video::s_viewportHeight;
 }
 
+// Marks the start of a GPU timeline section. The last query is reserved for the end of the frame.
+// Only the frame start is needed for the GPU frame time, the sections are written while recording a trace.
+static void WriteTimestamp(const char* name)
+{
+    uint32_t& queryCount = g_queryCounts[g_frame];
+    if (queryCount != 0 && !g_traceRecorder.IsEnabled())
+        return;
+
+    if (queryCount < NUM_QUERIES - 1)
+    {
+        g_queryNames[g_frame][queryCount] = name;
+        g_commandLists[g_frame]->writeTimestamp(g_queryPools[g_frame].get(), queryCount);
+        ++queryCount;
+    }
+}
+
 static void BeginCommandList()
 {
     g_renderTarget = g_backBuffer;
     g_depthStencil = nullptr;
     g_framebuffer = nullptr;
 
-    g_pipelineState.renderTargetFormat = BACKBUFFER_FORMAT;
-    g_pipelineState.depthStencilFormat = RenderFormat::UNKNOWN;
+    SetPipelineStateValue(g_pipelineState.renderTargetFormat, BACKBUFFER_FORMAT);
+    SetPipelineStateValue(g_pipelineState.depthStencilFormat, RenderFormat::UNKNOWN);
 
     if (g_swapChainValid)
     {
@@ -1592,15 +1886,16 @@ static void BeginCommandList()
     memset(g_textures, 0, sizeof(g_textures));
 
     if (Config::GITextureFiltering == EGITextureFiltering::Bicubic)
-        g_pipelineState.specConstants |= SPEC_CONSTANT_BICUBIC_GI_FILTER;
+        SetPipelineStateValue(g_pipelineState.specConstants, uint32_t(g_pipelineState.specConstants | SPEC_CONSTANT_BICUBIC_GI_FILTER));
     else
-        g_pipelineState.specConstants &= ~SPEC_CONSTANT_BICUBIC_GI_FILTER;
+        SetPipelineStateValue(g_pipelineState.specConstants, uint32_t(g_pipelineState.specConstants & ~SPEC_CONSTANT_BICUBIC_GI_FILTER));
 
     auto& commandList = g_commandLists[g_frame];
 
     commandList->begin();
     commandList->resetQueryPool(g_queryPools[g_frame].get(), 0, NUM_QUERIES);
-    commandList->writeTimestamp(g_queryPools[g_frame].get(), 0);
+    g_queryCounts[g_frame] = 0;
+    WriteTimestamp("Frame Start");
     commandList->setGraphicsPipelineLayout(g_pipelineLayout.get());
     commandList->setGraphicsDescriptorSet(g_textureDescriptorSet.get(), 0);
     commandList->setGraphicsDescriptorSet(g_textureDescriptorSet.get(), 1);
@@ -1638,11 +1933,13 @@ static void ApplyLowEndDefaults()
     }
 }
 
-bool Video::CreateHostDevice(const char *sdlVideoDriver, bool graphicsApiRetry)
+bool Video::CreateHostDevice(const char *sdlVideoDriver, bool graphicsApiRetry, bool nullRenderer)
 {
     for (uint32_t i = 0; i < 16; i++)
         g_inputSlots[i].index = i;
 
+    g_traceRecorder.SetEnabled(Config::TraceRecording);
+
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
     ImPlot::CreateContext();
@@ -1657,7 +1954,12 @@ bool Video::CreateHostDevice(const char *sdlVideoDriver, bool graphicsApiRetry)
     using RenderInterfaceFunction = std::unique_ptr<RenderInterface>(void);
     std::vector<RenderInterfaceFunction *> interfaceFunctions;
 
-    interfaceFunctions.push_back(CreateVulkanInterfaceWrapper);
+    g_nullRenderer = nullRenderer;
+
+    if (nullRenderer)
+        interfaceFunctions.push_back(CreateNullInterface);
+    else
+        interfaceFunctions.push_back(CreateVulkanInterfaceWrapper);
 
     for (size_t i = 0; i < interfaceFunctions.size(); i++)
     {
@@ -1697,6 +1999,14 @@ bool Video::CreateHostDevice(const char *sdlVideoDriver, bool graphicsApiRetry)
     RenderDeviceDescription deviceDescription = g_device->getDescription();
     bool lowEndType = deviceDescription.type != RenderDeviceType::UNKNOWN && deviceDescription.type != RenderDeviceType::DISCRETE;
     bool lowEndMemory = deviceDescription.dedicatedVideoMemory < LowEndMemoryLimit;
+
+    g_aliasTransientSurfaces = Config::AliasTransientRenderTargets;
+
+    // Render targets and buffers need room too, so textures get half of the video memory by default. The driver's
+    // budget leaves out what other processes are using, so it's preferred over the size of the memory when there's one.
+    uint64_t videoMemory = (deviceDescription.videoMemoryBudget != 0) ? deviceDescription.videoMemoryBudget : deviceDescription.dedicatedVideoMemory;
+    g_textureResidency.budget = (Config::TextureMemoryBudget != 0) ?
+        (uint64_t(Config::TextureMemoryBudget) * 1024 * 1024) : (videoMemory / 2);
     bool lowEndUMA = deviceDescription.type == RenderDeviceType::UNKNOWN && g_capabilities.uma;
     if (lowEndType || lowEndMemory || lowEndUMA)
     {
@@ -1830,10 +2140,11 @@ bool Video::CreateHostDevice(const char *sdlVideoDriver, bool graphicsApiRetry)
     descriptorSetBuilder.end(true, SAMPLER_DESCRIPTOR_SIZE);
     
     g_samplerDescriptorSet = descriptorSetBuilder.create(g_device.get());
-    auto& [descriptorIndex, sampler] = g_samplerStates[XXH3_64bits(&g_samplerDescs[0], sizeof(RenderSamplerDesc))];
-    descriptorIndex = 1;
-    sampler = g_device->createSampler(g_samplerDescs[0]);
-    g_samplerDescriptorSet->setSampler(0, sampler.get());
+    g_samplers[0] = g_device->createSampler(RenderSamplerDesc());
+    g_samplerDescriptorSet->setSampler(0, g_samplers[0].get());
+
+    for (auto& samplerKey : g_samplerKeys)
+        samplerKey = SamplerTable<SAMPLER_DESCRIPTOR_SIZE>::EMPTY_KEY;
 
     pipelineLayoutBuilder.addDescriptorSet(descriptorSetBuilder);
 
@@ -2025,6 +2336,14 @@ static void DestructResource(GuestResource* resource)
 static void ProcDestructResource(const RenderCommand& cmd)
 {
     const auto& args = cmd.destructResource;
+
+    if (args.resource->type == ResourceType::RenderTarget || args.resource->type == ResourceType::DepthStencil)
+    {
+        auto surface = reinterpret_cast<GuestSurface*>(args.resource);
+        g_surfaceLifetimes.Forget(surface);
+        std::erase_if(g_placedSurfaces, [surface](const auto& placedSurface) { return placedSurface.first == surface; });
+    }
+
     g_tempResources[g_frame].push_back(args.resource);
 }
 
@@ -2059,18 +2378,31 @@ static void ProcUnlockTextureRect(const RenderCommand& cmd)
 {
     const auto& args = cmd.unlockTextureRect;
 
+    uint32_t pitch = ComputeTexturePitch(args.texture);
+    uint32_t rowSize = args.texture->width * RenderFormatSize(args.texture->format);
+    auto mappedMemory = reinterpret_cast<const uint8_t*>(args.texture->mappedMemory);
+
+    auto& dirtyRows = args.texture->dirtyRows;
+    dirtyRows.Update(mappedMemory, pitch, rowSize, args.texture->height);
+
+    g_lockedTextureRowCount += args.texture->height;
+
+    if (dirtyRows.spans.empty())
+        return;
+
     AddBarrier(args.texture, RenderTextureLayout::COPY_DEST);
     FlushBarriers();
 
-    uint32_t pitch = ComputeTexturePitch(args.texture);
-    uint32_t slicePitch = pitch * args.texture->height;
+    auto allocation = g_uploadAllocators[g_frame].allocate(uint32_t(dirtyRows.PlaceSpans(pitch, PLACEMENT_ALIGNMENT)), PLACEMENT_ALIGNMENT);
 
-    auto allocation = g_uploadAllocators[g_frame].allocate(slicePitch, PLACEMENT_ALIGNMENT);
-    memcpy(allocation.memory, args.texture->mappedMemory, slicePitch);
+    for (auto& span : dirtyRows.spans)
+    {
+        memcpy(allocation.memory + span.uploadOffset, mappedMemory + size_t(span.firstRow) * pitch, size_t(span.rowCount) * pitch);
+        g_uploadedTextureRowCount += span.rowCount;
+    }
 
-    g_commandLists[g_frame]->copyTextureRegion(
-        RenderTextureCopyLocation::Subresource(args.texture->texture, 0),
-        RenderTextureCopyLocation::PlacedFootprint(allocation.buffer, args.texture->format, args.texture->width, args.texture->height, 1, pitch / RenderFormatSize(args.texture->format), allocation.offset));
+    CopyTextureDirtyRows(g_commandLists[g_frame].get(), args.texture->texture, args.texture->format, args.texture->width, pitch,
+        dirtyRows.spans, allocation.buffer, allocation.offset);
 }
 
 static void* LockBuffer(GuestBuffer* buffer, uint32_t flags)
@@ -2226,8 +2558,43 @@ static const char *DeviceTypeName(RenderDeviceType type)
     }
 }
 
+static void ExportTrace()
+{
+    auto path = GetUserPath() / "trace.json";
+    if (g_traceRecorder.WriteChromeTrace(path))
+        LOGF("Trace exported to \"{}\".", path.string());
+}
+
 static void DrawProfiler()
 {
+    // The first press starts recording, the second one exports what was recorded and stops.
+    static bool s_traceExportWasToggled;
+    bool exportTrace = SDL_GetKeyboardState(nullptr)[SDL_SCANCODE_F2] != 0;
+
+    if (!s_traceExportWasToggled && exportTrace)
+    {
+        if (g_traceRecorder.IsEnabled())
+        {
+            ExportTrace();
+            g_traceRecorder.SetEnabled(false);
+        }
+        else
+        {
+            g_traceRecorder.SetEnabled(true);
+            LOGN("Trace recording started.");
+        }
+    }
+
+    s_traceExportWasToggled = exportTrace;
+
+    static bool s_renderCaptureWasToggled;
+    bool renderCapture = SDL_GetKeyboardState(nullptr)[SDL_SCANCODE_F3] != 0;
+
+    if (!s_renderCaptureWasToggled && renderCapture)
+        Video::RequestRenderCapture(RENDER_CAPTURE_DEFAULT_FRAME_COUNT);
+
+    s_renderCaptureWasToggled = renderCapture;
+
     bool toggleProfiler = SDL_GetKeyboardState(nullptr)[SDL_SCANCODE_F1] != 0;
 
     if (!g_profilerWasToggled && toggleProfiler)
@@ -2299,6 +2666,14 @@ static void DrawProfiler()
 
         ImGui::NewLine();
 
+        ImGui::Text("Frame Interval: %g ms average, %g ms jitter, %g ms max", g_framePacer.intervalStats.GetAverage(),
+            g_framePacer.intervalStats.GetJitter(), g_framePacer.intervalStats.GetMax());
+        ImGui::Text("Pacer Wake Latency: %g ms average, %g ms max (sleeping %g ms early)", g_framePacer.wakeLatencyStats.GetAverage(),
+            g_framePacer.wakeLatencyStats.GetMax(), std::chrono::duration<double, std::milli>(g_framePacer.GetSleepMargin()).count());
+        ImGui::Text("Pacer Spin: %g ms", double(g_framePacer.spinNanoseconds) / 1000000.0);
+
+        ImGui::NewLine();
+
         if (g_userHeap.heap != nullptr && g_userHeap.physicalHeap != nullptr)
         {
             O1HeapDiagnostics diagnostics, physicalDiagnostics;
@@ -2316,13 +2691,59 @@ static void DrawProfiler()
         }
 
         ImGui::Text("GPU Waits: %d", int32_t(g_waitForGPUCount));
+        ImGui::Text("Texture Descriptors: %d/%d", int32_t(g_textureDescriptorAllocator.getUsedCount()), int32_t(TEXTURE_DESCRIPTOR_SIZE));
+        ImGui::Text("Sampler Descriptors: %d/%d (%d lookups, %d misses)", int32_t(g_samplerTable.count), int32_t(SAMPLER_DESCRIPTOR_SIZE),
+            int32_t(g_samplerTable.lookupCount), int32_t(g_samplerTable.missCount));
+        ImGui::Text("Texture Decodes: %d (%d cancelled, %d upload batches)", g_decodedTextureCount.load(), g_cancelledTextureDecodeCount.load(), g_textureUploadBatchCount.load());
+
+        ImGui::Text("Texture Hashes: %d computed, %d skipped", g_textureFixups.hashCount.load(), g_textureFixups.skipCount.load());
+        ImGui::Text("Surface Memory: %d MB, %d MB aliased (%d transient surfaces in %d MB, %d placed)", int32_t(g_surfaceDedicatedMemory / (1024 * 1024)),
+            int32_t(g_surfaceAliasedMemory / (1024 * 1024)), g_transientSurfaceCount.load(), int32_t(g_surfaceTransientHeapMemory / (1024 * 1024)),
+            g_placedSurfaceCount.load());
+        ImGui::Text("Texture Lock Rows: %d uploaded of %d unlocked", g_uploadedTextureRowCount.load(), g_lockedTextureRowCount.load());
+        ImGui::Text("Render Pass Loads: %d skipped (%d MB per frame)", g_discardedLoadCount.load(), int32_t(g_discardedLoadMemory / (1024 * 1024)));
+
+        if (g_transcodeBCTextures)
+        {
+            ImGui::Text("Texture Transcoding: %d cached, %d transcoded, %d decoded to RGBA8", int32_t(g_transcodedTextureCache.hitCount),
+                g_transcodedTextureCount.load(), g_decodedBCTextureCount.load());
+        }
+        ImGui::Text("Constant Uploads/Frame: %d uploaded, %d reused (%d KB uploaded, %d KB saved)", int32_t(g_constantUploadMissesPerFrame.load()),
+            int32_t(g_constantUploadHitsPerFrame.load()), int32_t(g_constantUploadBytesPerFrame.load() / 1024), int32_t(g_constantUploadSavedBytesPerFrame.load() / 1024));
+        ImGui::Text("Barriers/Frame: %d batches, %d transitions (%d elided, %d prefetched)", int32_t(g_barrierBatchesPerFrame.load()),
+            int32_t(g_barrierTransitionsPerFrame.load()), int32_t(g_barrierElidedPerFrame.load()), int32_t(g_barrierPrefetchedPerFrame.load()));
         ImGui::Text("Buffer Uploads: %d", int32_t(g_bufferUploadCount));
+        ImGui::Text("Pipeline Queue: %d blocking, %d normal, %d speculative, %d optimization",
+            g_pipelineStateQueueDepths[size_t(PipelinePriority::Blocking)].load(),
+            g_pipelineStateQueueDepths[size_t(PipelinePriority::Normal)].load(),
+            g_pipelineStateQueueDepths[size_t(PipelinePriority::Speculative)].load(),
+            g_pipelineStateQueueDepths[size_t(PipelinePriority::Optimization)].load());
+        ImGui::Text("Fast Linked Pipelines: %d linked, %d optimized", int32_t(g_fastLinkedPipelineCount.load()), int32_t(g_optimizedPipelineCount.load()));
+        ImGui::Text("Pipeline Queue Wait: %g ms", g_pipelineQueueWaitProfiler.value.load());
+        ImGui::Text("Pipelines Cancelled: %d", g_cancelledPipelineCount.load());
+        ImGui::Text("Pipelines: %d (%d redundant compiles)", g_pipelineCount.load(), g_redundantPipelineCount.load());
+        ImGui::Text("Pipeline Lookups: %d hits, %d misses", g_pipelineLookupHits.load(), g_pipelineLookupMisses.load());
+        ImGui::Text("Async Pipeline States: %d/%d (%d KB, %d hits, %d evictions)", g_asyncPipelineStateCount.load(), int32_t(MAX_ASYNC_PIPELINE_STATES),
+            int32_t(g_asyncPipelineStateMemoryUsage.load() / 1024), g_asyncPipelineStateHits.load(), g_asyncPipelineStateEvictions.load());
         ImGui::NewLine();
 
+        if (g_nullRenderer)
+        {
+            ImGui::Text("Null Renderer: %llu lists, %llu commands, %llu draws, %llu barriers",
+                (unsigned long long)g_nullRenderStats.submittedCommandLists.load(), (unsigned long long)g_nullRenderStats.submittedCommands.load(),
+                (unsigned long long)g_nullRenderStats.submittedDraws.load(), (unsigned long long)g_nullRenderStats.submittedBarriers.load());
+            ImGui::Text("Null Resources: %d live (%d buffers, %d textures, %d pipelines, %d MB)", int32_t(g_nullRenderStats.getTotalLiveCount()),
+                int32_t(g_nullRenderStats.getLiveCount(NullResourceType::Buffer)), int32_t(g_nullRenderStats.getLiveCount(NullResourceType::Texture)),
+                int32_t(g_nullRenderStats.getLiveCount(NullResourceType::Pipeline)), int32_t(g_nullRenderStats.liveBufferBytes.load() / (1024 * 1024)));
+            ImGui::NewLine();
+        }
+
         ImGui::Text("Present Wait: %s", g_capabilities.presentWait ? "Supported" : "Unsupported");
         ImGui::Text("Triangle Fan: %s", g_capabilities.triangleFan ? "Supported" : "Unsupported");
         ImGui::Text("Dynamic Depth Bias: %s", g_capabilities.dynamicDepthBias ? "Supported" : "Unsupported");
         ImGui::Text("Triangle Strip Workaround: %s", g_triangleStripWorkaround ? "Enabled" : "Disabled");
+        ImGui::Text("Index Patterns: %d fan, %d quad primitives (%d reallocations)", int32_t(g_triangleFanIndexData.primitiveCapacity),
+            int32_t(g_quadIndexData.primitiveCapacity), int32_t(g_triangleFanIndexData.growCount + g_quadIndexData.growCount));
         ImGui::Text("Hardware Resolve: %s", g_hardwareResolve ? "Enabled" : "Disabled");
         ImGui::Text("Hardware Depth Resolve: %s", g_hardwareDepthResolve ? "Enabled" : "Disabled");
         ImGui::NewLine();
@@ -2331,6 +2752,14 @@ static void DrawProfiler()
         ImGui::Text("Device: %s", g_device->getDescription().name.c_str());
         ImGui::Text("Device Type: %s", DeviceTypeName(g_device->getDescription().type));
         ImGui::Text("VRAM: %.2f MiB", (double)(g_device->getDescription().dedicatedVideoMemory) / (1024.0 * 1024.0));
+
+        {
+            std::lock_guard lock(g_textureResidencyMutex);
+            ImGui::Text("Texture Memory: %d/%d MB (%d textures, peak %d MB)", int32_t(g_textureResidency.usage / (1024 * 1024)),
+                int32_t(g_textureResidency.budget / (1024 * 1024)), int32_t(g_textureResidency.sizes.size()), int32_t(g_textureResidency.peakUsage / (1024 * 1024)));
+            ImGui::Text("Texture Downgrades: %d (%d MB reclaimed, %d restored)", int32_t(g_textureResidency.downgradeCount),
+                int32_t(g_textureResidency.reclaimedBytes / (1024 * 1024)), int32_t(g_textureResidency.restoreCount));
+        }
         ImGui::Text("UMA: %s", g_capabilities.uma ? "Supported" : "Unsupported");
         ImGui::Text("GPU Upload Heap: %s", g_capabilities.gpuUploadHeap ? "Supported" : "Unsupported");
 
@@ -2481,10 +2910,13 @@ static void DrawImGui()
     }
 }
 
-static void SetFramebuffer(GuestSurface *renderTarget, GuestSurface *depthStencil, bool settingForClear);
+static void SetFramebuffer(GuestSurface *renderTarget, GuestSurface *depthStencil, bool settingForClear, uint32_t discard = RENDER_PASS_DISCARD_NONE);
 
 static void ProcDrawImGui(const RenderCommand& cmd)
 {
+    TRACE_SCOPE("DrawImGui");
+    WriteTimestamp("ImGui");
+
     // Make sure the backbuffer is the current target.
     AddBarrier(g_backBuffer, RenderTextureLayout::COLOR_WRITE);
     FlushBarriers();
@@ -2656,6 +3088,15 @@ static std::atomic<bool> g_executedCommandList;
 
 void Video::Present() 
 {
+    TRACE_SCOPE("Present");
+
+    static bool s_traceThreadNamed;
+    if (!s_traceThreadNamed)
+    {
+        g_traceRecorder.SetThreadName("Guest Main Thread");
+        s_traceThreadNamed = true;
+    }
+
     g_readyForCommands = false;
 
     RenderCommand cmd;
@@ -2705,14 +3146,27 @@ void Video::Present()
         // Update the GPU profiler with the results from the timestamps of the frame.
         g_queryPools[g_frame]->queryResults();
         const uint64_t *frameTimestamps = g_queryPools[g_frame]->getResults();
-        g_gpuFrameProfiler.Set(double(frameTimestamps[1] - frameTimestamps[0]) / 1000000.0);
+        uint32_t queryCount = g_queryCounts[g_frame];
+        g_gpuFrameProfiler.Set(double(frameTimestamps[queryCount - 1] - frameTimestamps[0]) / 1000000.0);
+
+        if (g_traceRecorder.IsEnabled())
+        {
+            // GPU clocks aren't correlated with the CPU, so the timeline is anchored to the submission time.
+            uint64_t submitTime = g_traceRecorder.ToTraceTime(g_querySubmitTimes[g_frame]);
+            g_traceRecorder.Record("GPU Frame", "gpu", submitTime, frameTimestamps[queryCount - 1] - frameTimestamps[0], TraceRecorder::GPU_THREAD_ID, 0);
+
+            for (uint32_t i = 0; i + 1 < queryCount; i++)
+            {
+                g_traceRecorder.Record(g_queryNames[g_frame][i], "gpu", submitTime + (frameTimestamps[i] - frameTimestamps[0]),
+                    frameTimestamps[i + 1] - frameTimestamps[i], TraceRecorder::GPU_THREAD_ID, 1);
+            }
+        }
     }
 
     g_dirtyStates = DirtyStates(true);
     g_uploadAllocators[g_frame].reset();
+    g_constantUploadCaches[g_frame].Reset();
     g_intermediaryUploadAllocator.reset();
-    g_triangleFanIndexData.reset();
-    g_quadIndexData.reset();
 
     CheckSwapChain();
 
@@ -2723,23 +3177,12 @@ void Video::Present()
     {
         using namespace std::chrono_literals;
 
-        static std::chrono::steady_clock::time_point s_next;
-
-        auto now = std::chrono::steady_clock::now();
-
-        if (now < s_next)
-        {
-            std::this_thread::sleep_for(std::chrono::floor<std::chrono::milliseconds>(s_next - now - 2ms));
-
-            while ((now = std::chrono::steady_clock::now()) < s_next)
-                std::this_thread::yield();
-        }
-        else
-        {
-            s_next = now;
-        }
-
-        s_next += 1000000000ns / Config::FPS;
+        TRACE_SCOPE("Frame Pacing");
+        g_framePacer.Wait(1000000000ns / Config::FPS);
+    }
+    else
+    {
+        g_framePacer.MarkFrame(std::chrono::steady_clock::now());
     }
 
 #ifdef __ANDROID__
@@ -2753,37 +3196,223 @@ void Video::Present()
     g_presentProfiler.Reset();
 }
 
+static GuestVertexDeclaration* CreateVertexDeclarationWithoutAddRef(GuestVertexElement* vertexElements);
+
 void Video::StartPipelinePrecompilation()
 {
+    // Everything the cached pipelines reference gets registered before the game
+    // starts, so the compiler threads only ever need to look them up.
+    for (auto vertexElements : g_vertexDeclarationCache)
+        CreateVertexDeclarationWithoutAddRef(reinterpret_cast<GuestVertexElement*>(vertexElements));
+
     g_shouldPrecompilePipelines = true;
 }
 
-static void SetRootDescriptor(const UploadAllocation& allocation, size_t index)
+static RenderTextureDesc GetSurfaceTextureDesc(const GuestSurface* surface)
 {
-    auto& commandList = g_commandLists[g_frame];
+    RenderTextureDesc desc;
+    desc.dimension = RenderTextureDimension::TEXTURE_2D;
+    desc.width = surface->width;
+    desc.height = surface->height;
+    desc.depth = 1;
+    desc.mipLevels = 1;
+    desc.arraySize = 1;
+    desc.multisampling.sampleCount = surface->sampleCount;
+    desc.format = surface->format;
+    desc.flags = desc.format == RenderFormat::D32_FLOAT ? RenderTextureFlag::DEPTH_TARGET : RenderTextureFlag::RENDER_TARGET;
+    return desc;
+}
 
-    commandList->setGraphicsPushConstants(0, &allocation.deviceAddress, 8 * index, 8);
+static void CreateSurfaceTexture(GuestSurface* surface, const RenderTextureDesc& desc)
+{
+    surface->textureHolder = g_device->createTexture(desc);
+    surface->texture = surface->textureHolder.get();
+    surface->layout = RenderTextureLayout::UNKNOWN;
+
+    RenderTextureViewDesc viewDesc;
+    viewDesc.dimension = RenderTextureViewDimension::TEXTURE_2D;
+    viewDesc.format = desc.format;
+    viewDesc.mipLevels = 1;
+    surface->textureView = surface->textureHolder->createTextureView(viewDesc);
+
+    if (surface->descriptorIndex == 0)
+        surface->descriptorIndex = g_textureDescriptorAllocator.allocate();
+
+    g_textureDescriptorSet->setTexture(surface->descriptorIndex, surface->textureHolder.get(), RenderTextureLayout::SHADER_READ, surface->textureView.get());
+
+#ifdef _DEBUG 
+    surface->texture->setName(fmt::format("{} {:X}", desc.flags & RenderTextureFlag::RENDER_TARGET ? "Render Target" : "Depth Stencil", g_memory.MapVirtual(surface)));
+#endif
 }
 
-static void ProcExecuteCommandList(const RenderCommand& cmd)
-{    
-    if (g_swapChainValid)
+static void RetireFramebuffers(FramebufferVariants<RenderFramebuffer>& variants)
+{
+    for (auto& framebuffer : variants.variants)
     {
-        auto swapChainTexture = g_swapChain->getTexture(g_backBufferIndex);
-        if (g_backBuffer->texture == g_intermediaryBackBufferTexture.get())
-        {
-            struct
-            {
-                float gammaR;
-                float gammaG;
-                float gammaB;
-                uint32_t textureDescriptorIndex;
+        if (framebuffer != nullptr)
+            g_tempFramebuffers[g_frame].emplace_back(std::move(framebuffer));
+    }
+}
 
-                int32_t viewportOffsetX;
-                int32_t viewportOffsetY;
-                int32_t viewportWidth;
-                int32_t viewportHeight;
-            } constants;
+// Only meant for surfaces that don't need their contents kept, the new texture starts out undefined.
+static void ReplaceSurfaceTexture(GuestSurface* surface, const RenderTextureDesc& desc)
+{
+    auto previousTexture = surface->texture;
+
+    // The previous frame might still be using the old texture and the framebuffers made with it.
+    for (auto& [key, variants] : surface->framebuffers)
+        RetireFramebuffers(variants);
+
+    surface->framebuffers.clear();
+
+    // Depth stencil surfaces keep the framebuffers they were used in together with a render target, keyed by its texture.
+    if (surface->format != RenderFormat::D32_FLOAT)
+    {
+        for (auto& [otherSurface, lifetime] : g_surfaceLifetimes.lifetimes)
+        {
+            auto findResult = otherSurface->framebuffers.find(previousTexture);
+            if (findResult != otherSurface->framebuffers.end())
+            {
+                RetireFramebuffers(findResult->second);
+                otherSurface->framebuffers.erase(findResult);
+            }
+        }
+    }
+
+    g_tempTextureViews[g_frame].emplace_back(std::move(surface->textureView));
+    g_tempTextures[g_frame].emplace_back(std::move(surface->textureHolder));
+
+    CreateSurfaceTexture(surface, desc);
+}
+
+// Moves the given surfaces into a new heap at their planned offsets. Surfaces that were placed
+// before but aren't anymore get their own memory back.
+static void PlaceSurfaces(const std::vector<GuestSurface*>& surfaces, const std::vector<TransientResource>& resources, uint64_t heapSize)
+{
+    std::shared_ptr<RenderTexture> heap;
+
+    if (!surfaces.empty())
+    {
+        auto heapDesc = RenderTextureDesc::Texture2D(1, 1, 1, RenderFormat::R8G8B8A8_UNORM, RenderTextureFlag::RENDER_TARGET);
+        heapDesc.heapSize = heapSize;
+        heapDesc.committed = true;
+        heap = g_device->createTexture(heapDesc);
+    }
+
+    auto previousSurfaces = std::move(g_placedSurfaces);
+    g_placedSurfaces.clear();
+
+    for (size_t i = 0; i < surfaces.size(); i++)
+    {
+        auto desc = GetSurfaceTextureDesc(surfaces[i]);
+        desc.heapTexture = heap.get();
+        desc.heapOffset = resources[i].offset;
+        desc.heapRangeSize = resources[i].size;
+
+        ReplaceSurfaceTexture(surfaces[i], desc);
+        g_placedSurfaces.emplace_back(surfaces[i], resources[i]);
+    }
+
+    for (auto& [surface, resource] : previousSurfaces)
+    {
+        if (std::find(surfaces.begin(), surfaces.end(), surface) == surfaces.end())
+            ReplaceSurfaceTexture(surface, GetSurfaceTextureDesc(surface));
+    }
+
+    if (g_surfaceHeap != nullptr)
+        g_tempTextures[g_frame].emplace_back(std::move(g_surfaceHeap));
+
+    g_surfaceHeap = std::move(heap);
+    g_placedSurfaceCount = uint32_t(g_placedSurfaces.size());
+}
+
+static void UpdateTransientSurfaces()
+{
+    if (!g_aliasTransientSurfaces)
+        return;
+
+    bool placementValid = g_surfaceLifetimes.IsPlacementValid(g_placedSurfaces);
+
+    auto surfacePlan = g_surfaceLifetimes.EndFrame(SURFACE_MEMORY_ALIGNMENT);
+    g_surfaceDedicatedMemory = surfacePlan.dedicatedSize;
+    g_surfaceAliasedMemory = surfacePlan.aliasedSize;
+    g_surfaceTransientHeapMemory = surfacePlan.transientHeapSize;
+    g_transientSurfaceCount = surfacePlan.transientCount;
+
+    // Wait for the plan to settle again before placing anything, instead of going back and forth every frame.
+    if (!placementValid)
+    {
+        PlaceSurfaces({}, {}, 0);
+        g_placedSurfaceSignature = 0;
+        g_plannedSurfaceStableFrames = 0;
+    }
+
+    // Lifetimes shift around a little every frame, only the resulting placement has to stay the same.
+    XXH64_hash_t signature = 0;
+    for (size_t i = 0; i < g_surfaceLifetimes.keys.size(); i++)
+    {
+        uint64_t placement[] = { uint64_t(g_surfaceLifetimes.keys[i]), g_surfaceLifetimes.resources[i].offset, g_surfaceLifetimes.resources[i].size };
+        signature = XXH3_64bits_withSeed(placement, sizeof(placement), signature);
+    }
+
+    if (signature != g_plannedSurfaceSignature)
+    {
+        g_plannedSurfaceSignature = signature;
+        g_plannedSurfaceStableFrames = 0;
+    }
+    else if (g_plannedSurfaceStableFrames < SURFACE_PLACEMENT_STABLE_FRAMES)
+    {
+        ++g_plannedSurfaceStableFrames;
+    }
+
+    if (g_plannedSurfaceStableFrames >= SURFACE_PLACEMENT_STABLE_FRAMES && signature != g_placedSurfaceSignature)
+    {
+        PlaceSurfaces(g_surfaceLifetimes.keys, g_surfaceLifetimes.resources, surfacePlan.transientHeapSize);
+        g_placedSurfaceSignature = signature;
+    }
+
+    // Placed surfaces start every frame undefined. Their first use transitions them from an undefined layout,
+    // and waits on whatever used the memory before them.
+    for (auto& [surface, resource] : g_placedSurfaces)
+    {
+        surface->layout = RenderTextureLayout::UNKNOWN;
+        surface->discardOnBarrier = true;
+    }
+}
+
+static void SetRootDescriptor(const UploadAllocation& allocation, size_t index)
+{
+    auto& commandList = g_commandLists[g_frame];
+
+    commandList->setGraphicsPushConstants(0, &allocation.deviceAddress, 8 * index, 8);
+}
+
+static void ProcExecuteCommandList(const RenderCommand& cmd)
+{    
+    TRACE_SCOPE("ExecuteCommandList");
+
+    UpdateTransientSurfaces();
+
+    g_discardedLoadCount = std::exchange(g_frameDiscardedLoadCount, 0);
+    g_discardedLoadMemory = std::exchange(g_frameDiscardedLoadMemory, 0);
+
+    if (g_swapChainValid)
+    {
+        auto swapChainTexture = g_swapChain->getTexture(g_backBufferIndex);
+        if (g_backBuffer->texture == g_intermediaryBackBufferTexture.get())
+        {
+            struct
+            {
+                float gammaR;
+                float gammaG;
+                float gammaB;
+                uint32_t textureDescriptorIndex;
+
+                int32_t viewportOffsetX;
+                int32_t viewportOffsetY;
+                int32_t viewportWidth;
+                int32_t viewportHeight;
+            } constants;
 
             if (Config::XboxColorCorrection)
             {
@@ -2810,12 +3439,14 @@ static void ProcExecuteCommandList(const RenderCommand& cmd)
             constants.viewportWidth = Video::s_viewportWidth;
             constants.viewportHeight = Video::s_viewportHeight;
 
-            auto &framebuffer = g_backBuffer->framebuffers[swapChainTexture];
+            // Gamma correction writes every pixel of the swap chain, letterboxing included.
+            auto &framebuffer = g_backBuffer->framebuffers[swapChainTexture][RENDER_PASS_DISCARD_COLOR];
             if (!framebuffer)
             {
                 RenderFramebufferDesc desc;
                 desc.colorAttachments = const_cast<const RenderTexture **>(&swapChainTexture);
                 desc.colorAttachmentsCount = 1;
+                desc.colorAttachmentsDiscarded = true;
                 framebuffer = g_device->createFramebuffer(desc);
             }
 
@@ -2832,6 +3463,7 @@ static void ProcExecuteCommandList(const RenderCommand& cmd)
             commandList->setGraphicsDescriptorSet(g_textureDescriptorSet.get(), 0);
             SetRootDescriptor(g_uploadAllocators[g_frame].allocate<false>(&constants, sizeof(constants), 0x100), 2);
             commandList->setFramebuffer(framebuffer.get());
+            RecordDiscardedLoad(g_swapChain->getWidth(), g_swapChain->getHeight(), BACKBUFFER_FORMAT, RenderSampleCount::COUNT_1);
             commandList->setViewports(RenderViewport(0.0f, 0.0f, g_swapChain->getWidth(), g_swapChain->getHeight()));
             commandList->setScissors(RenderRect(0, 0, g_swapChain->getWidth(), g_swapChain->getHeight()));
             commandList->drawInstanced(6, 1, 0, 0);
@@ -2844,9 +3476,15 @@ static void ProcExecuteCommandList(const RenderCommand& cmd)
         }
     }
 
+    PublishBarrierStats();
+    PublishConstantUploadStats();
+
     auto &commandList = g_commandLists[g_frame];
-    commandList->writeTimestamp(g_queryPools[g_frame].get(), 1);
+    g_queryNames[g_frame][g_queryCounts[g_frame]] = "Frame End";
+    commandList->writeTimestamp(g_queryPools[g_frame].get(), g_queryCounts[g_frame]);
+    ++g_queryCounts[g_frame];
     commandList->end();
+    g_querySubmitTimes[g_frame] = std::chrono::steady_clock::now();
 
     if (g_swapChainValid)
     {
@@ -2871,10 +3509,269 @@ static void ProcExecuteCommandList(const RenderCommand& cmd)
     g_executedCommandList.notify_one();
 }
 
+// Description of the texture with its top mip levels dropped.
+static RenderTextureDesc GetDowngradedTextureDesc(const RenderTextureDesc& desc, uint32_t droppedMipLevels)
+{
+    auto result = desc;
+    result.width = std::max(1u, desc.width >> droppedMipLevels);
+    result.height = std::max(1u, desc.height >> droppedMipLevels);
+    result.mipLevels = desc.mipLevels - droppedMipLevels;
+
+    if (desc.dimension == RenderTextureDimension::TEXTURE_3D)
+        result.depth = std::max(1u, desc.depth >> droppedMipLevels);
+
+    return result;
+}
+
+// Layout of a mip level kept in host memory, every array slice of it one after another.
+struct DroppedMipLevelLayout
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;
+    uint32_t rowWidth;
+    uint32_t slicePitch;
+    uint32_t sliceCount;
+};
+
+static DroppedMipLevelLayout GetDroppedMipLevelLayout(const RenderTextureDesc& desc, uint32_t mipLevel)
+{
+    uint32_t blockWidth = RenderFormatBlockWidth(desc.format);
+    uint32_t blockSize = RenderFormatSize(desc.format);
+
+    DroppedMipLevelLayout layout;
+    layout.width = std::max(1u, desc.width >> mipLevel);
+    layout.height = std::max(1u, desc.height >> mipLevel);
+    layout.depth = desc.dimension == RenderTextureDimension::TEXTURE_3D ? std::max(1u, desc.depth >> mipLevel) : 1;
+
+    uint32_t rowPitch = (((layout.width + blockWidth - 1) / blockWidth) * blockSize + PITCH_ALIGNMENT - 1) & ~(PITCH_ALIGNMENT - 1);
+    uint32_t rowCount = (layout.height + blockWidth - 1) / blockWidth;
+
+    layout.rowWidth = rowPitch / blockSize * blockWidth;
+    layout.slicePitch = (rowPitch * rowCount * layout.depth + PLACEMENT_ALIGNMENT - 1) & ~(PLACEMENT_ALIGNMENT - 1);
+    layout.sliceCount = desc.dimension == RenderTextureDimension::TEXTURE_3D ? 1 : desc.arraySize;
+    return layout;
+}
+
+static RenderBox GetMipLevelBox(const RenderTextureDesc& desc, uint32_t mipLevel)
+{
+    return RenderBox(0, 0, std::max(1u, desc.width >> mipLevel), std::max(1u, desc.height >> mipLevel), 0,
+        desc.dimension == RenderTextureDimension::TEXTURE_3D ? std::max(1u, desc.depth >> mipLevel) : 1);
+}
+
+// Swaps in a rebuilt texture. The previous frame might still be sampling the old one.
+static void ReplaceLoadedTexture(GuestTexture* texture, std::shared_ptr<RenderTexture> newTexture, std::unique_ptr<RenderTextureView> newTextureView)
+{
+    g_textureDescriptorSet->setTexture(texture->descriptorIndex, newTexture.get(), RenderTextureLayout::SHADER_READ, newTextureView.get());
+
+    g_tempTextureViews[g_frame].emplace_back(std::move(texture->textureView));
+    g_tempTextures[g_frame].emplace_back(std::move(texture->textureHolder));
+
+    texture->textureHolder = std::move(newTexture);
+    texture->texture = texture->textureHolder.get();
+    texture->textureView = std::move(newTextureView);
+    texture->layout = RenderTextureLayout::SHADER_READ;
+}
+
+// Rebuilds the texture without its top mip level by copying the remaining levels over on the GPU. The dropped level
+// gets copied to host memory. Returns the amount of memory freed, or zero if the texture can't get any smaller.
+static uint64_t DowngradeTexture(GuestTexture* texture)
+{
+    uint32_t droppedCount = uint32_t(texture->droppedMipLevels.size());
+    auto oldDesc = GetDowngradedTextureDesc(texture->desc, droppedCount);
+    uint32_t blockWidth = RenderFormatBlockWidth(oldDesc.format);
+
+    if (oldDesc.mipLevels <= 1 || (oldDesc.width / 2) < blockWidth || (oldDesc.height / 2) < blockWidth)
+        return 0;
+
+    auto desc = GetDowngradedTextureDesc(texture->desc, droppedCount + 1);
+
+    auto viewDesc = texture->viewDesc;
+    viewDesc.mipLevels = desc.mipLevels;
+
+    std::shared_ptr<RenderTexture> newTexture = g_device->createTexture(desc);
+    auto newTextureView = newTexture->createTextureView(viewDesc);
+
+    auto levelLayout = GetDroppedMipLevelLayout(texture->desc, droppedCount);
+    auto levelBuffer = g_device->createBuffer(RenderBufferDesc::ReadbackBuffer(uint64_t(levelLayout.slicePitch) * levelLayout.sliceCount));
+
+    auto& commandList = g_commandLists[g_frame];
+
+    RenderTextureBarrier copyBarriers[] =
+    {
+        RenderTextureBarrier(texture->texture, RenderTextureLayout::COPY_SOURCE),
+        RenderTextureBarrier(newTexture.get(), RenderTextureLayout::COPY_DEST)
+    };
+
+    commandList->barriers(RenderBarrierStage::COPY, copyBarriers, std::size(copyBarriers));
+
+    for (uint32_t arrayIndex = 0; arrayIndex < levelLayout.sliceCount; arrayIndex++)
+    {
+        commandList->copyTextureRegion(
+            RenderTextureCopyLocation::PlacedFootprint(levelBuffer.get(), desc.format, levelLayout.width, levelLayout.height, levelLayout.depth,
+                levelLayout.rowWidth, uint64_t(levelLayout.slicePitch) * arrayIndex),
+            RenderTextureCopyLocation::Subresource(texture->texture, 0, arrayIndex));
+
+        for (uint32_t mipLevel = 0; mipLevel < desc.mipLevels; mipLevel++)
+        {
+            auto srcBox = GetMipLevelBox(oldDesc, mipLevel + 1);
+            commandList->copyTextureRegion(
+                RenderTextureCopyLocation::Subresource(newTexture.get(), mipLevel, arrayIndex),
+                RenderTextureCopyLocation::Subresource(texture->texture, mipLevel + 1, arrayIndex), 0, 0, 0, &srcBox);
+        }
+    }
+
+    commandList->barriers(RenderBarrierStage::GRAPHICS, RenderTextureBarrier(newTexture.get(), RenderTextureLayout::SHADER_READ));
+
+    ReplaceLoadedTexture(texture, std::move(newTexture), std::move(newTextureView));
+    texture->viewDesc = viewDesc;
+    texture->droppedMipLevels.emplace_back(std::move(levelBuffer));
+    texture->droppedFrame = g_residencyFrame.load();
+
+    uint64_t oldMemorySize = texture->memorySize;
+    texture->memorySize = ComputeTextureMemorySize(desc);
+    g_textureResidency.Shrink(texture, texture->memorySize);
+
+    return oldMemorySize - texture->memorySize;
+}
+
+static uint32_t g_textureRestoresThisFrame;
+
+// Rebuilds a downgraded texture at its full size, once the copies of its dropped levels are done.
+static void RestoreTexture(GuestTexture* texture)
+{
+    if (g_textureRestoresThisFrame >= RESIDENCY_MAX_RESTORES_PER_FRAME || (g_residencyFrame.load() - texture->droppedFrame) < NUM_FRAMES)
+        return;
+
+    ++g_textureRestoresThisFrame;
+
+    uint32_t droppedCount = uint32_t(texture->droppedMipLevels.size());
+    auto oldDesc = GetDowngradedTextureDesc(texture->desc, droppedCount);
+
+    auto viewDesc = texture->viewDesc;
+    viewDesc.mipLevels = texture->desc.mipLevels;
+
+    std::shared_ptr<RenderTexture> newTexture = g_device->createTexture(texture->desc);
+    auto newTextureView = newTexture->createTextureView(viewDesc);
+
+    uint64_t uploadSize = 0;
+    for (uint32_t mipLevel = 0; mipLevel < droppedCount; mipLevel++)
+    {
+        auto levelLayout = GetDroppedMipLevelLayout(texture->desc, mipLevel);
+        uploadSize += uint64_t(levelLayout.slicePitch) * levelLayout.sliceCount;
+    }
+
+    auto uploadBuffer = g_device->createBuffer(RenderBufferDesc::UploadBuffer(uploadSize));
+    auto uploadMemory = reinterpret_cast<uint8_t*>(uploadBuffer->map());
+
+    uint64_t levelOffset = 0;
+    for (uint32_t mipLevel = 0; mipLevel < droppedCount; mipLevel++)
+    {
+        auto levelLayout = GetDroppedMipLevelLayout(texture->desc, mipLevel);
+        uint64_t levelSize = uint64_t(levelLayout.slicePitch) * levelLayout.sliceCount;
+
+        auto& levelBuffer = texture->droppedMipLevels[mipLevel];
+        memcpy(uploadMemory + levelOffset, levelBuffer->map(), levelSize);
+        levelBuffer->unmap();
+        levelOffset += levelSize;
+    }
+
+    uploadBuffer->unmap();
+
+    auto& commandList = g_commandLists[g_frame];
+
+    RenderTextureBarrier copyBarriers[] =
+    {
+        RenderTextureBarrier(texture->texture, RenderTextureLayout::COPY_SOURCE),
+        RenderTextureBarrier(newTexture.get(), RenderTextureLayout::COPY_DEST)
+    };
+
+    commandList->barriers(RenderBarrierStage::COPY, copyBarriers, std::size(copyBarriers));
+
+    levelOffset = 0;
+    for (uint32_t mipLevel = 0; mipLevel < droppedCount; mipLevel++)
+    {
+        auto levelLayout = GetDroppedMipLevelLayout(texture->desc, mipLevel);
+
+        for (uint32_t arrayIndex = 0; arrayIndex < levelLayout.sliceCount; arrayIndex++)
+        {
+            commandList->copyTextureRegion(
+                RenderTextureCopyLocation::Subresource(newTexture.get(), mipLevel, arrayIndex),
+                RenderTextureCopyLocation::PlacedFootprint(uploadBuffer.get(), texture->desc.format, levelLayout.width, levelLayout.height, levelLayout.depth,
+                    levelLayout.rowWidth, levelOffset + uint64_t(levelLayout.slicePitch) * arrayIndex));
+        }
+
+        levelOffset += uint64_t(levelLayout.slicePitch) * levelLayout.sliceCount;
+    }
+
+    uint32_t arraySize = (oldDesc.dimension == RenderTextureDimension::TEXTURE_3D) ? 1 : oldDesc.arraySize;
+    for (uint32_t arrayIndex = 0; arrayIndex < arraySize; arrayIndex++)
+    {
+        for (uint32_t mipLevel = 0; mipLevel < oldDesc.mipLevels; mipLevel++)
+        {
+            auto srcBox = GetMipLevelBox(oldDesc, mipLevel);
+            commandList->copyTextureRegion(
+                RenderTextureCopyLocation::Subresource(newTexture.get(), mipLevel + droppedCount, arrayIndex),
+                RenderTextureCopyLocation::Subresource(texture->texture, mipLevel, arrayIndex), 0, 0, 0, &srcBox);
+        }
+    }
+
+    commandList->barriers(RenderBarrierStage::GRAPHICS, RenderTextureBarrier(newTexture.get(), RenderTextureLayout::SHADER_READ));
+
+    g_tempBuffers[g_frame].emplace_back(std::move(uploadBuffer));
+
+    ReplaceLoadedTexture(texture, std::move(newTexture), std::move(newTextureView));
+    texture->viewDesc = viewDesc;
+
+    // Nothing reads the dropped levels anymore, the copies into them finished frames ago.
+    texture->droppedMipLevels.clear();
+
+    texture->memorySize = ComputeTextureMemorySize(texture->desc);
+    g_textureResidency.Restore(texture, texture->memorySize);
+}
+
+static void EnforceTextureBudget()
+{
+    std::lock_guard lock(g_textureResidencyMutex);
+
+    uint64_t overBudget = g_textureResidency.GetOverBudget();
+    if (overBudget == 0)
+        return;
+
+    // Textures with replacements bound in their place are left alone.
+    auto candidates = g_textureResidency.FindLeastRecentlyUsed(g_residencyFrame.load(), RESIDENCY_MIN_IDLE_FRAMES, [](GuestTexture* texture)
+        {
+            return texture->patchedTexture == nullptr && texture->recreatedCubeMapTexture == nullptr &&
+                (texture->desc.mipLevels - texture->droppedMipLevels.size()) > 1;
+        });
+
+    uint32_t downgradeCount = 0;
+    uint64_t freedMemory = 0;
+
+    for (auto texture : candidates)
+    {
+        if (downgradeCount >= RESIDENCY_MAX_DOWNGRADES_PER_FRAME || freedMemory >= overBudget)
+            break;
+
+        uint64_t textureFreedMemory = DowngradeTexture(texture);
+        if (textureFreedMemory != 0)
+        {
+            freedMemory += textureFreedMemory;
+            ++downgradeCount;
+        }
+    }
+}
+
 static void ProcBeginCommandList(const RenderCommand& cmd)
 {
+    TRACE_SCOPE("BeginCommandList");
+
     DestructTempResources();
     BeginCommandList();
+
+    ++g_residencyFrame;
+    g_textureRestoresThisFrame = 0;
+    EnforceTextureBudget();
 }
 
 static GuestSurface* GetBackBuffer() 
@@ -3068,25 +3965,13 @@ static GuestSurface* CreateSurface(uint32_t width, uint32_t height, uint32_t for
     auto surface = g_userHeap.AllocPhysical<GuestSurface>(desc.format == RenderFormat::D32_FLOAT ? 
         ResourceType::DepthStencil : ResourceType::RenderTarget);
 
-    surface->textureHolder = g_device->createTexture(desc);
-    surface->texture = surface->textureHolder.get();
     surface->width = width;
     surface->height = height;
     surface->format = desc.format;
     surface->guestFormat = format;
     surface->sampleCount = desc.multisampling.sampleCount;
 
-    RenderTextureViewDesc viewDesc;
-    viewDesc.dimension = RenderTextureViewDimension::TEXTURE_2D;
-    viewDesc.format = desc.format;
-    viewDesc.mipLevels = 1;
-    surface->textureView = surface->textureHolder->createTextureView(viewDesc);
-    surface->descriptorIndex = g_textureDescriptorAllocator.allocate();
-    g_textureDescriptorSet->setTexture(surface->descriptorIndex, surface->textureHolder.get(), RenderTextureLayout::SHADER_READ, surface->textureView.get());
-
-#ifdef _DEBUG 
-    surface->texture->setName(fmt::format("{} {:X}", desc.flags & RenderTextureFlag::RENDER_TARGET ? "Render Target" : "Depth Stencil", g_memory.MapVirtual(surface)));
-#endif
+    CreateSurfaceTexture(surface, desc);
 
     return surface;
 }
@@ -3207,8 +4092,10 @@ static void ProcSetRenderTarget(const RenderCommand& cmd)
     const auto& args = cmd.setRenderTarget;
 
     SetDirtyValue(g_dirtyStates.renderTargetAndDepthStencil, g_renderTarget, args.renderTarget);
-    SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.renderTargetFormat, args.renderTarget != nullptr ? args.renderTarget->format : RenderFormat::UNKNOWN);
-    SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.sampleCount, args.renderTarget != nullptr ? args.renderTarget->sampleCount : RenderSampleCount::COUNT_1);
+    g_surfaceDrawUseRecorded = false;
+
+    SetPipelineStateValue(g_pipelineState.renderTargetFormat, args.renderTarget != nullptr ? args.renderTarget->format : RenderFormat::UNKNOWN);
+    SetPipelineStateValue(g_pipelineState.sampleCount, args.renderTarget != nullptr ? args.renderTarget->sampleCount : RenderSampleCount::COUNT_1);
 
     // When alpha to coverage is enabled, update the alpha test mode as it's dependent on sample count.
     SetAlphaTestMode((g_pipelineState.specConstants & (SPEC_CONSTANT_ALPHA_TEST | SPEC_CONSTANT_ALPHA_TO_COVERAGE)) != 0);
@@ -3229,7 +4116,9 @@ static void ProcSetDepthStencilSurface(const RenderCommand& cmd)
     const auto& args = cmd.setDepthStencilSurface;
 
     SetDirtyValue(g_dirtyStates.renderTargetAndDepthStencil, g_depthStencil, args.depthStencil);
-    SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.depthStencilFormat, args.depthStencil != nullptr ? args.depthStencil->format : RenderFormat::UNKNOWN);
+    g_surfaceDrawUseRecorded = false;
+
+    SetPipelineStateValue(g_pipelineState.depthStencilFormat, args.depthStencil != nullptr ? args.depthStencil->format : RenderFormat::UNKNOWN);
 }
 
 static bool PopulateBarriersForStretchRect(GuestSurface* renderTarget, GuestSurface* depthStencil)
@@ -3303,6 +4192,8 @@ static void ExecutePendingStretchRectCommands(GuestSurface* renderTarget, GuestS
         {
             const bool multiSampling = surface->sampleCount != RenderSampleCount::COUNT_1;
 
+            RecordSurfaceUse(surface, false);
+
             for (const auto texture : surface->destinationTextures)
             {
                 bool shaderResolve = true;
@@ -3377,12 +4268,14 @@ static void ExecutePendingStretchRectCommands(GuestSurface* renderTarget, GuestS
                         }
                     }
 
+                    // The copy overwrites the whole texture, nothing that was in it before has to be loaded.
                     if (texture->framebuffer == nullptr)
                     {
                         if (texture->format == RenderFormat::D32_FLOAT)
                         {
                             RenderFramebufferDesc desc;
                             desc.depthAttachment = texture->texture;
+                            desc.depthAttachmentDiscarded = true;
                             texture->framebuffer = g_device->createFramebuffer(desc);
                         }
                         else
@@ -3390,6 +4283,7 @@ static void ExecutePendingStretchRectCommands(GuestSurface* renderTarget, GuestS
                             RenderFramebufferDesc desc;
                             desc.colorAttachments = const_cast<const RenderTexture**>(&texture->texture);
                             desc.colorAttachmentsCount = 1;
+                            desc.colorAttachmentsDiscarded = true;
                             texture->framebuffer = g_device->createFramebuffer(desc);
                         }
                     }
@@ -3398,6 +4292,7 @@ static void ExecutePendingStretchRectCommands(GuestSurface* renderTarget, GuestS
                     {
                         commandList->setFramebuffer(texture->framebuffer.get());
                         g_framebuffer = texture->framebuffer.get();
+                        RecordDiscardedLoad(texture->width, texture->height, texture->format, RenderSampleCount::COUNT_1);
                     }
 
                     commandList->setPipeline(pipeline);
@@ -3461,7 +4356,7 @@ static void ProcExecutePendingStretchRectCommands(const RenderCommand& cmd)
     g_pendingMsaaResolves.clear();
 }
 
-static void SetFramebuffer(GuestSurface* renderTarget, GuestSurface* depthStencil, bool settingForClear)
+static void SetFramebuffer(GuestSurface* renderTarget, GuestSurface* depthStencil, bool settingForClear, uint32_t discard)
 {
     if (settingForClear || g_dirtyStates.renderTargetAndDepthStencil)
     {
@@ -3488,7 +4383,9 @@ static void SetFramebuffer(GuestSurface* renderTarget, GuestSurface* depthStenci
 
         if (framebufferContainer != nullptr)
         {
-            auto& framebuffer = framebufferContainer->framebuffers[framebufferKey];
+            auto& variants = framebufferContainer->framebuffers[framebufferKey];
+            uint32_t variant = variants.Select(g_framebuffer, discard);
+            auto& framebuffer = variants[variant];
 
             if (framebuffer == nullptr)
             {
@@ -3498,18 +4395,29 @@ static void SetFramebuffer(GuestSurface* renderTarget, GuestSurface* depthStenci
                 {
                     desc.colorAttachments = const_cast<const RenderTexture**>(&renderTarget->texture);
                     desc.colorAttachmentsCount = 1;
+                    desc.colorAttachmentsDiscarded = (variant & RENDER_PASS_DISCARD_COLOR) != 0;
                 }
 
                 if (depthStencil != nullptr)
+                {
                     desc.depthAttachment = depthStencil->texture;
+                    desc.depthAttachmentDiscarded = (variant & RENDER_PASS_DISCARD_DEPTH) != 0;
+                }
 
                 framebuffer = g_device->createFramebuffer(desc);
             }
 
             if (g_framebuffer != framebuffer.get())
             {
+                WriteTimestamp(renderTarget == nullptr ? "Depth Pass" : "Render Pass");
                 commandList->setFramebuffer(framebuffer.get());
                 g_framebuffer = framebuffer.get();
+
+                if ((variant & RENDER_PASS_DISCARD_COLOR) != 0)
+                    RecordDiscardedLoad(renderTarget->width, renderTarget->height, renderTarget->format, renderTarget->sampleCount);
+
+                if ((variant & RENDER_PASS_DISCARD_DEPTH) != 0)
+                    RecordDiscardedLoad(depthStencil->width, depthStencil->height, depthStencil->format, depthStencil->sampleCount);
             }
         }
         else if (g_framebuffer != nullptr)
@@ -3558,25 +4466,31 @@ static void ProcClear(const RenderCommand& cmd)
     bool canClearInOnePass = (g_renderTarget == nullptr) || (g_depthStencil == nullptr) ||
         (g_renderTarget->width == g_depthStencil->width && g_renderTarget->height == g_depthStencil->height);
 
+    // A clear right after binding the targets starts the render pass, so the attachments it covers don't need to be loaded.
+    uint32_t discard = GetClearDiscard(g_renderTarget != nullptr, g_depthStencil != nullptr,
+        (args.flags & D3DCLEAR_TARGET) != 0, (args.flags & D3DCLEAR_ZBUFFER) != 0);
+
     if (canClearInOnePass)
-        SetFramebuffer(g_renderTarget, g_depthStencil, true);
+        SetFramebuffer(g_renderTarget, g_depthStencil, true, discard);
 
     auto& commandList = g_commandLists[g_frame];
 
     if (g_renderTarget != nullptr && (args.flags & D3DCLEAR_TARGET) != 0)
     {
         if (!canClearInOnePass)
-            SetFramebuffer(g_renderTarget, nullptr, true);
+            SetFramebuffer(g_renderTarget, nullptr, true, RENDER_PASS_DISCARD_COLOR);
 
         commandList->clearColor(0, RenderColor(args.color[0], args.color[1], args.color[2], args.color[3]));
+        RecordSurfaceUse(g_renderTarget, true);
     }
 
     if (g_depthStencil != nullptr && (args.flags & D3DCLEAR_ZBUFFER) != 0)
     {
         if (!canClearInOnePass)
-            SetFramebuffer(nullptr, g_depthStencil, true);
+            SetFramebuffer(nullptr, g_depthStencil, true, RENDER_PASS_DISCARD_DEPTH);
 
         commandList->clearDepth(true, args.z);
+        RecordSurfaceUse(g_depthStencil, true);
     }
 }
 
@@ -3617,7 +4531,7 @@ static void ProcSetViewport(const RenderCommand& cmd)
     else 
         specConstants &= ~SPEC_CONSTANT_REVERSE_Z;
 
-    SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.specConstants, specConstants);
+    SetPipelineStateValue(g_pipelineState.specConstants, specConstants);
 
     g_dirtyStates.scissorRect |= g_dirtyStates.viewport;
 }
@@ -3641,6 +4555,17 @@ static void SetTexture(GuestDevice* device, uint32_t index, GuestTexture* textur
 
 static void SetTextureInRenderThread(uint32_t index, GuestTexture* texture)
 {
+    if (texture != nullptr)
+    {
+        texture->lastUsedFrame = g_residencyFrame.load();
+
+        if (!texture->droppedMipLevels.empty())
+        {
+            std::lock_guard lock(g_textureResidencyMutex);
+            RestoreTexture(texture);
+        }
+    }
+
     AddBarrier(texture, RenderTextureLayout::SHADER_READ);
 
     auto viewDimension = texture != nullptr ? texture->viewDimension : RenderTextureViewDimension::UNKNOWN;
@@ -3666,6 +4591,7 @@ static void SetTextureInRenderThread(uint32_t index, GuestTexture* texture)
 static void SetSurface(uint32_t index, GuestSurface* surface)
 {
     AddBarrier(surface, RenderTextureLayout::SHADER_READ);
+    RecordSurfaceUse(surface, false);
 
     SetDirtyValue(g_dirtyStates.sharedConstants, g_sharedConstants.texture2DIndices[index], surface->descriptorIndex);
     SetDirtyValue(g_dirtyStates.sharedConstants, g_sharedConstants.texture3DIndices[index], uint32_t(TEXTURE_DESCRIPTOR_NULL_TEXTURE_3D));
@@ -3733,11 +4659,20 @@ static RenderShader* GetOrLinkShader(GuestShader* guestShader, uint32_t specCons
 
             if (g_vulkan)
             {
-                auto compressedSpirvData = g_shaderCache.get() + guestShader->shaderCacheEntry->spirvOffset;
+                // Specialization is done through pipeline constants on Vulkan, so one module serves every variant.
+                TRACE_SCOPE("CreateShader");
 
-                std::vector<uint8_t> decoded(smolv::GetDecodedBufferSize(compressedSpirvData, guestShader->shaderCacheEntry->spirvSize));
-                bool result = smolv::Decode(compressedSpirvData, guestShader->shaderCacheEntry->spirvSize, decoded.data(), decoded.size());
-                assert(result);
+                std::vector<uint8_t> decoded;
+                if (!g_shaderModuleCache.Load(guestShader->shaderCacheEntry->hash, 0, decoded))
+                {
+                    auto compressedSpirvData = g_shaderCache.get() + guestShader->shaderCacheEntry->spirvOffset;
+
+                    decoded.resize(smolv::GetDecodedBufferSize(compressedSpirvData, guestShader->shaderCacheEntry->spirvSize));
+                    bool result = smolv::Decode(compressedSpirvData, guestShader->shaderCacheEntry->spirvSize, decoded.data(), decoded.size());
+                    assert(result);
+
+                    g_shaderModuleCache.Store(guestShader->shaderCacheEntry->hash, 0, decoded.data(), decoded.size());
+                }
 
                 guestShader->shader = g_device->createShader(decoded.data(), decoded.size(), "main", RenderShaderFormat::SPIRV);
             }
@@ -3760,6 +4695,21 @@ static RenderShader* GetOrLinkShader(GuestShader* guestShader, uint32_t specCons
     }
 
 #ifdef UNLEASHED_RECOMP_D3D12
+    if (shader == nullptr)
+    {
+        std::vector<uint8_t> linkedData;
+        if (g_shaderModuleCache.Load(guestShader->shaderCacheEntry->hash, specConstants, linkedData))
+        {
+            std::lock_guard lock(guestShader->mutex);
+
+            auto& linkedShader = guestShader->linkedShaders[specConstants];
+            if (linkedShader == nullptr)
+                linkedShader = g_device->createShader(linkedData.data(), linkedData.size(), "main", RenderShaderFormat::DXIL);
+
+            shader = linkedShader.get();
+        }
+    }
+
     if (shader == nullptr)
     {
         static Mutex g_compiledSpecConstantLibraryBlobMutex;
@@ -3857,6 +4807,8 @@ static RenderShader* GetOrLinkShader(GuestShader* guestShader, uint32_t specCons
         hr = result->GetResult(blob.GetAddressOf());
         assert(SUCCEEDED(hr) && blob != nullptr);
 
+        g_shaderModuleCache.Store(guestShader->shaderCacheEntry->hash, specConstants, blob->GetBufferPointer(), blob->GetBufferSize());
+
         {
             std::lock_guard lock(guestShader->mutex);
 
@@ -3921,7 +4873,7 @@ static void SanitizePipelineState(PipelineState& pipelineState)
     pipelineState.specConstants &= specConstantsMask;
 }
 
-static std::unique_ptr<RenderPipeline> CreateGraphicsPipeline(const PipelineState& pipelineState)
+static std::unique_ptr<RenderPipeline> CreateGraphicsPipeline(const PipelineState& pipelineState, bool fastLink = false)
 {
 #ifdef ASYNC_PSO_DEBUG
     ++g_pipelinesCurrentlyCompiling;
@@ -3989,6 +4941,7 @@ static std::unique_ptr<RenderPipeline> CreateGraphicsPipeline(const PipelineStat
     
     desc.inputSlots = inputSlots;
     desc.inputSlotsCount = inputSlotCount;
+    desc.fastLink = fastLink;
     
     auto pipeline = g_device->createGraphicsPipeline(desc);
 
@@ -3999,15 +4952,35 @@ static std::unique_ptr<RenderPipeline> CreateGraphicsPipeline(const PipelineStat
     return pipeline;
 }
 
-static RenderPipeline* CreateGraphicsPipelineInRenderThread(PipelineState pipelineState)
+static void EnqueuePipelineOptimization(XXH64_hash_t hash, const PipelineState& pipelineState);
+
+static RenderPipeline* CreateGraphicsPipelineInRenderThread(PipelineState pipelineState, XXH64_hash_t& hash)
 {
     SanitizePipelineState(pipelineState);
 
-    XXH64_hash_t hash = XXH3_64bits(&pipelineState, sizeof(pipelineState));
+    hash = XXH3_64bits(&pipelineState, sizeof(pipelineState));
     auto& pipeline = g_pipelines[hash];
     if (pipeline == nullptr)
     {
-        pipeline = CreateGraphicsPipeline(pipelineState);
+        // A draw is waiting on this, so link it out of pipeline libraries and let the full compile happen in the background.
+        if (g_capabilities.graphicsPipelineLibrary)
+        {
+            pipeline = CreateGraphicsPipeline(pipelineState, true);
+            g_fastLinkedPipelines.emplace(hash);
+            ++g_fastLinkedPipelineCount;
+            EnqueuePipelineOptimization(hash, pipelineState);
+        }
+        else
+        {
+            pipeline = CreateGraphicsPipeline(pipelineState);
+        }
+
+        ++g_pipelineCount;
+
+        {
+            std::lock_guard lock(g_pipelinesCompiledInRenderThreadMutex);
+            g_pipelinesCompiledInRenderThread.emplace(hash);
+        }
 
 #ifdef ASYNC_PSO_DEBUG
         bool loading = *SWA::SGlobals::ms_IsLoading;
@@ -4095,6 +5068,27 @@ static RenderPipeline* CreateGraphicsPipelineInRenderThread(PipelineState pipeli
     return pipeline.get();
 }
 
+// Maps the incremental hash of g_pipelineState to the hash of its sanitized copy, which is what g_pipelines is keyed by.
+// States the render thread has seen before skip sanitizing and hashing the whole struct. Only touched by the render thread.
+static xxHashMap<XXH64_hash_t> g_sanitizedPipelineStateHashes;
+
+static RenderPipeline* GetGraphicsPipelineInRenderThread()
+{
+    auto [sanitizedHash, inserted] = g_sanitizedPipelineStateHashes.try_emplace(g_pipelineStateHash.Get());
+    if (!inserted)
+    {
+        auto findResult = g_pipelines.find(sanitizedHash->second);
+        if (findResult != g_pipelines.end() && findResult->second != nullptr)
+        {
+            ++g_pipelineLookupHits;
+            return findResult->second.get();
+        }
+    }
+
+    ++g_pipelineLookupMisses;
+    return CreateGraphicsPipelineInRenderThread(g_pipelineState, sanitizedHash->second);
+}
+
 static RenderTextureAddressMode ConvertTextureAddressMode(size_t value)
 {
     switch (value)
@@ -4235,48 +5229,49 @@ static void ProcSetSamplerState(const RenderCommand& cmd)
 {
     const auto& args = cmd.setSamplerState;
 
-    const auto addressU = ConvertTextureAddressMode((args.data0 >> 10) & 0x7);
-    const auto addressV = ConvertTextureAddressMode((args.data0 >> 13) & 0x7);
-    const auto addressW = ConvertTextureAddressMode((args.data0 >> 16) & 0x7);
-    auto magFilter = ConvertTextureFilter((args.data3 >> 19) & 0x3);
-    auto minFilter = ConvertTextureFilter((args.data3 >> 21) & 0x3);
-    auto mipFilter = ConvertTextureFilter((args.data3 >> 23) & 0x3);
-    const auto borderColor = ConvertBorderColor(args.data5 & 0x3);
+    uint32_t maxAnisotropy = std::min(Config::AnisotropicFiltering.Value, 16u);
+    uint32_t samplerKey = PackSamplerKey(args.data0, args.data3, args.data5, maxAnisotropy);
 
-    bool anisotropyEnabled = Config::AnisotropicFiltering > 0 && mipFilter == RenderFilter::LINEAR;
-    if (anisotropyEnabled)
-    {
-        magFilter = RenderFilter::LINEAR;
-        minFilter = RenderFilter::LINEAR;
-    }
+    if (g_samplerKeys[args.index] == samplerKey)
+        return;
 
-    auto& samplerDesc = g_samplerDescs[args.index];
+    g_samplerKeys[args.index] = samplerKey;
 
-    bool dirty = false;
-
-    SetDirtyValue(dirty, samplerDesc.addressU, addressU);
-    SetDirtyValue(dirty, samplerDesc.addressV, addressV);
-    SetDirtyValue(dirty, samplerDesc.addressW, addressW);
-    SetDirtyValue(dirty, samplerDesc.minFilter, minFilter);
-    SetDirtyValue(dirty, samplerDesc.magFilter, magFilter);
-    SetDirtyValue(dirty, samplerDesc.mipmapMode, RenderMipmapMode(mipFilter));
-    SetDirtyValue(dirty, samplerDesc.maxAnisotropy, anisotropyEnabled ? Config::AnisotropicFiltering : 16u);
-    SetDirtyValue(dirty, samplerDesc.anisotropyEnabled, anisotropyEnabled);
-    SetDirtyValue(dirty, samplerDesc.borderColor, borderColor);
-
-    if (dirty)
+    auto [samplerId, created] = g_samplerTable.Intern(samplerKey);
+    if (samplerId == g_samplerTable.INVALID_ID)
     {
-        auto& [descriptorIndex, sampler] = g_samplerStates[XXH3_64bits(&samplerDesc, sizeof(RenderSamplerDesc))];
-        if (descriptorIndex == 0)
-        {
-            descriptorIndex = g_samplerStates.size();
-            sampler = g_device->createSampler(samplerDesc);
+        LOG_WARNING("Sampler table is full, falling back to the default sampler.");
+        samplerId = 0;
+    }
+    else if (created)
+    {
+        auto magFilter = ConvertTextureFilter((args.data3 >> 19) & 0x3);
+        auto minFilter = ConvertTextureFilter((args.data3 >> 21) & 0x3);
+        auto mipFilter = ConvertTextureFilter((args.data3 >> 23) & 0x3);
 
-            g_samplerDescriptorSet->setSampler(descriptorIndex - 1, sampler.get());
+        bool anisotropyEnabled = maxAnisotropy > 0 && mipFilter == RenderFilter::LINEAR;
+        if (anisotropyEnabled)
+        {
+            magFilter = RenderFilter::LINEAR;
+            minFilter = RenderFilter::LINEAR;
         }
 
-        SetDirtyValue(g_dirtyStates.sharedConstants, g_sharedConstants.samplerIndices[args.index], descriptorIndex - 1);
+        RenderSamplerDesc samplerDesc;
+        samplerDesc.addressU = ConvertTextureAddressMode((args.data0 >> 10) & 0x7);
+        samplerDesc.addressV = ConvertTextureAddressMode((args.data0 >> 13) & 0x7);
+        samplerDesc.addressW = ConvertTextureAddressMode((args.data0 >> 16) & 0x7);
+        samplerDesc.minFilter = minFilter;
+        samplerDesc.magFilter = magFilter;
+        samplerDesc.mipmapMode = RenderMipmapMode(mipFilter);
+        samplerDesc.maxAnisotropy = anisotropyEnabled ? maxAnisotropy : 16u;
+        samplerDesc.anisotropyEnabled = anisotropyEnabled;
+        samplerDesc.borderColor = ConvertBorderColor(args.data5 & 0x3);
+
+        g_samplers[samplerId] = g_device->createSampler(samplerDesc);
+        g_samplerDescriptorSet->setSampler(samplerId, g_samplers[samplerId].get());
     }
+
+    SetDirtyValue(g_dirtyStates.sharedConstants, g_sharedConstants.samplerIndices[args.index], uint32_t(samplerId));
 }
 
 static void ProcSetVertexShaderConstants(const RenderCommand& cmd)
@@ -4305,15 +5300,27 @@ static void ProcAddPipeline(const RenderCommand& cmd)
     if (pipeline == nullptr)
     {
         pipeline = std::unique_ptr<RenderPipeline>(args.pipeline);
+        ++g_pipelineCount;
 #ifdef ASYNC_PSO_DEBUG
         ++g_pipelinesCreatedAsynchronously;
 #endif
     }
+    else if (g_fastLinkedPipelines.erase(args.hash) != 0)
+    {
+        // The fast linked pipeline might still be bound in command lists in flight.
+        g_tempPipelines[g_frame].emplace_back(std::move(pipeline));
+        pipeline = std::unique_ptr<RenderPipeline>(args.pipeline);
+        ++g_optimizedPipelineCount;
+
+        // Rebind on the next draw so the optimized pipeline gets picked up right away.
+        g_dirtyStates.pipelineState = true;
+    }
     else
     {
 #ifdef ASYNC_PSO_DEBUG
         ++g_pipelinesDropped;
 #endif
+        ++g_redundantPipelineCount;
         delete args.pipeline;
     }
 }
@@ -4321,6 +5328,67 @@ static void ProcAddPipeline(const RenderCommand& cmd)
 static constexpr int32_t COMMON_DEPTH_BIAS_VALUE = int32_t((1 << 24) * 0.002f);
 static constexpr float COMMON_SLOPE_SCALED_DEPTH_BIAS_VALUE = 1.0f;
 
+// Pulls the shader read transitions of textures bound by the upcoming commands into the pending batch,
+// so the draws that follow don't each need their own barrier call. The look ahead stops at the first
+// command that could write to a texture or change the render targets.
+static void PrefetchTextureBarriers()
+{
+    for (size_t i = 0; i < g_renderCommandLookaheadCount; i++)
+    {
+        const auto& cmd = g_renderCommandLookahead[i];
+
+        switch (cmd.type)
+        {
+        case RenderCommandType::SetTexture:
+        {
+            auto texture = cmd.setTexture.texture;
+
+            // Textures waiting on a copy get redirected to their source surface, leave those to SetTexture.
+            if (texture == nullptr || texture->texture == nullptr || texture->sourceSurface != nullptr)
+                break;
+
+            if ((g_renderTarget != nullptr && texture->texture == g_renderTarget->texture) ||
+                (g_depthStencil != nullptr && texture->texture == g_depthStencil->texture))
+            {
+                break;
+            }
+
+            if (texture->layout != RenderTextureLayout::SHADER_READ)
+            {
+                AddBarrier(texture, RenderTextureLayout::SHADER_READ);
+                ++g_barrierStats.prefetchedCount;
+            }
+
+            if (texture->viewDimension == RenderTextureViewDimension::TEXTURE_2D && texture->recreatedCubeMapTexture != nullptr)
+                AddBarrier(texture->recreatedCubeMapTexture.get(), RenderTextureLayout::SHADER_READ);
+
+            break;
+        }
+
+        case RenderCommandType::SetRenderState:
+        case RenderCommandType::SetViewport:
+        case RenderCommandType::SetScissorRect:
+        case RenderCommandType::SetSamplerState:
+        case RenderCommandType::SetBooleans:
+        case RenderCommandType::SetVertexShaderConstants:
+        case RenderCommandType::SetPixelShaderConstants:
+        case RenderCommandType::AddPipeline:
+        case RenderCommandType::DrawPrimitive:
+        case RenderCommandType::DrawIndexedPrimitive:
+        case RenderCommandType::DrawPrimitiveUP:
+        case RenderCommandType::SetVertexDeclaration:
+        case RenderCommandType::SetVertexShader:
+        case RenderCommandType::SetStreamSource:
+        case RenderCommandType::SetIndices:
+        case RenderCommandType::SetPixelShader:
+            break;
+
+        default:
+            return;
+        }
+    }
+}
+
 static void FlushRenderStateForRenderThread()
 {
     auto renderTarget = g_pipelineState.colorWriteEnable ? g_renderTarget : nullptr;
@@ -4332,6 +5400,23 @@ static void FlushRenderStateForRenderThread()
     {
         bool isDepthStencil = (surface->format == RenderFormat::D32_FLOAT);
         foundAny |= PopulateBarriersForStretchRect(isDepthStencil ? nullptr : surface, isDepthStencil ? surface : nullptr);
+        RecordSurfaceUse(surface, false);
+    }
+
+    // Bound targets count as used even when writes to them are masked off, which errs on the side of longer lifetimes.
+    // Surfaces bound for sampling are used by the draw as well, not just when they got bound.
+    if (!g_surfaceDrawUseRecorded)
+    {
+        RecordSurfaceUse(g_renderTarget, false);
+        RecordSurfaceUse(g_depthStencil, false);
+
+        for (auto texture : g_textures)
+        {
+            if (texture != nullptr && texture->sourceSurface != nullptr)
+                RecordSurfaceUse(texture->sourceSurface, false);
+        }
+
+        g_surfaceDrawUseRecorded = true;
     }
 
     if (foundAny)
@@ -4352,6 +5437,10 @@ static void FlushRenderStateForRenderThread()
     AddBarrier(renderTarget, RenderTextureLayout::COLOR_WRITE);
     AddBarrier(depthStencil, RenderTextureLayout::DEPTH_WRITE);
 
+    // Only worth it when this draw needs a barrier anyway, otherwise it'd just move one forward.
+    if (!g_barrierBatch.IsEmpty())
+        PrefetchTextureBarriers();
+
     FlushBarriers();
 
     SetFramebuffer(renderTarget, depthStencil, false);
@@ -4368,13 +5457,13 @@ static void FlushRenderStateForRenderThread()
         int32_t depthBias = useDepthBias ? COMMON_DEPTH_BIAS_VALUE : 0;
         float slopeScaledDepthBias = useDepthBias ? COMMON_SLOPE_SCALED_DEPTH_BIAS_VALUE : 0.0f;
 
-        SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.depthBias, depthBias);
-        SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.slopeScaledDepthBias, slopeScaledDepthBias);
+        SetPipelineStateValue(g_pipelineState.depthBias, depthBias);
+        SetPipelineStateValue(g_pipelineState.slopeScaledDepthBias, slopeScaledDepthBias);
     }
 
     if (g_dirtyStates.pipelineState)
     {
-        commandList->setPipeline(CreateGraphicsPipelineInRenderThread(g_pipelineState));
+        commandList->setPipeline(GetGraphicsPipelineInRenderThread());
 
         // D3D12 resets the depth bias values. Check if they need to be set again.
         if (g_capabilities.dynamicDepthBias && !g_vulkan)
@@ -4386,19 +5475,19 @@ static void FlushRenderStateForRenderThread()
 
     if (g_dirtyStates.vertexShaderConstants)
     {
-        auto vertexShaderConstants = g_uploadAllocators[g_frame].allocate<true>(g_vertexShaderConstants, sizeof(g_vertexShaderConstants), 0x100);
+        auto vertexShaderConstants = AllocateConstants<true>(g_vertexShaderConstants, sizeof(g_vertexShaderConstants));
         SetRootDescriptor(vertexShaderConstants, 0);
     }
 
     if (g_dirtyStates.pixelShaderConstants)
     {
-        auto pixelShaderConstants = g_uploadAllocators[g_frame].allocate<true>(g_pixelShaderConstants, sizeof(g_pixelShaderConstants), 0x100);
+        auto pixelShaderConstants = AllocateConstants<true>(g_pixelShaderConstants, sizeof(g_pixelShaderConstants));
         SetRootDescriptor(pixelShaderConstants, 1);
     }
 
     if (g_dirtyStates.sharedConstants)
     {
-        auto sharedConstants = g_uploadAllocators[g_frame].allocate<false>(&g_sharedConstants, sizeof(g_sharedConstants), 0x100);
+        auto sharedConstants = AllocateConstants<false>(&g_sharedConstants, sizeof(g_sharedConstants));
         SetRootDescriptor(sharedConstants, 2);
     }
 
@@ -4442,14 +5531,14 @@ static RenderPrimitiveTopology ConvertPrimitiveType(uint32_t primitiveType)
 
 static void SetPrimitiveType(uint32_t primitiveType)
 {
-    SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.primitiveTopology, ConvertPrimitiveType(primitiveType));
+    SetPipelineStateValue(g_pipelineState.primitiveTopology, ConvertPrimitiveType(primitiveType));
 }
 
 static uint32_t CheckInstancing()
 {
     uint32_t indexCount = 0;
 
-    SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.instancing, g_pipelineState.vertexDeclaration->indexVertexStream != 0);
+    SetPipelineStateValue(g_pipelineState.instancing, g_pipelineState.vertexDeclaration->indexVertexStream != 0);
     if (g_pipelineState.instancing)
     {
         // Index buffer is passed as a vertex stream
@@ -4572,7 +5661,7 @@ static void ProcDrawPrimitiveUP(const RenderCommand& cmd)
         UnsetInstancingStream();
 
     SetPrimitiveType(args.primitiveType);
-    SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.vertexStrides[0], uint8_t(args.vertexStreamZeroStride));
+    SetPipelineStateValue(g_pipelineState.vertexStrides[0], uint8_t(args.vertexStreamZeroStride));
 
     auto allocation = g_uploadAllocators[g_frame].allocate<true>(reinterpret_cast<const uint32_t*>(args.vertexStreamZeroData), args.vertexStreamZeroSize, 0x4);
 
@@ -4592,7 +5681,7 @@ static void ProcDrawPrimitiveUP(const RenderCommand& cmd)
     if (args.csdFilterState != CsdFilterState::Unknown &&
         (g_pipelineState.pixelShader == g_csdShader || g_pipelineState.pixelShader == g_csdFilterShader.get()))
     {
-        SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.pixelShader,
+        SetPipelineStateValue(g_pipelineState.pixelShader,
             args.csdFilterState == CsdFilterState::On ? g_csdFilterShader.get() : g_csdShader);
     }
 
@@ -4703,14 +5792,11 @@ static GuestVertexDeclaration* CreateVertexDeclarationWithoutAddRef(GuestVertexE
 
     vertexElement->padding = 0; // Clear the padding in D3DDECL_END() 
 
-    std::lock_guard lock(g_vertexDeclarationMutex);
-
     XXH64_hash_t hash = XXH3_64bits(vertexElements, vertexElementCount * sizeof(GuestVertexElement));
-    auto& vertexDeclaration = g_vertexDeclarations[hash];
 
-    if (vertexDeclaration == nullptr)
+    auto vertexDeclaration = g_vertexDeclarations.FindOrCreate(hash, [&]
     {
-        vertexDeclaration = g_userHeap.AllocPhysical<GuestVertexDeclaration>(ResourceType::VertexDeclaration);
+        auto vertexDeclaration = g_userHeap.AllocPhysical<GuestVertexDeclaration>(ResourceType::VertexDeclaration);
         vertexDeclaration->hash = hash;
 
         static std::vector<RenderInputElement> inputElements;
@@ -4868,7 +5954,9 @@ static GuestVertexDeclaration* CreateVertexDeclarationWithoutAddRef(GuestVertexE
 
         vertexDeclaration->inputElementCount = uint32_t(inputElements.size());
         vertexDeclaration->vertexElementCount = vertexElementCount + 1;
-    }
+
+        return vertexDeclaration;
+    });
 
     vertexDeclaration->AddRef();
     return vertexDeclaration;
@@ -4905,26 +5993,19 @@ static void ProcSetVertexDeclaration(const RenderCommand& cmd)
         else
             specConstants &= ~SPEC_CONSTANT_R11G11B10_NORMAL;
 
-        SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.specConstants, specConstants);
+        SetPipelineStateValue(g_pipelineState.specConstants, specConstants);
     }
-    SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.vertexDeclaration, args.vertexDeclaration);
+    SetPipelineStateValue(g_pipelineState.vertexDeclaration, args.vertexDeclaration);
 }
 
 static ShaderCacheEntry* FindShaderCacheEntry(XXH64_hash_t hash)
 {
-    auto end = g_shaderCacheEntries + g_shaderCacheEntryCount;
-    auto findResult = std::lower_bound(g_shaderCacheEntries, end, hash, [](ShaderCacheEntry& lhs, XXH64_hash_t rhs)
-        {
-            return lhs.hash < rhs;
-        });
-
-    return findResult != end && findResult->hash == hash ? findResult : nullptr;
+    uint32_t entryIndex = FindShaderCacheTableIndex(g_shaderCacheTable, g_shaderCacheTableMask, hash);
+    return entryIndex != UINT32_MAX ? &g_shaderCacheEntries[entryIndex] : nullptr;
 }
 
-static GuestShader* CreateShader(const be<uint32_t>* function, ResourceType resourceType)
+static GuestShader* CreateShader(XXH64_hash_t hash, ResourceType resourceType)
 {
-    XXH64_hash_t hash = XXH3_64bits(function, function[1] + function[2]);
-
     auto findResult = FindShaderCacheEntry(hash);
     GuestShader* shader = nullptr;
 
@@ -4962,6 +6043,11 @@ static GuestShader* CreateShader(const be<uint32_t>* function, ResourceType reso
     return shader;
 }
 
+static GuestShader* CreateShader(const be<uint32_t>* function, ResourceType resourceType)
+{
+    return CreateShader(XXH3_64bits(function, function[1] + function[2]), resourceType);
+}
+
 static GuestShader* CreateVertexShader(const be<uint32_t>* function) 
 {
     return CreateShader(function, ResourceType::VertexShader);
@@ -4977,7 +6063,7 @@ static void SetVertexShader(GuestDevice* device, GuestShader* shader)
 
 static void ProcSetVertexShader(const RenderCommand& cmd)
 {
-    SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.vertexShader, cmd.setVertexShader.shader);
+    SetPipelineStateValue(g_pipelineState.vertexShader, cmd.setVertexShader.shader);
 }
 
 static void SetStreamSource(GuestDevice* device, uint32_t index, GuestBuffer* buffer, uint32_t offset, uint32_t stride) 
@@ -4995,7 +6081,7 @@ static void ProcSetStreamSource(const RenderCommand& cmd)
 {
     const auto& args = cmd.setStreamSource;
 
-    SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.vertexStrides[args.index], uint8_t(args.buffer != nullptr ? args.stride : 0));
+    SetPipelineStateValue(g_pipelineState.vertexStrides[args.index], uint8_t(args.buffer != nullptr ? args.stride : 0));
 
     bool dirty = false;
 
@@ -5110,7 +6196,201 @@ static void ProcSetPixelShader(const RenderCommand& cmd)
         }
     }
 
-    SetDirtyValue(g_dirtyStates.pipelineState, g_pipelineState.pixelShader, shader);
+    SetPipelineStateValue(g_pipelineState.pixelShader, shader);
+}
+
+static XXH64_hash_t FindShaderHash(const GuestShader* shader)
+{
+    if (shader->shaderCacheEntry != nullptr)
+        return shader->shaderCacheEntry->hash;
+
+    // Built-in replacements don't keep their cache entry, but the entry still points back to them.
+    for (size_t i = 0; i < g_shaderCacheEntryCount; i++)
+    {
+        if (g_shaderCacheEntries[i].guestShader == shader)
+            return g_shaderCacheEntries[i].hash;
+    }
+
+    return 0;
+}
+
+static void CaptureRenderObject(const GuestResource* resource)
+{
+    if (resource == nullptr || !g_renderCaptureWriter.MarkObject(reinterpret_cast<uintptr_t>(resource)))
+        return;
+
+    RenderCaptureObject object{};
+    object.id = reinterpret_cast<uintptr_t>(resource);
+    object.resourceType = uint32_t(resource->type);
+
+    const void* data = nullptr;
+
+    switch (resource->type)
+    {
+    case ResourceType::Texture:
+    case ResourceType::VolumeTexture:
+    {
+        auto texture = reinterpret_cast<const GuestTexture*>(resource);
+        object.width = texture->width;
+        object.height = texture->height;
+        object.depth = texture->depth;
+        object.format = uint32_t(texture->format);
+
+        if (texture->viewDimension == RenderTextureViewDimension::TEXTURE_CUBE)
+            object.flags |= RenderCaptureObject::FLAG_CUBE;
+
+        break;
+    }
+
+    case ResourceType::VertexBuffer:
+    case ResourceType::IndexBuffer:
+    {
+        auto buffer = reinterpret_cast<const GuestBuffer*>(resource);
+        object.width = buffer->dataSize;
+        object.format = buffer->guestFormat;
+        break;
+    }
+
+    case ResourceType::RenderTarget:
+    case ResourceType::DepthStencil:
+    {
+        auto surface = reinterpret_cast<const GuestSurface*>(resource);
+        object.width = surface->width;
+        object.height = surface->height;
+        object.format = surface->guestFormat;
+        object.sampleCount = surface->sampleCount;
+
+        if (surface == g_backBuffer)
+            object.flags |= RenderCaptureObject::FLAG_BACK_BUFFER;
+
+        break;
+    }
+
+    case ResourceType::VertexDeclaration:
+    {
+        auto vertexDeclaration = reinterpret_cast<const GuestVertexDeclaration*>(resource);
+        object.dataSize = vertexDeclaration->vertexElementCount * sizeof(GuestVertexElement);
+        data = vertexDeclaration->vertexElements.get();
+        break;
+    }
+
+    case ResourceType::VertexShader:
+    case ResourceType::PixelShader:
+        object.hash = FindShaderHash(reinterpret_cast<const GuestShader*>(resource));
+        break;
+    }
+
+    g_renderCaptureWriter.WriteObject(object, data);
+}
+
+static void CaptureRenderCommand(const RenderCommand& cmd)
+{
+    const void* blobData = nullptr;
+    uint32_t blobSize = 0;
+
+    switch (cmd.type)
+    {
+    case RenderCommandType::SetRenderState:
+    case RenderCommandType::Clear:
+    case RenderCommandType::SetViewport:
+    case RenderCommandType::SetScissorRect:
+    case RenderCommandType::SetSamplerState:
+    case RenderCommandType::SetBooleans:
+    case RenderCommandType::DrawPrimitive:
+    case RenderCommandType::DrawIndexedPrimitive:
+        break;
+
+    case RenderCommandType::UnlockBuffer16:
+    case RenderCommandType::UnlockBuffer32:
+        CaptureRenderObject(cmd.unlockBuffer.buffer);
+        blobData = cmd.unlockBuffer.buffer->mappedMemory;
+        blobSize = blobData != nullptr ? cmd.unlockBuffer.buffer->dataSize : 0;
+        break;
+
+    case RenderCommandType::StretchRect:
+        CaptureRenderObject(cmd.stretchRect.texture);
+        break;
+    case RenderCommandType::SetRenderTarget:
+        CaptureRenderObject(cmd.setRenderTarget.renderTarget);
+        break;
+    case RenderCommandType::SetDepthStencilSurface:
+        CaptureRenderObject(cmd.setDepthStencilSurface.depthStencil);
+        break;
+    case RenderCommandType::SetTexture:
+        CaptureRenderObject(cmd.setTexture.texture);
+        break;
+    case RenderCommandType::SetVertexDeclaration:
+        CaptureRenderObject(cmd.setVertexDeclaration.vertexDeclaration);
+        break;
+    case RenderCommandType::SetVertexShader:
+        CaptureRenderObject(cmd.setVertexShader.shader);
+        break;
+    case RenderCommandType::SetPixelShader:
+        CaptureRenderObject(cmd.setPixelShader.shader);
+        break;
+    case RenderCommandType::SetStreamSource:
+        CaptureRenderObject(cmd.setStreamSource.buffer);
+        break;
+    case RenderCommandType::SetIndices:
+        CaptureRenderObject(cmd.setIndices.buffer);
+        break;
+
+    case RenderCommandType::SetVertexShaderConstants:
+        blobData = cmd.setVertexShaderConstants.memory;
+        blobSize = cmd.setVertexShaderConstants.size;
+        break;
+    case RenderCommandType::SetPixelShaderConstants:
+        blobData = cmd.setPixelShaderConstants.memory;
+        blobSize = cmd.setPixelShaderConstants.size;
+        break;
+    case RenderCommandType::DrawPrimitiveUP:
+        blobData = cmd.drawPrimitiveUP.vertexStreamZeroData;
+        blobSize = cmd.drawPrimitiveUP.vertexStreamZeroSize;
+        break;
+
+    default:
+        // Frame boundaries, ImGui and presentation get regenerated by Video::Present() during replay.
+        // Resource destruction, texture uploads, pipelines and lambdas can't be serialized meaningfully.
+        return;
+    }
+
+    g_renderCaptureWriter.Write(RenderCaptureRecordKind::Command, uint32_t(cmd.type), &cmd, sizeof(cmd));
+
+    if (blobData != nullptr || blobSize != 0)
+        g_renderCaptureWriter.Write(RenderCaptureRecordKind::Blob, 0, blobData, blobSize);
+}
+
+static void UpdateRenderCapture(const RenderCommand& cmd)
+{
+    if (cmd.type == RenderCommandType::BeginCommandList)
+    {
+        uint32_t frameCount = g_renderCaptureRequestedFrames.exchange(0);
+        if (frameCount != 0 && !g_renderCaptureWriter.IsOpen())
+        {
+            auto path = GetUserPath() / "render_capture.bin";
+            if (g_renderCaptureWriter.Open(path, sizeof(RenderCommand)))
+            {
+                g_renderCaptureFrameCount = frameCount;
+                LOGF("Capturing {} frames to \"{}\".", frameCount, path.string());
+            }
+        }
+    }
+    else if (cmd.type == RenderCommandType::ExecuteCommandList && g_renderCaptureWriter.IsOpen())
+    {
+        g_renderCaptureWriter.EndFrame();
+
+        if (g_renderCaptureWriter.frameCount >= g_renderCaptureFrameCount)
+        {
+            uint64_t recordCount = g_renderCaptureWriter.recordCount;
+            if (g_renderCaptureWriter.Close())
+                LOGF("Render capture finished with {} records.", recordCount);
+        }
+    }
+}
+
+void Video::RequestRenderCapture(uint32_t frameCount)
+{
+    g_renderCaptureRequestedFrames = frameCount;
 }
 
 static std::thread g_renderThread([]
@@ -5123,6 +6403,7 @@ static std::thread g_renderThread([]
         SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
         GuestThread::SetThreadName(GetCurrentThreadId(), "Render Thread");
 #endif
+        g_traceRecorder.SetThreadName("Render Thread");
 
         RenderCommand commands[32];
 
@@ -5130,9 +6411,21 @@ static std::thread g_renderThread([]
         {
             size_t count = g_renderQueue.wait_dequeue_bulk(commands, std::size(commands));
 
+            TRACE_SCOPE("Render Commands");
+
             for (size_t i = 0; i < count; i++)
             {
                 auto& cmd = commands[i];
+
+                g_renderCommandLookahead = commands + i + 1;
+                g_renderCommandLookaheadCount = count - i - 1;
+
+                if (g_renderCaptureWriter.IsOpen())
+                    CaptureRenderCommand(cmd);
+
+                bool timingEnabled = g_renderCommandTimingEnabled.load(std::memory_order_relaxed);
+                auto start = timingEnabled ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
                 switch (cmd.type)
                 {
                 case RenderCommandType::SetRenderState:                    ProcSetRenderState(cmd); break;
@@ -5167,10 +6460,322 @@ static std::thread g_renderThread([]
                 case RenderCommandType::ExecuteLambda:                     ProcExecuteLambda(cmd); break;
                 default:                                                   assert(false && "Unrecognized render command type."); break;
                 }
+
+                if (timingEnabled)
+                    g_renderCommandTimings.Add(uint32_t(cmd.type), std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+
+                UpdateRenderCapture(cmd);
             }
         }
     });
 
+static GuestTexture* CreateReplayTexture(const RenderCaptureObject& object)
+{
+    const auto texture = g_userHeap.AllocPhysical<GuestTexture>(ResourceType(object.resourceType));
+    bool cube = (object.flags & RenderCaptureObject::FLAG_CUBE) != 0;
+
+    RenderTextureDesc desc;
+    desc.dimension = texture->type == ResourceType::VolumeTexture ? RenderTextureDimension::TEXTURE_3D : RenderTextureDimension::TEXTURE_2D;
+    desc.width = object.width;
+    desc.height = object.height;
+    desc.depth = std::max(object.depth, 1u);
+    desc.mipLevels = 1;
+    desc.arraySize = cube ? 6 : 1;
+    desc.format = RenderFormat(object.format);
+    desc.flags = cube ? RenderTextureFlag::CUBE : RenderTextureFlag::NONE;
+
+    texture->textureHolder = g_device->createTexture(desc);
+    texture->texture = texture->textureHolder.get();
+
+    RenderTextureViewDesc viewDesc;
+    viewDesc.format = desc.format;
+    viewDesc.dimension = cube ? RenderTextureViewDimension::TEXTURE_CUBE :
+        desc.dimension == RenderTextureDimension::TEXTURE_3D ? RenderTextureViewDimension::TEXTURE_3D : RenderTextureViewDimension::TEXTURE_2D;
+    viewDesc.mipLevels = 1;
+
+    texture->textureView = texture->texture->createTextureView(viewDesc);
+    texture->width = object.width;
+    texture->height = object.height;
+    texture->depth = object.depth;
+    texture->format = desc.format;
+    texture->viewDimension = viewDesc.dimension;
+    texture->descriptorIndex = g_textureDescriptorAllocator.allocate();
+
+    g_textureDescriptorSet->setTexture(texture->descriptorIndex, texture->texture, RenderTextureLayout::SHADER_READ, texture->textureView.get());
+
+    return texture;
+}
+
+static GuestResource* CreateReplayObject(const RenderCaptureObject& object, const uint8_t* data)
+{
+    switch (ResourceType(object.resourceType))
+    {
+    case ResourceType::Texture:
+    case ResourceType::VolumeTexture:
+        return CreateReplayTexture(object);
+
+    case ResourceType::VertexBuffer:
+        return CreateVertexBuffer(object.width);
+
+    case ResourceType::IndexBuffer:
+        return CreateIndexBuffer(object.width, 0, object.format);
+
+    case ResourceType::RenderTarget:
+    case ResourceType::DepthStencil:
+        if ((object.flags & RenderCaptureObject::FLAG_BACK_BUFFER) != 0)
+            return g_backBuffer;
+
+        return CreateSurface(object.width, object.height, object.format, object.sampleCount != RenderSampleCount::COUNT_1);
+
+    case ResourceType::VertexDeclaration:
+    {
+        // Copied since the declaration gets patched in place when it's created.
+        std::vector<GuestVertexElement> vertexElements(object.dataSize / sizeof(GuestVertexElement));
+        memcpy(vertexElements.data(), data, vertexElements.size() * sizeof(GuestVertexElement));
+
+        if (vertexElements.empty() || vertexElements.back().stream != 0xFF)
+            vertexElements.push_back(D3DDECL_END());
+
+        return CreateVertexDeclaration(vertexElements.data());
+    }
+
+    case ResourceType::VertexShader:
+    case ResourceType::PixelShader:
+        return CreateShader(object.hash, ResourceType(object.resourceType));
+
+    default:
+        return nullptr;
+    }
+}
+
+bool Video::ReplayRenderCapture(const std::filesystem::path& path, uint32_t loopCount)
+{
+    RenderCaptureReader reader;
+    if (!reader.Open(path, sizeof(RenderCommand)))
+    {
+        LOGF("Failed to open render capture \"{}\".", path.string());
+        return false;
+    }
+
+    struct ReplayBufferUpload
+    {
+        GuestBuffer* buffer;
+        void* data;
+    };
+
+    ankerl::unordered_dense::map<uint64_t, GuestResource*> objects;
+    std::vector<std::unique_ptr<uint8_t[]>> blobs;
+    std::vector<std::unique_ptr<ReplayBufferUpload>> bufferUploads;
+    std::vector<std::vector<RenderCommand>> frames(1);
+
+    auto remap = [&]<typename T>(T*& pointer)
+        {
+            if (pointer != nullptr)
+            {
+                auto findResult = objects.find(reinterpret_cast<uintptr_t>(pointer));
+                pointer = findResult != objects.end() ? reinterpret_cast<T*>(findResult->second) : nullptr;
+            }
+        };
+
+    for (size_t i = 0; i < reader.records.size(); i++)
+    {
+        auto& record = reader.records[i];
+
+        switch (record.kind)
+        {
+        case RenderCaptureRecordKind::Object:
+        {
+            if (record.size < sizeof(RenderCaptureObject))
+                break;
+
+            RenderCaptureObject object;
+            memcpy(&object, record.data, sizeof(object));
+            objects[object.id] = CreateReplayObject(object, record.data + sizeof(object));
+            break;
+        }
+
+        case RenderCaptureRecordKind::Command:
+        {
+            if (record.size != sizeof(RenderCommand))
+                break;
+
+            RenderCommand cmd;
+            memcpy(&cmd, record.data, sizeof(cmd));
+
+            // Data the command points to follows as a blob, copied out so it's aligned and stays alive for the whole replay.
+            uint8_t* blob = nullptr;
+            if (i + 1 < reader.records.size() && reader.records[i + 1].kind == RenderCaptureRecordKind::Blob)
+            {
+                auto& blobRecord = reader.records[++i];
+                blob = blobs.emplace_back(std::make_unique_for_overwrite<uint8_t[]>(blobRecord.size)).get();
+                memcpy(blob, blobRecord.data, blobRecord.size);
+            }
+
+            switch (cmd.type)
+            {
+            case RenderCommandType::UnlockBuffer16:
+            case RenderCommandType::UnlockBuffer32:
+            {
+                remap(cmd.unlockBuffer.buffer);
+                if (cmd.unlockBuffer.buffer == nullptr || blob == nullptr)
+                    continue;
+
+                // Point the buffer at the captured contents right before the upload consumes them.
+                // The lambda gets executed once per loop, so the replay owns it instead of the render thread.
+                auto& bufferUpload = bufferUploads.emplace_back(std::make_unique<ReplayBufferUpload>(ReplayBufferUpload{ cmd.unlockBuffer.buffer, blob }));
+
+                RenderCommand uploadCmd;
+                uploadCmd.type = RenderCommandType::ExecuteLambda;
+                uploadCmd.executeLambda.lambdaPtr = bufferUpload.get();
+                uploadCmd.executeLambda.executor = [](void* ptr)
+                    {
+                        auto bufferUpload = static_cast<ReplayBufferUpload*>(ptr);
+                        bufferUpload->buffer->mappedMemory = bufferUpload->data;
+                        bufferUpload->buffer->lockedReadOnly = false;
+                    };
+                uploadCmd.executeLambda.deleter = [](void*) {};
+                frames.back().push_back(uploadCmd);
+                break;
+            }
+
+            case RenderCommandType::StretchRect:
+                cmd.stretchRect.device = nullptr;
+                remap(cmd.stretchRect.texture);
+                if (cmd.stretchRect.texture == nullptr)
+                    continue;
+
+                break;
+
+            case RenderCommandType::SetRenderTarget:
+                remap(cmd.setRenderTarget.renderTarget);
+                break;
+            case RenderCommandType::SetDepthStencilSurface:
+                remap(cmd.setDepthStencilSurface.depthStencil);
+                break;
+            case RenderCommandType::SetTexture:
+                remap(cmd.setTexture.texture);
+                break;
+            case RenderCommandType::SetVertexDeclaration:
+                remap(cmd.setVertexDeclaration.vertexDeclaration);
+                break;
+            case RenderCommandType::SetVertexShader:
+                remap(cmd.setVertexShader.shader);
+                break;
+            case RenderCommandType::SetPixelShader:
+                remap(cmd.setPixelShader.shader);
+                break;
+            case RenderCommandType::SetStreamSource:
+                remap(cmd.setStreamSource.buffer);
+                break;
+            case RenderCommandType::SetIndices:
+                remap(cmd.setIndices.buffer);
+                break;
+
+            case RenderCommandType::SetVertexShaderConstants:
+                if (blob == nullptr)
+                    continue;
+
+                cmd.setVertexShaderConstants.memory = blob;
+                break;
+            case RenderCommandType::SetPixelShaderConstants:
+                if (blob == nullptr)
+                    continue;
+
+                cmd.setPixelShaderConstants.memory = blob;
+                break;
+            case RenderCommandType::DrawPrimitiveUP:
+                if (blob == nullptr)
+                    continue;
+
+                cmd.drawPrimitiveUP.vertexStreamZeroData = blob;
+                break;
+
+            default:
+                break;
+            }
+
+            frames.back().push_back(cmd);
+            break;
+        }
+
+        case RenderCaptureRecordKind::FrameEnd:
+            frames.emplace_back();
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    // Drop the trailing frame that never got finished.
+    frames.pop_back();
+
+    LOGF("Replaying {} frames with {} objects from \"{}\".", frames.size(), objects.size(), path.string());
+
+    // Run as fast as possible, the replay is about measuring the CPU side.
+    auto fps = Config::FPS.Value;
+    Config::FPS = FPS_MAX;
+    g_swapChain->setVsyncEnabled(false);
+
+    g_renderCommandTimings.Reset();
+    g_renderCommandTimingEnabled = true;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t loop = 0; loop < loopCount; loop++)
+    {
+        for (auto& frame : frames)
+        {
+            if (!frame.empty())
+                g_renderQueue.enqueue_bulk(frame.data(), frame.size());
+
+            Video::Present();
+        }
+    }
+
+    // Wait for the render thread to go through everything that got queued.
+    std::atomic<bool> finished = false;
+    EnqueueLambda([&finished]
+        {
+            finished = true;
+            finished.notify_one();
+        });
+
+    finished.wait(false);
+
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    g_renderCommandTimingEnabled = false;
+    Config::FPS = fps;
+    g_swapChain->setVsyncEnabled(Config::VSync);
+
+    uint32_t frameCount = uint32_t(frames.size()) * loopCount;
+
+    auto writeReport = [&](FILE* file)
+        {
+            fprintf(file, "Render capture: %s\n", path.string().c_str());
+            fprintf(file, "Frames: %u, Total: %.3f ms, Average: %.3f ms/frame\n\n", frameCount, elapsed, frameCount != 0 ? elapsed / frameCount : 0.0);
+
+            g_renderCommandTimings.WriteReport(file, [](uint32_t type)
+                {
+                    return type < std::size(g_renderCommandTypeNames) ? g_renderCommandTypeNames[type] : "Unknown";
+                });
+        };
+
+    writeReport(stdout);
+
+    auto reportPath = GetUserPath() / "replay_report.txt";
+    FILE* reportFile = fopen(reportPath.string().c_str(), "w");
+    if (reportFile != nullptr)
+    {
+        writeReport(reportFile);
+        fclose(reportFile);
+        LOGF("Replay report written to \"{}\".", reportPath.string());
+    }
+
+    return true;
+}
+
 static void D3DXFillTexture(GuestTexture* texture, uint32_t function, void* data)
 {
     if (texture->width == 1 && texture->height == 1 && texture->format == RenderFormat::R8_UNORM && function == 0x82BA2150)
@@ -5314,41 +6919,38 @@ static void D3DXFillVolumeTexture(GuestTexture* texture, uint32_t function, void
                 auto srcBase = reinterpret_cast<uint32_t*>(data) + yIndexBase;
                 auto destRow32 = reinterpret_cast<uint32_t*>(destRow);
 
+                CopyAndSwap(destRow32, srcBase, width);
+
+                // Accumulate the mip from the guest data instead of reading back the upload memory.
+                // The pixels are big endian, so the host's first channel is the last byte.
+                auto srcBytes = reinterpret_cast<const uint8_t*>(srcBase);
+
                 size_t x = 0;
                 for (; x + 1 < width; x += 2)
                 {
-                    // Pixel 1
-                    uint32_t val1 = srcBase[x];
-                    uint32_t swapped1 = ByteSwap(val1);
-                    destRow32[x] = swapped1;
-
-                    // Pixel 2
-                    uint32_t val2 = srcBase[x + 1];
-                    uint32_t swapped2 = ByteSwap(val2);
-                    destRow32[x + 1] = swapped2;
+                    auto src1 = srcBytes + x * 4;
+                    auto src2 = src1 + 4;
 
                     size_t mipIndex = mipIndexBaseY + (x / 2) * 4;
 
-                    mipData[mipIndex + 0] += (swapped1 & 0xFF) + (swapped2 & 0xFF);
-                    mipData[mipIndex + 1] += ((swapped1 >> 8) & 0xFF) + ((swapped2 >> 8) & 0xFF);
-                    mipData[mipIndex + 2] += ((swapped1 >> 16) & 0xFF) + ((swapped2 >> 16) & 0xFF);
-                    mipData[mipIndex + 3] += ((swapped1 >> 24) & 0xFF) + ((swapped2 >> 24) & 0xFF);
+                    mipData[mipIndex + 0] += src1[3] + src2[3];
+                    mipData[mipIndex + 1] += src1[2] + src2[2];
+                    mipData[mipIndex + 2] += src1[1] + src2[1];
+                    mipData[mipIndex + 3] += src1[0] + src2[0];
                 }
 
                 if (x < width)
                 {
-                    uint32_t val = srcBase[x];
-                    uint32_t swapped = ByteSwap(val);
-                    destRow32[x] = swapped;
+                    auto src = srcBytes + x * 4;
 
                     size_t mipIndex = mipIndexBaseY + (x / 2) * 4;
 
                     if (mipIndex + 3 < mipData.size())
                     {
-                        mipData[mipIndex + 0] += (swapped & 0xFF);
-                        mipData[mipIndex + 1] += ((swapped >> 8) & 0xFF);
-                        mipData[mipIndex + 2] += ((swapped >> 16) & 0xFF);
-                        mipData[mipIndex + 3] += ((swapped >> 24) & 0xFF);
+                        mipData[mipIndex + 0] += src[3];
+                        mipData[mipIndex + 1] += src[2];
+                        mipData[mipIndex + 2] += src[1];
+                        mipData[mipIndex + 3] += src[0];
                     }
                 }
             }
@@ -5623,71 +7225,179 @@ struct TextureLoadTask
     int height;
 };
 
-static moodycamel::BlockingConcurrentQueue<TextureLoadTask> g_textureLoadQueue;
+static moodycamel::BlockingConcurrentQueue<TextureLoadTask> g_textureLoadQueue;
+
+struct DecodedTexture
+{
+    TextureLoadTask task;
+    stbi_uc* pixels;
+};
+
+static moodycamel::BlockingConcurrentQueue<DecodedTexture> g_decodedTextureQueue;
 
-static void TextureLoaderThread()
+static bool IsTextureLoadCancelled(const TextureLoadTask& task)
+{
+    return !task.asyncToken || !*task.asyncToken;
+}
+
+// Decoding is split from uploading, so the decoders never sit on a copy fence and keep every core they
+// were given busy. The uploader picks up whatever got decoded in the meantime and copies it all at once.
+static void TextureDecoderThread()
 {
 #ifdef _WIN32
-    GuestThread::SetThreadName(GetCurrentThreadId(), "Texture Loader Thread");
+    GuestThread::SetThreadName(GetCurrentThreadId(), "Texture Decoder Thread");
 #endif
+    g_traceRecorder.SetThreadName("Texture Decoder Thread");
 
     TextureLoadTask task;
     while (true)
     {
         g_textureLoadQueue.wait_dequeue(task);
 
+        // Textures released while still in the queue don't need decoding at all.
+        if (IsTextureLoadCancelled(task))
+        {
+            ++g_cancelledTextureDecodeCount;
+            continue;
+        }
+
+        TRACE_SCOPE("Decode Texture");
+
         int w, h, c;
-        void* stbImage = stbi_load_from_memory(task.data.data(), (int)task.data.size(), &w, &h, &c, 4);
+        stbi_uc* pixels = stbi_load_from_memory(task.data.data(), (int)task.data.size(), &w, &h, &c, 4);
+
+        if (pixels != nullptr)
+        {
+            ++g_decodedTextureCount;
+
+            task.data = {};
+            g_decodedTextureQueue.enqueue({ std::move(task), pixels });
+        }
+    }
+}
+
+static constexpr size_t TEXTURE_UPLOAD_BATCH_COUNT = 32;
+static constexpr uint64_t TEXTURE_UPLOAD_BATCH_SIZE = 64 * 1024 * 1024;
+
+static void UploadTextureBatch(std::vector<DecodedTexture>& batch, TextureUploadBatchLayout& layout)
+{
+    TRACE_SCOPE("Upload Texture Batch");
+
+    auto uploadBuffer = g_device->createBuffer(RenderBufferDesc::UploadBuffer(layout.size));
+    uint8_t* mappedMemory = reinterpret_cast<uint8_t*>(uploadBuffer->map());
+
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+        auto& image = layout.images[i];
+        auto data = reinterpret_cast<const uint8_t*>(batch[i].pixels);
+        uint8_t* dstData = mappedMemory + image.offset;
 
-        if (stbImage != nullptr)
+        if (image.rowPitch == (image.width * 4))
+        {
+            memcpy(dstData, data, image.rowPitch * image.height);
+        }
+        else
         {
-            if (task.asyncToken && *task.asyncToken)
+            for (size_t j = 0; j < image.height; j++)
             {
-                uint32_t rowPitch = (task.width * 4 + PITCH_ALIGNMENT - 1) & ~(PITCH_ALIGNMENT - 1);
-                uint32_t slicePitch = rowPitch * task.height;
+                memcpy(dstData, data, image.width * 4);
+                data += image.width * 4;
+                dstData += image.rowPitch;
+            }
+        }
 
-                auto uploadBuffer = g_device->createBuffer(RenderBufferDesc::UploadBuffer(slicePitch));
-                uint8_t* mappedMemory = reinterpret_cast<uint8_t*>(uploadBuffer->map());
+        stbi_image_free(batch[i].pixels);
+    }
 
-                if (rowPitch == (task.width * 4))
-                {
-                    memcpy(mappedMemory, stbImage, slicePitch);
-                }
-                else
-                {
-                    auto data = reinterpret_cast<const uint8_t*>(stbImage);
+    uploadBuffer->unmap();
 
-                    for (size_t i = 0; i < task.height; i++)
-                    {
-                        memcpy(mappedMemory, data, task.width * 4);
-                        data += task.width * 4;
-                        mappedMemory += rowPitch;
-                    }
-                }
+    std::vector<RenderTextureBarrier> barriers;
+    for (auto& decodedTexture : batch)
+        barriers.emplace_back(decodedTexture.task.texturePtr, RenderTextureLayout::COPY_DEST);
 
-                uploadBuffer->unmap();
+    ExecuteCopyCommandList([&]
+        {
+            g_copyCommandList->barriers(RenderBarrierStage::COPY, barriers);
 
-                ExecuteCopyCommandList([&]
-                    {
-                        g_copyCommandList->barriers(RenderBarrierStage::COPY, RenderTextureBarrier(task.texturePtr, RenderTextureLayout::COPY_DEST));
+            for (size_t i = 0; i < batch.size(); i++)
+            {
+                auto& image = layout.images[i];
+
+                g_copyCommandList->copyTextureRegion(
+                    RenderTextureCopyLocation::Subresource(batch[i].task.texturePtr, 0),
+                    RenderTextureCopyLocation::PlacedFootprint(uploadBuffer.get(), RenderFormat::R8G8B8A8_UNORM, image.width, image.height, 1, image.rowPitch / 4, image.offset));
+            }
+        });
 
-                        g_copyCommandList->copyTextureRegion(
-                            RenderTextureCopyLocation::Subresource(task.texturePtr, 0),
-                            RenderTextureCopyLocation::PlacedFootprint(uploadBuffer.get(), RenderFormat::R8G8B8A8_UNORM, task.width, task.height, 1, rowPitch / 4, 0));
-                    });
+    for (auto& decodedTexture : batch)
+    {
+        if (!IsTextureLoadCancelled(decodedTexture.task))
+            g_textureDescriptorSet->setTexture(decodedTexture.task.descriptorIndex, decodedTexture.task.texturePtr, RenderTextureLayout::SHADER_READ);
+    }
 
-                if (task.asyncToken && *task.asyncToken)
-                {
-                    g_textureDescriptorSet->setTexture(task.descriptorIndex, task.texturePtr, RenderTextureLayout::SHADER_READ);
-                }
+    ++g_textureUploadBatchCount;
+
+    batch.clear();
+    layout.Clear();
+}
+
+static void TextureUploaderThread()
+{
+#ifdef _WIN32
+    GuestThread::SetThreadName(GetCurrentThreadId(), "Texture Uploader Thread");
+#endif
+    g_traceRecorder.SetThreadName("Texture Uploader Thread");
+
+    DecodedTexture decodedTextures[TEXTURE_UPLOAD_BATCH_COUNT];
+    std::vector<DecodedTexture> batch;
+    TextureUploadBatchLayout layout(PITCH_ALIGNMENT, PLACEMENT_ALIGNMENT);
+
+    while (true)
+    {
+        size_t count = g_decodedTextureQueue.wait_dequeue_bulk(decodedTextures, std::size(decodedTextures));
+
+        for (size_t i = 0; i < count; i++)
+        {
+            auto& decodedTexture = decodedTextures[i];
+
+            if (IsTextureLoadCancelled(decodedTexture.task))
+            {
+                stbi_image_free(decodedTexture.pixels);
+                decodedTexture = {};
+                continue;
             }
 
-            stbi_image_free(stbImage);
+            if (!layout.Add(decodedTexture.task.width, decodedTexture.task.height, TEXTURE_UPLOAD_BATCH_SIZE))
+            {
+                UploadTextureBatch(batch, layout);
+                layout.Add(decodedTexture.task.width, decodedTexture.task.height, TEXTURE_UPLOAD_BATCH_SIZE);
+            }
+
+            batch.push_back(std::move(decodedTexture));
+            decodedTexture = {};
         }
+
+        if (!batch.empty())
+            UploadTextureBatch(batch, layout);
     }
 }
 
-static std::vector<std::unique_ptr<std::thread>> g_textureLoaderThreads = []()
+static std::once_flag g_textureLoaderThreadsFlag;
+static std::vector<std::unique_ptr<std::thread>> g_textureDecoderThreads;
+static std::unique_ptr<std::thread> g_textureUploaderThread;
+
+// Started on the first load rather than statically, so the configured thread count has been read by then.
+static void StartTextureLoaderThreads()
+{
+    std::call_once(g_textureLoaderThreadsFlag, []
+        {
+            g_textureDecoderThreads.resize(GetTextureDecodeThreadCount(Config::TextureDecodeThreads, std::thread::hardware_concurrency()));
+            for (auto& thread : g_textureDecoderThreads)
+                thread = std::make_unique<std::thread>(TextureDecoderThread);
+
+            g_textureUploaderThread = std::make_unique<std::thread>(TextureUploaderThread);
+        });
+}
 
 // Minimal KTX Header for ASTC support
 struct KtxHeader
@@ -5728,14 +7438,194 @@ static RenderFormat KTXFormatToRenderFormat(uint32_t glInternalFormat)
     }
 }
 
+static std::optional<TranscodeFormat> GetTranscodeFormat(RenderFormat format)
+{
+    switch (format)
+    {
+    case RenderFormat::BC1_TYPELESS:
+    case RenderFormat::BC1_UNORM:
+        return TranscodeFormat::BC1;
+    case RenderFormat::BC2_TYPELESS:
+    case RenderFormat::BC2_UNORM:
+        return TranscodeFormat::BC2;
+    case RenderFormat::BC3_TYPELESS:
+    case RenderFormat::BC3_UNORM:
+        return TranscodeFormat::BC3;
+    case RenderFormat::BC4_TYPELESS:
+    case RenderFormat::BC4_UNORM:
+        return TranscodeFormat::BC4;
+    case RenderFormat::BC5_TYPELESS:
+    case RenderFormat::BC5_UNORM:
+        return TranscodeFormat::BC5;
+    default:
+        return std::nullopt;
+    }
+}
+
+static RenderFormat ConvertTranscodeTarget(TranscodeTarget target)
+{
+    switch (target)
+    {
+    case TranscodeTarget::ETC2_RGB8:
+        return RenderFormat::ETC2_R8G8B8_UNORM;
+    case TranscodeTarget::ETC2_RGBA8:
+        return RenderFormat::ETC2_R8G8B8A8_UNORM;
+    case TranscodeTarget::EAC_R11:
+        return RenderFormat::EAC_R11_UNORM;
+    default:
+        return RenderFormat::EAC_R11G11_UNORM;
+    }
+}
+
+struct TextureTranscodeTask
+{
+    XXH64_hash_t hash;
+    RenderFormat format;
+    TranscodeFormat transcodeFormat;
+    std::vector<uint8_t> data;
+};
+
+// Queued tasks hold a copy of the source blocks. Loading a lot of new textures at once would pile them up faster than
+// they get transcoded, so textures that don't fit under the limit are skipped and get queued by a later load instead.
+static constexpr uint64_t MAX_PENDING_TEXTURE_TRANSCODE_BYTES = 32 * 1024 * 1024;
+
+static moodycamel::BlockingConcurrentQueue<TextureTranscodeTask> g_textureTranscodeQueue;
+static Mutex g_pendingTextureTranscodesMutex;
+static ankerl::unordered_dense::set<XXH64_hash_t> g_pendingTextureTranscodes;
+static uint64_t g_pendingTextureTranscodeBytes;
+
+// Encoding ETC2 well takes a lot longer than decoding BC, so it stays off the loading path entirely. The results
+// are only picked up by the next load of the same texture, which is usually the next run.
+static std::thread g_textureTranscoderThread([]
+    {
+        g_traceRecorder.SetThreadName("Texture Transcoder Thread");
+
+        TextureTranscodeTask task;
+        std::vector<uint8_t> transcodedData;
+
+        while (true)
+        {
+            g_textureTranscodeQueue.wait_dequeue(task);
+
+            {
+                TRACE_SCOPE("Transcode Texture");
+
+                size_t blockCount = task.data.size() / GetTranscodeBlockSize(task.transcodeFormat);
+                TranscodeTarget target = GetTranscodeTarget(task.transcodeFormat, task.data.data(), blockCount);
+                uint32_t targetFormat = uint32_t(ConvertTranscodeTarget(target));
+
+                transcodedData.resize(sizeof(targetFormat) + blockCount * GetTranscodeBlockSize(target));
+                memcpy(transcodedData.data(), &targetFormat, sizeof(targetFormat));
+                TranscodeBlocks(task.transcodeFormat, target, task.data.data(), transcodedData.data() + sizeof(targetFormat), blockCount);
+
+                g_transcodedTextureCache.Store(task.hash, uint32_t(task.format), transcodedData.data(), transcodedData.size());
+            }
+
+            ++g_transcodedTextureCount;
+
+            std::lock_guard lock(g_pendingTextureTranscodesMutex);
+            g_pendingTextureTranscodes.erase(task.hash);
+            g_pendingTextureTranscodeBytes -= task.data.size();
+        }
+    });
+
+// Swaps BC data the device can't sample for something it can. Cached ETC2 data is used as is, otherwise the texture
+// is decoded to RGBA8 for now and queued for transcoding. Returns the new format and data, which are laid out the
+// same way as the source, array slice by array slice and mip by mip.
+static bool TranscodeTextureData(const ddspp::Descriptor& ddsDesc, TextureIdentity& identity, uint32_t arraySize,
+    RenderFormat& format, std::vector<uint8_t>& transcodedData, size_t& transcodedOffset)
 {
-    std::vector<std::unique_ptr<std::thread>> threads(2);
-    for (auto& thread : threads)
-        thread = std::make_unique<std::thread>(TextureLoaderThread);
-    return threads;
-}();
+    auto transcodeFormat = GetTranscodeFormat(format);
+    if (!transcodeFormat.has_value())
+        return false;
+
+    size_t blockSize = GetTranscodeBlockSize(*transcodeFormat);
+    size_t blockCount = 0;
+    size_t pixelCount = 0;
+
+    for (uint32_t arraySlice = 0; arraySlice < arraySize; arraySlice++)
+    {
+        for (uint32_t mipSlice = 0; mipSlice < ddsDesc.numMips; mipSlice++)
+        {
+            size_t width = std::max(1u, ddsDesc.width >> mipSlice);
+            size_t height = std::max(1u, ddsDesc.height >> mipSlice);
+            size_t depth = std::max(1u, ddsDesc.depth >> mipSlice);
+
+            blockCount += ((width + 3) / 4) * ((height + 3) / 4) * depth;
+            pixelCount += width * height * depth;
+        }
+    }
+
+    const uint8_t* blocks = identity.data + ddsDesc.headerSize;
+    if (ddsDesc.headerSize + blockCount * blockSize > identity.size)
+        return false;
+
+    XXH64_hash_t hash = identity.GetHash();
+
+    if (g_capabilities.textureCompressionETC2)
+    {
+        uint32_t targetFormat = 0;
+
+        if (g_transcodedTextureCache.Load(hash, uint32_t(format), transcodedData) && transcodedData.size() >= sizeof(targetFormat))
+        {
+            memcpy(&targetFormat, transcodedData.data(), sizeof(targetFormat));
 
-static bool LoadTexture(GuestTexture& texture, const uint8_t* data, size_t dataSize, RenderComponentMapping componentMapping, bool forceCubeMap = false)
+            if (targetFormat < uint32_t(RenderFormat::MAX) &&
+                transcodedData.size() == sizeof(targetFormat) + blockCount * RenderFormatSize(RenderFormat(targetFormat)))
+            {
+                format = RenderFormat(targetFormat);
+                transcodedOffset = sizeof(targetFormat);
+                return true;
+            }
+        }
+
+        size_t dataSize = blockCount * blockSize;
+        bool queued = false;
+        {
+            std::lock_guard lock(g_pendingTextureTranscodesMutex);
+
+            if (g_pendingTextureTranscodeBytes + dataSize <= MAX_PENDING_TEXTURE_TRANSCODE_BYTES && g_pendingTextureTranscodes.emplace(hash).second)
+            {
+                g_pendingTextureTranscodeBytes += dataSize;
+                queued = true;
+            }
+        }
+
+        if (queued)
+            g_textureTranscodeQueue.enqueue({ hash, format, *transcodeFormat, std::vector<uint8_t>(blocks, blocks + dataSize) });
+    }
+
+    TRACE_SCOPE("Decode BC Texture");
+
+    transcodedData.resize(pixelCount * 4);
+    transcodedOffset = 0;
+
+    uint8_t* pixels = transcodedData.data();
+
+    for (uint32_t arraySlice = 0; arraySlice < arraySize; arraySlice++)
+    {
+        for (uint32_t mipSlice = 0; mipSlice < ddsDesc.numMips; mipSlice++)
+        {
+            uint32_t width = std::max(1u, ddsDesc.width >> mipSlice);
+            uint32_t height = std::max(1u, ddsDesc.height >> mipSlice);
+            uint32_t depth = std::max(1u, ddsDesc.depth >> mipSlice);
+
+            DecodeBCImage(*transcodeFormat, blocks, width, height, depth, pixels);
+
+            blocks += ((width + 3) / 4) * ((height + 3) / 4) * depth * blockSize;
+            pixels += size_t(width) * height * depth * 4;
+        }
+    }
+
+    format = RenderFormat::R8G8B8A8_UNORM;
+    ++g_decodedBCTextureCount;
+
+    return true;
+}
+
+// The identity is shared with the caller when it wants the hash of the same data, so it only gets computed once.
+static bool LoadTexture(GuestTexture& texture, const uint8_t* data, size_t dataSize, RenderComponentMapping componentMapping,
+    bool forceCubeMap = false, bool async = false, TextureIdentity* identity = nullptr)
 {
     const uint8_t ktxIdentifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
     if (dataSize > sizeof(KtxHeader) && memcmp(data, ktxIdentifier, 12) == 0)
@@ -5774,6 +7664,9 @@ static bool LoadTexture(GuestTexture& texture, const uint8_t* data, size_t dataS
             texture.width = desc.width;
             texture.height = desc.height;
             texture.viewDimension = viewDesc.dimension;
+            texture.desc = desc;
+            texture.viewDesc = viewDesc;
+            texture.memorySize = ComputeTextureMemorySize(desc);
             uint32_t offset = sizeof(KtxHeader) + header->bytesOfKeyValueData;
             for (uint32_t level = 0; level < desc.mipLevels; level++)
             {
@@ -5805,6 +7698,9 @@ static bool LoadTexture(GuestTexture& texture, const uint8_t* data, size_t dataS
     ddspp::Descriptor ddsDesc;
     if (ddspp::decode_header((unsigned char *)(data), ddsDesc) != ddspp::Error)
     {
+        if (identity != nullptr)
+            identity->blockCompressed = ddsDesc.compressed;
+
         forceCubeMap &= (ddsDesc.type == ddspp::Texture2D) && (ddsDesc.arraySize == 1);
         uint32_t arraySize = ddsDesc.type == ddspp::TextureType::Cubemap ? (ddsDesc.arraySize * 6) : ddsDesc.arraySize;
             
@@ -5818,6 +7714,25 @@ static bool LoadTexture(GuestTexture& texture, const uint8_t* data, size_t dataS
         desc.format = ConvertDXGIFormat(ddsDesc.format);
         desc.flags = ddsDesc.type == ddspp::TextureType::Cubemap ? RenderTextureFlag::CUBE : RenderTextureFlag::NONE;
 
+        // Block dimensions and source data change when the texture gets transcoded.
+        uint32_t blockWidth = ddsDesc.blockWidth;
+        uint32_t blockHeight = ddsDesc.blockHeight;
+        uint32_t bitsPerPixelOrBlock = ddsDesc.bitsPerPixelOrBlock;
+        const uint8_t* imageData = data + ddsDesc.headerSize;
+
+        std::vector<uint8_t> transcodedData;
+        size_t transcodedOffset = 0;
+
+        TextureIdentity localIdentity(data, dataSize);
+
+        if (g_transcodeBCTextures && TranscodeTextureData(ddsDesc, identity != nullptr ? *identity : localIdentity, arraySize, desc.format, transcodedData, transcodedOffset))
+        {
+            blockWidth = RenderFormatBlockWidth(desc.format);
+            blockHeight = blockWidth;
+            bitsPerPixelOrBlock = RenderFormatSize(desc.format) * 8;
+            imageData = transcodedData.data() + transcodedOffset;
+        }
+
         if (forceCubeMap)
         {
             desc.arraySize = 6;
@@ -5844,6 +7759,9 @@ static bool LoadTexture(GuestTexture& texture, const uint8_t* data, size_t dataS
         texture.width = ddsDesc.width;
         texture.height = ddsDesc.height;
         texture.viewDimension = viewDesc.dimension;
+        texture.desc = desc;
+        texture.viewDesc = viewDesc;
+        texture.memorySize = ComputeTextureMemorySize(desc);
 
         struct Slice
         {
@@ -5872,10 +7790,10 @@ static bool LoadTexture(GuestTexture& texture, const uint8_t* data, size_t dataS
                 slice.depth = std::max(1u, ddsDesc.depth >> mipSlice);
                 slice.srcOffset = curSrcOffset;
                 slice.dstOffset = curDstOffset;
-                uint32_t rowPitch = ((slice.width + ddsDesc.blockWidth - 1) / ddsDesc.blockWidth) * ddsDesc.bitsPerPixelOrBlock;
+                uint32_t rowPitch = ((slice.width + blockWidth - 1) / blockWidth) * bitsPerPixelOrBlock;
                 slice.srcRowPitch = (rowPitch + 7) / 8;
                 slice.dstRowPitch = (slice.srcRowPitch + PITCH_ALIGNMENT - 1) & ~(PITCH_ALIGNMENT - 1);
-                slice.rowCount = (slice.height + ddsDesc.blockHeight - 1) / ddsDesc.blockHeight;
+                slice.rowCount = (slice.height + blockHeight - 1) / blockHeight;
 
                 curSrcOffset += slice.srcRowPitch * slice.rowCount * slice.depth;
                 curDstOffset += (slice.dstRowPitch * slice.rowCount * slice.depth + PLACEMENT_ALIGNMENT - 1) & ~(PLACEMENT_ALIGNMENT - 1);
@@ -5887,7 +7805,7 @@ static bool LoadTexture(GuestTexture& texture, const uint8_t* data, size_t dataS
 
         for (auto& slice : slices)
         {
-            const uint8_t* srcData = data + ddsDesc.headerSize + slice.srcOffset;
+            const uint8_t* srcData = imageData + slice.srcOffset;
             uint8_t* dstData = mappedMemory + slice.dstOffset;
 
             if (slice.srcRowPitch == slice.dstRowPitch)
@@ -5915,8 +7833,8 @@ static bool LoadTexture(GuestTexture& texture, const uint8_t* data, size_t dataS
                 texturePtr = texture.texture,
                 format = desc.format,
                 numMips = ddsDesc.numMips,
-                blockWidth = ddsDesc.blockWidth,
-                bitsPerPixelOrBlock = ddsDesc.bitsPerPixelOrBlock,
+                blockWidth,
+                bitsPerPixelOrBlock,
                 forceCubeMap
             ]() mutable {
                 auto& commandList = g_commandLists[g_frame];
@@ -5958,7 +7876,7 @@ static bool LoadTexture(GuestTexture& texture, const uint8_t* data, size_t dataS
                         {
                             g_copyCommandList->copyTextureRegion(
                                 RenderTextureCopyLocation::Subresource(texture.texture, subresourceIndex % ddsDesc.numMips, subresourceIndex / ddsDesc.numMips),
-                                RenderTextureCopyLocation::PlacedFootprint(uploadBuffer.get(), desc.format, slice.width, slice.height, slice.depth, (slice.dstRowPitch * 8) / ddsDesc.bitsPerPixelOrBlock * ddsDesc.blockWidth, slice.dstOffset));
+                                RenderTextureCopyLocation::PlacedFootprint(uploadBuffer.get(), desc.format, slice.width, slice.height, slice.depth, (slice.dstRowPitch * 8) / bitsPerPixelOrBlock * blockWidth, slice.dstOffset));
                         };
 
                     for (size_t i = 0; i < slices.size(); i++)
@@ -6000,22 +7918,9 @@ static bool LoadTexture(GuestTexture& texture, const uint8_t* data, size_t dataS
             task.width = width;
             task.height = height;
 
+            StartTextureLoaderThreads();
             g_textureLoadQueue.enqueue(std::move(task));
 
-                texture.layout = RenderTextureLayout::SHADER_READ;
-            }
-            else
-            {
-                ExecuteCopyCommandList([&]
-                    {
-                        g_copyCommandList->barriers(RenderBarrierStage::COPY, RenderTextureBarrier(texture.texture, RenderTextureLayout::COPY_DEST));
-
-                        g_copyCommandList->copyTextureRegion(
-                            RenderTextureCopyLocation::Subresource(texture.texture, 0),
-                            RenderTextureCopyLocation::PlacedFootprint(uploadBuffer.get(), RenderFormat::R8G8B8A8_UNORM, width, height, 1, rowPitch / 4, 0));
-                    });
-            }
-
             return true;
         }
     }
@@ -6033,31 +7938,19 @@ std::unique_ptr<GuestTexture> LoadTexture(const uint8_t* data, size_t dataSize,
     return nullptr;
 }
 
-static void DiffPatchTexture(GuestTexture& texture, uint8_t* data, uint32_t dataSize, XXH64_hash_t hash)
+static void DiffPatchTexture(GuestTexture& texture, uint8_t* data, uint32_t dataSize, const BlockCompressionDiffPatchEntry& entry)
 {
-    auto header = reinterpret_cast<BlockCompressionDiffPatchHeader*>(g_buttonBcDiff.get());
-    auto entries = reinterpret_cast<BlockCompressionDiffPatchEntry*>(g_buttonBcDiff.get() + header->entriesOffset);
-    auto end = entries + header->entryCount;
-    
-    auto findResult = std::lower_bound(entries, end, hash, [](BlockCompressionDiffPatchEntry& lhs, XXH64_hash_t rhs)
-        {
-            return lhs.hash < rhs;
-        });
-
-    if (findResult != end && findResult->hash == hash)
+    auto patch = reinterpret_cast<BlockCompressionDiffPatch*>(g_buttonBcDiff.get() + entry.patchesOffset);
+    for (size_t i = 0; i < entry.patchCount; i++)
     {
-        auto patch = reinterpret_cast<BlockCompressionDiffPatch*>(g_buttonBcDiff.get() + findResult->patchesOffset);
-        for (size_t i = 0; i < findResult->patchCount; i++)
-        {
-            assert(patch->destinationOffset + patch->patchBytesSize <= dataSize);
-            memcpy(data + patch->destinationOffset, g_buttonBcDiff.get() + patch->patchBytesOffset, patch->patchBytesSize);
-            ++patch;
-        }
-
-        GuestTexture patchedTexture(ResourceType::Texture);
-        if (LoadTexture(patchedTexture, data, dataSize, {}))
-            texture.patchedTexture = std::make_unique<GuestTexture>(std::move(patchedTexture));
+        assert(patch->destinationOffset + patch->patchBytesSize <= dataSize);
+        memcpy(data + patch->destinationOffset, g_buttonBcDiff.get() + patch->patchBytesOffset, patch->patchBytesSize);
+        ++patch;
     }
+
+    GuestTexture patchedTexture(ResourceType::Texture);
+    if (LoadTexture(patchedTexture, data, dataSize, {}))
+        texture.patchedTexture = std::make_unique<GuestTexture>(std::move(patchedTexture));
 }
 
 static void MakePictureData(GuestPictureData* pictureData, uint8_t* data, uint32_t dataSize)
@@ -6065,27 +7958,35 @@ static void MakePictureData(GuestPictureData* pictureData, uint8_t* data, uint32
     if ((pictureData->flags & 0x1) == 0 && data != nullptr)
     {
         GuestTexture texture(ResourceType::Texture);
+        TextureIdentity identity(data, dataSize);
 
-        if (LoadTexture(texture, data, dataSize, {}))
+        if (LoadTexture(texture, data, dataSize, {}, false, false, &identity))
         {
 #ifdef _DEBUG
             texture.texture->setName(reinterpret_cast<char*>(g_memory.Translate(pictureData->name + 2)));
 #endif
-            XXH64_hash_t hash = XXH3_64bits(data, dataSize);
-
-            // The whale in Cool Edge has a 2D texture assigned as a cubemap which makes it not display in recomp.
-            // The hardware duplicates the first face to the remaining 6 faces, so to simulate that we'll recreate the asset.
-            bool forceCubeMap = (dataSize == 0xAB38) && (hash == 0x160E9E250FDE88A9);
-            if (forceCubeMap)
+            auto fixup = g_textureFixups.Find(identity);
+            if (fixup != nullptr && fixup->type == TextureFixupType::ForceCubeMap)
             {
                 GuestTexture recreatedCubeMapTexture(ResourceType::Texture);
-                if (LoadTexture(recreatedCubeMapTexture, data, dataSize, {}, true, true))
+                if (LoadTexture(recreatedCubeMapTexture, data, dataSize, {}, true, true, &identity))
                     texture.recreatedCubeMapTexture = std::make_unique<GuestTexture>(std::move(recreatedCubeMapTexture));
             }
 
-            DiffPatchTexture(texture, data, dataSize, hash);
+            // Changes the data in place, which makes the identity stale.
+            if (fixup != nullptr && fixup->type == TextureFixupType::DiffPatch)
+                DiffPatchTexture(texture, data, dataSize, *fixup->diffPatchEntry);
+
+            auto texturePtr = g_userHeap.AllocPhysical<GuestTexture>(std::move(texture));
 
-            pictureData->texture = g_memory.MapVirtual(g_userHeap.AllocPhysical<GuestTexture>(std::move(texture)));
+            if (texturePtr->memorySize != 0)
+            {
+                std::lock_guard lock(g_textureResidencyMutex);
+                texturePtr->lastUsedFrame = g_residencyFrame.load();
+                g_textureResidency.Track(texturePtr, texturePtr->memorySize);
+            }
+
+            pictureData->texture = g_memory.MapVirtual(texturePtr);
             pictureData->type = 0;
         }
     }
@@ -6448,12 +8349,69 @@ struct PipelineStateQueueItem
     XXH64_hash_t pipelineHash;
     PipelineState pipelineState;
     std::shared_ptr<PipelineTaskToken> token;
+    PipelinePriority priority;
+    bool isPrecompiledPipeline;
+    std::chrono::steady_clock::time_point enqueueTime;
 #ifdef ASYNC_PSO_DEBUG
     std::string pipelineName;
 #endif
 };
 
-static moodycamel::BlockingConcurrentQueue<PipelineStateQueueItem> g_pipelineStateQueue;
+static moodycamel::ConcurrentQueue<PipelineStateQueueItem> g_pipelineStateQueues[size_t(PipelinePriority::Count)];
+static moodycamel::LightweightSemaphore g_pipelineStateQueueSemaphore;
+
+// Hashes of cancelled compilations, so the task consumer thread can forget about them
+// and enqueue them again if they ever get requested.
+static Mutex g_cancelledPipelineMutex;
+static std::vector<XXH64_hash_t> g_cancelledPipelines;
+
+static void EnqueuePipelineStateQueueItem(PipelineStateQueueItem& queueItem)
+{
+    queueItem.enqueueTime = std::chrono::steady_clock::now();
+
+    ++g_pipelineStateQueueDepths[size_t(queueItem.priority)];
+    g_pipelineStateQueues[size_t(queueItem.priority)].enqueue(std::move(queueItem));
+    g_pipelineStateQueueSemaphore.signal();
+}
+
+static void DequeuePipelineStateQueueItem(PipelineStateQueueItem& queueItem)
+{
+    g_pipelineStateQueueSemaphore.wait();
+
+    // The semaphore guarantees an item is available in one of the queues.
+    while (true)
+    {
+        for (size_t i = 0; i < size_t(PipelinePriority::Count); i++)
+        {
+            if (g_pipelineStateQueues[i].try_dequeue(queueItem))
+            {
+                --g_pipelineStateQueueDepths[i];
+                return;
+            }
+        }
+    }
+}
+
+static bool ShouldCancelPipelineCompilation(const PipelineStateQueueItem& queueItem)
+{
+    // The render thread is using a fast linked version in the meantime, this is the one meant to replace it.
+    if (queueItem.priority == PipelinePriority::Optimization)
+        return false;
+
+    // Only stage scoped work gets cancelled, once the game let go of the data it was compiled for. The token
+    // holding the last reference means the stage that loaded it is gone, and nothing is going to draw with it.
+    if (!queueItem.isPrecompiledPipeline && queueItem.token != nullptr && queueItem.token->type == PipelineTaskType::DatabaseData &&
+        queueItem.token->databaseData.unique())
+    {
+        std::lock_guard lock(g_cancelledPipelineMutex);
+        g_cancelledPipelines.push_back(queueItem.pipelineHash);
+        return true;
+    }
+
+    // A draw already needed this one, no point compiling it again.
+    std::lock_guard lock(g_pipelinesCompiledInRenderThreadMutex);
+    return g_pipelinesCompiledInRenderThread.erase(queueItem.pipelineHash) != 0;
+}
 
 static void CompilePipeline(XXH64_hash_t pipelineHash, const PipelineState& pipelineState
 #ifdef ASYNC_PSO_DEBUG
@@ -6461,6 +8419,8 @@ static void CompilePipeline(XXH64_hash_t pipelineHash, const PipelineState& pipe
 #endif
 )
 {
+    TRACE_SCOPE("CompilePipeline");
+
     auto pipeline = CreateGraphicsPipeline(pipelineState);
 #ifdef ASYNC_PSO_DEBUG
     pipeline->setName(pipelineName);
@@ -6474,6 +8434,20 @@ static void CompilePipeline(XXH64_hash_t pipelineHash, const PipelineState& pipe
     g_renderQueue.enqueue(cmd);
 }
 
+static void EnqueuePipelineOptimization(XXH64_hash_t hash, const PipelineState& pipelineState)
+{
+    PipelineStateQueueItem queueItem;
+    queueItem.pipelineHash = hash;
+    queueItem.pipelineState = pipelineState;
+    queueItem.priority = PipelinePriority::Optimization;
+    queueItem.isPrecompiledPipeline = false;
+#ifdef ASYNC_PSO_DEBUG
+    queueItem.pipelineName = fmt::format("OPTIMIZED {} {} {:X}", pipelineState.vertexShader->name,
+        pipelineState.pixelShader != nullptr ? pipelineState.pixelShader->name : "<none>", hash);
+#endif
+    EnqueuePipelineStateQueueItem(queueItem);
+}
+
 static void PipelineCompilerThread()
 {
 #ifdef _WIN32
@@ -6481,13 +8455,22 @@ static void PipelineCompilerThread()
     SetThreadPriority(GetCurrentThread(), threadPriority);
     GuestThread::SetThreadName(GetCurrentThreadId(), "Pipeline Compiler Thread");
 #endif
+    g_traceRecorder.SetThreadName("Pipeline Compiler Thread");
 
     std::unique_ptr<GuestThreadContext> ctx;
 
     while (true)
     {
         PipelineStateQueueItem queueItem;
-        g_pipelineStateQueue.wait_dequeue(queueItem);
+        DequeuePipelineStateQueueItem(queueItem);
+
+        g_pipelineQueueWaitProfiler.Set(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - queueItem.enqueueTime).count());
+
+        if (ShouldCancelPipelineCompilation(queueItem))
+        {
+            ++g_cancelledPipelineCount;
+            continue;
+        }
 
         if (ctx == nullptr)
             ctx = std::make_unique<GuestThreadContext>(0);
@@ -6543,8 +8526,15 @@ struct PipelineTaskTokenPair
 
 // Having this separate, because I don't want to lock a mutex in the render thread before
 // every single draw. Might be worth profiling to see if it actually has an impact and merge them.
-static xxHashMap<PipelineState> g_asyncPipelineStates;
-static constexpr size_t MAX_ASYNC_PIPELINE_STATES = 65536;
+static LruMap<XXH64_hash_t, PipelineState, xxHash> g_asyncPipelineStates(MAX_ASYNC_PIPELINE_STATES);
+
+static void UpdateAsyncPipelineStateStats()
+{
+    g_asyncPipelineStateCount = uint32_t(g_asyncPipelineStates.Size());
+    g_asyncPipelineStateHits = uint32_t(g_asyncPipelineStates.hitCount);
+    g_asyncPipelineStateEvictions = uint32_t(g_asyncPipelineStates.evictionCount);
+    g_asyncPipelineStateMemoryUsage = g_asyncPipelineStates.MemoryUsage();
+}
 
 static void EnqueueGraphicsPipelineCompilation(
     const PipelineState& pipelineState, 
@@ -6553,10 +8543,8 @@ static void EnqueueGraphicsPipelineCompilation(
     bool isPrecompiledPipeline = false)
 {
     XXH64_hash_t hash = XXH3_64bits(&pipelineState, sizeof(pipelineState));
-    bool shouldCompile = g_asyncPipelineStates.emplace(hash, pipelineState).second;
-
-    if (shouldCompile && g_asyncPipelineStates.size() > MAX_ASYNC_PIPELINE_STATES)
-        g_asyncPipelineStates.erase(g_asyncPipelineStates.begin());
+    bool shouldCompile = g_asyncPipelineStates.Insert(hash, pipelineState);
+    UpdateAsyncPipelineStateStats();
 
     if (shouldCompile)
     {
@@ -6579,10 +8567,20 @@ static void EnqueueGraphicsPipelineCompilation(
             queueItem.pipelineHash = hash;
             queueItem.pipelineState = pipelineState;
             queueItem.token = tokenPair.sharedToken;
+            queueItem.isPrecompiledPipeline = isPrecompiledPipeline;
+
+            // Stage loading waits on the database data tokens through the compiling task counter.
+            if (isPrecompiledPipeline || queueItem.token == nullptr)
+                queueItem.priority = PipelinePriority::Speculative;
+            else if (queueItem.token->type == PipelineTaskType::DatabaseData)
+                queueItem.priority = PipelinePriority::Blocking;
+            else
+                queueItem.priority = PipelinePriority::Normal;
+
 #ifdef ASYNC_PSO_DEBUG
             queueItem.pipelineName = fmt::format("ASYNC {} {:X}", name, hash);
 #endif
-            g_pipelineStateQueue.enqueue(queueItem);
+            EnqueuePipelineStateQueueItem(queueItem);
         }
     }
 
@@ -7351,6 +9349,7 @@ static void PipelineTaskConsumerThread()
     SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_IDLE);
     GuestThread::SetThreadName(GetCurrentThreadId(), "Pipeline Task Consumer Thread");
 #endif
+    g_traceRecorder.SetThreadName("Pipeline Task Consumer Thread");
 
     std::vector<PipelineTask> localPipelineTaskQueue;
     std::unique_ptr<GuestThreadContext> ctx;
@@ -7371,6 +9370,14 @@ static void PipelineTaskConsumerThread()
             g_pipelineTaskQueue.clear();
         }
 
+        {
+            std::lock_guard lock(g_cancelledPipelineMutex);
+            for (auto hash : g_cancelledPipelines)
+                g_asyncPipelineStates.Erase(hash);
+
+            g_cancelledPipelines.clear();
+        }
+
         bool allHandled = true;
 
         for (auto& [type, databaseData] : localPipelineTaskQueue)
@@ -7450,9 +9457,6 @@ static void PipelineTaskConsumerThread()
                 // call not incrementing the compiling pipeline task counter.
                 PipelineTaskTokenPair tokenPair;
 
-                for (auto vertexElements : g_vertexDeclarationCache)
-                    CreateVertexDeclarationWithoutAddRef(reinterpret_cast<GuestVertexElement*>(vertexElements));
-
                 for (const auto& templateState : g_pipelineStateCache)
                 {
                     auto pipelineState = templateState;
@@ -7462,10 +9466,7 @@ static void PipelineTaskConsumerThread()
                     if (pipelineState.pixelShader != nullptr)
                         pipelineState.pixelShader = FindShaderCacheEntry(reinterpret_cast<XXH64_hash_t>(pipelineState.pixelShader))->guestShader;
 
-                    {
-                        std::lock_guard lock(g_vertexDeclarationMutex);
-                        pipelineState.vertexDeclaration = g_vertexDeclarations[reinterpret_cast<XXH64_hash_t>(pipelineState.vertexDeclaration)];
-                    }
+                    pipelineState.vertexDeclaration = g_vertexDeclarations.Find(reinterpret_cast<XXH64_hash_t>(pipelineState.vertexDeclaration));
 
                     if (!g_capabilities.triangleFan && pipelineState.primitiveTopology == RenderPrimitiveTopology::TRIANGLE_FAN)
                         pipelineState.primitiveTopology = RenderPrimitiveTopology::TRIANGLE_LIST;
@@ -7549,7 +9550,9 @@ static void PipelineTaskConsumerThread()
                 PipelineTaskTokenPair tokenPair;
                 tokenPair.token.type = type;
 
-                auto asyncPipelines = g_asyncPipelineStates.values();
+                std::vector<std::pair<XXH64_hash_t, PipelineState>> asyncPipelines;
+                asyncPipelines.reserve(g_asyncPipelineStates.Size());
+                g_asyncPipelineStates.ForEach([&](XXH64_hash_t hash, const PipelineState& pipelineState) { asyncPipelines.emplace_back(hash, pipelineState); });
 
                 for (auto& [hash, pipelineState] : asyncPipelines)
                 {
@@ -7626,6 +9629,19 @@ PPC_FUNC(sub_82E328D8)
 
 #endif
 
+class SDLEventListenerForTraceExport : public SDLEventListener
+{
+public:
+    bool OnSDLEvent(SDL_Event* event) override
+    {
+        if (event->type == SDL_QUIT && Config::ExportTraceOnExit && g_traceRecorder.IsEnabled())
+            ExportTrace();
+
+        return false;
+    }
+};
+SDLEventListenerForTraceExport g_sdlEventListenerForTraceExport;
+
 #ifdef PSO_CACHING
 class SDLEventListenerForPSOCaching : public SDLEventListener
 {
@@ -7849,37 +9865,7 @@ bool FxShadowMapMidAsmHook(PPCRegister& r4, PPCRegister& r5, PPCRegister& r6, PP
 static void ConvertToDegenerateTriangles(uint16_t* indices, uint32_t indexCount, uint16_t*& newIndices, uint32_t& newIndexCount)
 {
     newIndices = reinterpret_cast<uint16_t*>(g_userHeap.Alloc(indexCount * sizeof(uint16_t) * 3));
-    newIndexCount = 0;
-
-    bool stripStart = true;
-    uint32_t stripSize = 0;
-    uint16_t lastIndex = 0;
-
-    for (uint32_t i = 0; i < indexCount; i++)
-    {
-        uint16_t index = indices[i];
-        if (index == 0xFFFF)
-        {
-            if ((stripSize % 2) != 0)
-                newIndices[newIndexCount++] = lastIndex;
-
-            stripStart = true;
-            stripSize = 0;
-        }
-        else 
-        {
-            if (stripStart && newIndexCount != 0)
-            {
-                newIndices[newIndexCount++] = lastIndex;
-                newIndices[newIndexCount++] = index;
-            }
-
-            newIndices[newIndexCount++] = index;
-            stripStart = false;
-            ++stripSize;
-            lastIndex = index;
-        }
-    }
+    newIndexCount = ConvertStripRestartsToDegenerates(indices, indexCount, newIndices);
 }
 
 struct MeshResource
@@ -3,8 +3,12 @@
 
 #include <plume_render_interface.h>
 #include <atomic>
+#include <filesystem>
 #include <memory>
 
+#include "render_pass_discard.h"
+#include "texture_dirty_rows.h"
+
 #define D3DCLEAR_TARGET  0x1
 #define D3DCLEAR_ZBUFFER 0x10
 
@@ -15,12 +19,14 @@ struct Video
     static inline uint32_t s_viewportWidth;
     static inline uint32_t s_viewportHeight;
 
-    static bool CreateHostDevice(const char *sdlVideoDriver, bool graphicsApiRetry);
+    static bool CreateHostDevice(const char *sdlVideoDriver, bool graphicsApiRetry, bool nullRenderer);
     static void WaitOnSwapChain();
     static void Present();
     static void StartPipelinePrecompilation();
     static void WaitForGPU();
     static void ComputeViewportDimensions();
+    static void RequestRenderCapture(uint32_t frameCount);
+    static bool ReplayRenderCapture(const std::filesystem::path& path, uint32_t loopCount);
 };
 
 struct GuestSamplerState
@@ -93,6 +99,9 @@ struct GuestBaseTexture : GuestResource
     uint32_t descriptorIndex = 0;
     plume::RenderTextureLayout layout = plume::RenderTextureLayout::UNKNOWN;
 
+    // Set when the memory might have been written through another texture sharing it, so the next barrier drops the contents.
+    bool discardOnBarrier = false;
+
     GuestBaseTexture(ResourceType type) : GuestResource(type)
     {
     }
@@ -104,12 +113,23 @@ struct GuestTexture : GuestBaseTexture
     uint32_t depth = 0;
     plume::RenderTextureViewDimension viewDimension = plume::RenderTextureViewDimension::UNKNOWN;
     void* mappedMemory = nullptr;
+    TextureDirtyRows dirtyRows;
     std::unique_ptr<plume::RenderFramebuffer> framebuffer;
     std::unique_ptr<GuestTexture> patchedTexture;
     std::unique_ptr<GuestTexture> recreatedCubeMapTexture;
     struct GuestSurface* sourceSurface = nullptr;
     std::shared_ptr<std::atomic<bool>> asyncToken = std::make_shared<std::atomic<bool>>(true);
 
+    // Loaded textures remember how they were created, so they can be rebuilt with fewer mip levels when over the memory budget.
+    // The guest facing size above never changes. Dropped levels are kept in host memory, indexed by their mip level, so the
+    // texture can be restored once it gets used again.
+    plume::RenderTextureDesc desc;
+    plume::RenderTextureViewDesc viewDesc;
+    uint64_t memorySize = 0;
+    uint32_t lastUsedFrame = 0;
+    std::vector<std::unique_ptr<plume::RenderBuffer>> droppedMipLevels;
+    uint32_t droppedFrame = 0;
+
     GuestTexture(ResourceType type) : GuestBaseTexture(type) {}
     GuestTexture(GuestTexture&&) = default;
     GuestTexture& operator=(GuestTexture&&) = default;
@@ -159,7 +179,7 @@ struct GuestSurfaceDesc
 struct GuestSurface : GuestBaseTexture
 {
     uint32_t guestFormat = 0;
-    ankerl::unordered_dense::map<const plume::RenderTexture*, std::unique_ptr<plume::RenderFramebuffer>> framebuffers;
+    ankerl::unordered_dense::map<const plume::RenderTexture*, FramebufferVariants<plume::RenderFramebuffer>> framebuffers;
     plume::RenderSampleCounts sampleCount = plume::RenderSampleCount::COUNT_1;
     ankerl::unordered_dense::set<GuestTexture*> destinationTextures;
 };
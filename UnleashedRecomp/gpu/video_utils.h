@@ -4,63 +4,208 @@
 #include <cstddef>
 #include <cstdint>
 
-#if defined(__SSSE3__) || defined(__AVX__)
-#include <tmmintrin.h>
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define VIDEO_UTILS_X86
+#include <immintrin.h>
+#ifdef _WIN32
+#include <intrin.h>
+#endif
 #endif
 
 #ifdef __ARM_NEON
 #include <arm_neon.h>
 #endif
 
+// x86 builds target Sandy Bridge, so AVX2 can only be used from functions compiled for it explicitly.
+#if defined(VIDEO_UTILS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define VIDEO_UTILS_AVX2
+#define VIDEO_UTILS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+enum class CopyAndSwapPath
+{
+    Scalar,
+    SSSE3,
+    AVX2,
+    NEON
+};
+
+inline bool IsAVX2Supported()
+{
+#ifdef VIDEO_UTILS_AVX2
+    static const bool supported = []
+    {
+#ifdef _WIN32
+        int info[4];
+        __cpuid(info, 1);
+
+        // The OS has to save the YMM registers for AVX to be usable at all.
+        constexpr int OSXSAVE = 1 << 27;
+        if ((info[2] & OSXSAVE) == 0 || (_xgetbv(0) & 0x6) != 0x6)
+            return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2") != 0;
+#endif
+    }();
+
+    return supported;
+#else
+    return false;
+#endif
+}
+
+// Returns the fastest path CopyAndSwap can take on this CPU.
+inline CopyAndSwapPath GetCopyAndSwapPath()
+{
+#if defined(__ARM_NEON)
+    return CopyAndSwapPath::NEON;
+#else
+    if (IsAVX2Supported())
+        return CopyAndSwapPath::AVX2;
+
+#if defined(__SSSE3__)
+    return CopyAndSwapPath::SSSE3;
+#else
+    return CopyAndSwapPath::Scalar;
+#endif
+#endif
+}
+
 template<typename T>
-inline void CopyAndSwap(T* dest, const T* src, size_t count)
+inline void CopyAndSwapScalar(T* dest, const T* src, size_t count)
 {
-    size_t i = 0;
+    for (size_t i = 0; i < count; ++i)
+        dest[i] = ByteSwap(src[i]);
+}
+
+// The vector kernels swap whole registers and return how many elements they consumed, the
+// remainder is left to the scalar loop. Element sizes other than 2 and 4 bytes are not vectorized.
 
-    // SIMD implementation for 16-bit integers
+#if defined(__SSSE3__)
+template<typename T>
+inline size_t CopyAndSwapSSSE3(T* dest, const T* src, size_t count)
+{
+    constexpr size_t ELEMENTS = 16 / sizeof(T);
+
+    __m128i mask;
     if constexpr (sizeof(T) == 2)
+        mask = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    else if constexpr (sizeof(T) == 4)
+        mask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    else
+        return 0;
+
+    size_t i = 0;
+    for (; i + ELEMENTS <= count; i += ELEMENTS)
     {
-#if defined(__SSSE3__)
-        const __m128i mask = _mm_setr_epi8(
-            1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+        __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i]), _mm_shuffle_epi8(value, mask));
+    }
 
-        for (; i + 8 <= count; i += 8) {
-            __m128i val = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i]));
-            val = _mm_shuffle_epi8(val, mask);
-            _mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i]), val);
-        }
-#elif defined(__ARM_NEON)
-        for (; i + 8 <= count; i += 8) {
-            uint8x16_t val = vld1q_u8(reinterpret_cast<const uint8_t*>(&src[i]));
-            val = vrev16q_u8(val);
-            vst1q_u8(reinterpret_cast<uint8_t*>(&dest[i]), val);
-        }
+    return i;
+}
 #endif
+
+#ifdef VIDEO_UTILS_AVX2
+template<typename T>
+VIDEO_UTILS_TARGET_AVX2 inline size_t CopyAndSwapAVX2(T* dest, const T* src, size_t count)
+{
+    constexpr size_t ELEMENTS = 32 / sizeof(T);
+
+    // The shuffle works within 128-bit lanes, so both halves use the same pattern.
+    __m256i mask;
+    if constexpr (sizeof(T) == 2)
+    {
+        mask = _mm256_setr_epi8(
+            1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+            1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
     }
-    // SIMD implementation for 32-bit integers
     else if constexpr (sizeof(T) == 4)
     {
-#if defined(__SSSE3__)
-        const __m128i mask = _mm_setr_epi8(
+        mask = _mm256_setr_epi8(
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
             3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    }
+    else
+    {
+        return 0;
+    }
+
+    size_t i = 0;
+    for (; i + ELEMENTS * 2 <= count; i += ELEMENTS * 2)
+    {
+        __m256i value0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&src[i]));
+        __m256i value1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&src[i + ELEMENTS]));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&dest[i]), _mm256_shuffle_epi8(value0, mask));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&dest[i + ELEMENTS]), _mm256_shuffle_epi8(value1, mask));
+    }
 
-        for (; i + 4 <= count; i += 4) {
-            __m128i val = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i]));
-            val = _mm_shuffle_epi8(val, mask);
-            _mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i]), val);
-        }
-#elif defined(__ARM_NEON)
-        for (; i + 4 <= count; i += 4) {
-            uint8x16_t val = vld1q_u8(reinterpret_cast<const uint8_t*>(&src[i]));
-            val = vrev32q_u8(val);
-            vst1q_u8(reinterpret_cast<uint8_t*>(&dest[i]), val);
-        }
+    for (; i + ELEMENTS <= count; i += ELEMENTS)
+    {
+        __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&src[i]));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&dest[i]), _mm256_shuffle_epi8(value, mask));
+    }
+
+    return i;
+}
 #endif
+
+#ifdef __ARM_NEON
+template<typename T>
+inline size_t CopyAndSwapNEON(T* dest, const T* src, size_t count)
+{
+    constexpr size_t ELEMENTS = 16 / sizeof(T);
+
+    if constexpr (sizeof(T) != 2 && sizeof(T) != 4)
+        return 0;
+
+    size_t i = 0;
+    for (; i + ELEMENTS <= count; i += ELEMENTS)
+    {
+        uint8x16_t value = vld1q_u8(reinterpret_cast<const uint8_t*>(&src[i]));
+
+        if constexpr (sizeof(T) == 2)
+            value = vrev16q_u8(value);
+        else
+            value = vrev32q_u8(value);
+
+        vst1q_u8(reinterpret_cast<uint8_t*>(&dest[i]), value);
     }
 
-    // Scalar fallback
-    for (; i < count; ++i)
+    return i;
+}
+#endif
+
+// Copies big endian guest data into host memory. Every guest to host swap-copy in the
+// video layer goes through here, pass a path explicitly only to compare implementations.
+template<typename T>
+inline void CopyAndSwap(T* dest, const T* src, size_t count, CopyAndSwapPath path = GetCopyAndSwapPath())
+{
+    size_t i = 0;
+
+    switch (path)
     {
-        dest[i] = ByteSwap(src[i]);
+#ifdef VIDEO_UTILS_AVX2
+    case CopyAndSwapPath::AVX2:
+        i = CopyAndSwapAVX2(dest, src, count);
+        break;
+#endif
+#if defined(__SSSE3__)
+    case CopyAndSwapPath::SSSE3:
+        i = CopyAndSwapSSSE3(dest, src, count);
+        break;
+#endif
+#ifdef __ARM_NEON
+    case CopyAndSwapPath::NEON:
+        i = CopyAndSwapNEON(dest, src, count);
+        break;
+#endif
+    default:
+        break;
     }
+
+    CopyAndSwapScalar(dest + i, src + i, count - i);
 }
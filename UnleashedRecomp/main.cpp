@@ -346,7 +346,11 @@ struct CommandLineOptions
     bool UseDefaultWorkingDirectory = false;
     bool ForceInstallationCheck = false;
     bool GraphicsApiRetry = false;
+    bool NullRenderer = false;
     const char* SdlVideoDriver = nullptr;
+    uint32_t CaptureFrames = 0;
+    const char* ReplayCapturePath = nullptr;
+    uint32_t ReplayLoops = 1;
 };
 
 CommandLineOptions ParseCommandLineArguments(int argc, char* argv[])
@@ -360,6 +364,7 @@ CommandLineOptions ParseCommandLineArguments(int argc, char* argv[])
         options.UseDefaultWorkingDirectory = options.UseDefaultWorkingDirectory || (strcmp(argv[i], "--use-cwd") == 0);
         options.ForceInstallationCheck = options.ForceInstallationCheck || (strcmp(argv[i], "--install-check") == 0);
         options.GraphicsApiRetry = options.GraphicsApiRetry || (strcmp(argv[i], "--graphics-api-retry") == 0);
+        options.NullRenderer = options.NullRenderer || (strcmp(argv[i], "--null-renderer") == 0);
 
         if (strcmp(argv[i], "--sdl-video-driver") == 0)
         {
@@ -368,6 +373,30 @@ CommandLineOptions ParseCommandLineArguments(int argc, char* argv[])
             else
                 LOGN_WARNING("No argument was specified for --sdl-video-driver. Option will be ignored.");
         }
+
+        if (strcmp(argv[i], "--capture-frames") == 0)
+        {
+            if ((i + 1) < argc)
+                options.CaptureFrames = strtoul(argv[++i], nullptr, 10);
+            else
+                LOGN_WARNING("No argument was specified for --capture-frames. Option will be ignored.");
+        }
+
+        if (strcmp(argv[i], "--replay-capture") == 0)
+        {
+            if ((i + 1) < argc)
+                options.ReplayCapturePath = argv[++i];
+            else
+                LOGN_WARNING("No argument was specified for --replay-capture. Option will be ignored.");
+        }
+
+        if (strcmp(argv[i], "--replay-loops") == 0)
+        {
+            if ((i + 1) < argc)
+                options.ReplayLoops = std::max(1ul, strtoul(argv[++i], nullptr, 10));
+            else
+                LOGN_WARNING("No argument was specified for --replay-loops. Option will be ignored.");
+        }
     }
 
     return options;
@@ -478,7 +507,7 @@ void CheckForUpdates()
 
 void InitializeVideoBackend(const CommandLineOptions& options)
 {
-    if (!Video::CreateHostDevice(options.SdlVideoDriver, options.GraphicsApiRetry))
+    if (!Video::CreateHostDevice(options.SdlVideoDriver, options.GraphicsApiRetry, options.NullRenderer))
     {
         SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, GameWindow::GetTitle(), Localise("Video_BackendError").c_str(), GameWindow::s_pWindow);
         std::exit(1);
@@ -596,6 +625,13 @@ int main(int argc, char *argv[])
         InitializeVideoBackend(options);
     }
 
+    // Replaying a capture doesn't need the game to run, the video backend is all it drives.
+    if (options.ReplayCapturePath != nullptr)
+        std::exit(Video::ReplayRenderCapture(options.ReplayCapturePath, options.ReplayLoops) ? 0 : 1);
+
+    if (options.CaptureFrames != 0)
+        Video::RequestRenderCapture(options.CaptureFrames);
+
     Video::StartPipelinePrecompilation();
 
     GuestThread::Start({ entry, 0, 0 });
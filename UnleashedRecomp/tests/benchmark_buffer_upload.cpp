@@ -6,11 +6,38 @@
 
 #include "gpu/video_utils.h"
 
-// Mock ByteSwap if not available via header in test environment (but it should be)
-// In benchmark_iso_parsing.cpp they link XenonUtils, so byteswap.h should be available.
+// Every guest to host swap-copy in the video layer goes through CopyAndSwap. Each case below mirrors
+// the shape of one call site so a regression in any path shows up with a realistic element count.
+
+static const char* GetPathName(CopyAndSwapPath path)
+{
+    switch (path)
+    {
+    case CopyAndSwapPath::SSSE3: return "SSSE3";
+    case CopyAndSwapPath::AVX2: return "AVX2";
+    case CopyAndSwapPath::NEON: return "NEON";
+    default: return "Scalar";
+    }
+}
+
+static std::vector<CopyAndSwapPath> GetAvailablePaths()
+{
+    std::vector<CopyAndSwapPath> paths = { CopyAndSwapPath::Scalar };
+
+#if defined(__SSSE3__)
+    paths.push_back(CopyAndSwapPath::SSSE3);
+#endif
+#ifdef __ARM_NEON
+    paths.push_back(CopyAndSwapPath::NEON);
+#endif
+    if (IsAVX2Supported())
+        paths.push_back(CopyAndSwapPath::AVX2);
+
+    return paths;
+}
 
 template<typename T>
-void benchmark_copy_and_swap(const std::string& name, size_t num_elements, int iterations) {
+void benchmark_copy_and_swap(const std::string& name, size_t num_elements, size_t total_bytes_target) {
     std::vector<T> src(num_elements);
     std::vector<T> dest(num_elements);
 
@@ -21,38 +48,52 @@ void benchmark_copy_and_swap(const std::string& name, size_t num_elements, int i
         src[i] = static_cast<T>(dist(rng));
     }
 
-    auto start = std::chrono::high_resolution_clock::now();
+    // Keep the amount of data moved the same regardless of the call size.
+    int iterations = std::max<int>(1, int(total_bytes_target / (num_elements * sizeof(T))));
 
-    for (int i = 0; i < iterations; ++i) {
-        CopyAndSwap(dest.data(), src.data(), num_elements);
-        // Prevent compiler optimization
-        if (dest[0] == 0 && dest[num_elements-1] == 0) {
-            std::cout << "";
+    for (auto path : GetAvailablePaths()) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (int i = 0; i < iterations; ++i) {
+            CopyAndSwap(dest.data(), src.data(), num_elements, path);
+            // Prevent compiler optimization
+            if (dest[0] == 0 && dest[num_elements-1] == 0) {
+                std::cout << "";
+            }
         }
-    }
 
-    auto end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double, std::milli> elapsed = end - start;
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> elapsed = end - start;
 
-    double total_bytes = static_cast<double>(num_elements * sizeof(T) * iterations);
-    double throughput = (total_bytes / (1024.0 * 1024.0)) / (elapsed.count() / 1000.0);
+        double total_bytes = static_cast<double>(num_elements * sizeof(T) * iterations);
+        double throughput = (total_bytes / (1024.0 * 1024.0)) / (elapsed.count() / 1000.0);
 
-    std::cout << name << " Type: " << (sizeof(T) == 2 ? "uint16_t" : "uint32_t")
-              << ", Elements: " << num_elements
-              << ", Time: " << elapsed.count() << " ms"
-              << ", Throughput: " << throughput << " MB/s" << std::endl;
+        std::cout << name << ", Path: " << GetPathName(path)
+                  << ", Type: " << (sizeof(T) == 2 ? "uint16_t" : "uint32_t")
+                  << ", Elements: " << num_elements
+                  << ", Time: " << elapsed.count() << " ms"
+                  << ", Throughput: " << throughput << " MB/s" << std::endl;
+    }
 }
 
 int main() {
-    std::cout << "Benchmarking CopyAndSwap..." << std::endl;
+    std::cout << "Benchmarking CopyAndSwap, default path: " << GetPathName(GetCopyAndSwapPath()) << std::endl;
+
+    size_t total_bytes = 1024ull * 1024 * 1024;
+
+    // UploadAllocator::allocate<true> for DrawPrimitiveUP, small vertex batches.
+    benchmark_copy_and_swap<uint32_t>("DrawPrimitiveUP", 96, total_bytes);
+    benchmark_copy_and_swap<uint32_t>("DrawPrimitiveUP", 4096, total_bytes);
+
+    // UploadAllocator::allocate<true> for the vertex and pixel shader constants.
+    benchmark_copy_and_swap<uint32_t>("Shader Constants", 0x400, total_bytes);
 
-    // 1MB buffer
-    size_t size_16 = 1024 * 512;
-    size_t size_32 = 1024 * 256;
-    int iterations = 1000;
+    // UnlockBuffer for index and vertex buffers.
+    benchmark_copy_and_swap<uint16_t>("Index Buffer", 1024 * 512, total_bytes);
+    benchmark_copy_and_swap<uint32_t>("Vertex Buffer", 1024 * 256, total_bytes);
 
-    benchmark_copy_and_swap<uint16_t>("SIMD", size_16, iterations);
-    benchmark_copy_and_swap<uint32_t>("SIMD", size_32, iterations);
+    // Texture fixup rows, one 1280 pixel wide row at a time.
+    benchmark_copy_and_swap<uint32_t>("Texture Row", 1280, total_bytes);
 
     return 0;
 }
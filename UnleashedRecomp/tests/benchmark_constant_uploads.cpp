@@ -0,0 +1,130 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstring>
+
+#include "gpu/video_utils.h"
+#include "gpu/upload_dedup_cache.h"
+
+// Replays a synthetic draw stream through the constant upload path with and without deduplication.
+// Each draw dirties the vertex and pixel constants like the game does, but only some of the draws
+// actually change the contents: per-object transforms change on most draws while the view,
+// projection and lighting blocks stay the same for long runs.
+
+static constexpr size_t VERTEX_CONSTANTS_SIZE = 0x400 * sizeof(uint32_t);
+static constexpr size_t PIXEL_CONSTANTS_SIZE = 0x380 * sizeof(uint32_t);
+static constexpr size_t UPLOAD_BUFFER_SIZE = 16 * 1024 * 1024;
+static constexpr size_t ALIGNMENT = 0x100;
+
+struct DrawStream
+{
+    std::vector<std::vector<uint32_t>> vertexConstants;
+    std::vector<std::vector<uint32_t>> pixelConstants;
+};
+
+// uniqueRatio is the fraction of draws that bring new constant contents.
+static DrawStream CreateDrawStream(size_t drawCount, double uniqueRatio)
+{
+    DrawStream stream;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+
+    std::vector<uint32_t> vertexConstants(VERTEX_CONSTANTS_SIZE / sizeof(uint32_t));
+    std::vector<uint32_t> pixelConstants(PIXEL_CONSTANTS_SIZE / sizeof(uint32_t));
+
+    for (size_t i = 0; i < drawCount; i++)
+    {
+        if (chance(rng) < uniqueRatio)
+            vertexConstants[rng() % 16] = rng();
+
+        // Material changes are rarer than object changes.
+        if (chance(rng) < uniqueRatio * 0.25)
+            pixelConstants[rng() % 16] = rng();
+
+        stream.vertexConstants.push_back(vertexConstants);
+        stream.pixelConstants.push_back(pixelConstants);
+    }
+
+    return stream;
+}
+
+struct UploadBuffer
+{
+    std::vector<uint8_t> memory = std::vector<uint8_t>(UPLOAD_BUFFER_SIZE);
+    size_t offset = 0;
+
+    uint8_t* allocate(const uint32_t* data, size_t size)
+    {
+        offset = (offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        if (offset + size > memory.size())
+            offset = 0;
+
+        auto destination = memory.data() + offset;
+        CopyAndSwap(reinterpret_cast<uint32_t*>(destination), data, size / sizeof(uint32_t));
+        offset += size;
+        return destination;
+    }
+};
+
+static void benchmark_draw_stream(const char* name, size_t drawCount, double uniqueRatio, int frames)
+{
+    auto stream = CreateDrawStream(drawCount, uniqueRatio);
+    UploadBuffer buffer;
+    uint64_t checksum = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int frame = 0; frame < frames; frame++)
+    {
+        for (size_t i = 0; i < drawCount; i++)
+        {
+            checksum += uintptr_t(buffer.allocate(stream.vertexConstants[i].data(), VERTEX_CONSTANTS_SIZE));
+            checksum += uintptr_t(buffer.allocate(stream.pixelConstants[i].data(), PIXEL_CONSTANTS_SIZE));
+        }
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    double baseline = std::chrono::duration<double, std::milli>(end - start).count();
+
+    UploadDedupCache<uint8_t*> cache;
+    start = std::chrono::high_resolution_clock::now();
+
+    for (int frame = 0; frame < frames; frame++)
+    {
+        for (size_t i = 0; i < drawCount; i++)
+        {
+            auto vertexConstants = stream.vertexConstants[i].data();
+            auto pixelConstants = stream.pixelConstants[i].data();
+
+            checksum += uintptr_t(cache.Get(vertexConstants, VERTEX_CONSTANTS_SIZE, [&] { return buffer.allocate(vertexConstants, VERTEX_CONSTANTS_SIZE); }));
+            checksum += uintptr_t(cache.Get(pixelConstants, PIXEL_CONSTANTS_SIZE, [&] { return buffer.allocate(pixelConstants, PIXEL_CONSTANTS_SIZE); }));
+        }
+
+        cache.Reset();
+    }
+
+    end = std::chrono::high_resolution_clock::now();
+    double deduplicated = std::chrono::duration<double, std::milli>(end - start).count();
+
+    double baselineBytes = double(drawCount) * frames * (VERTEX_CONSTANTS_SIZE + PIXEL_CONSTANTS_SIZE);
+
+    std::cout << name << ", Draws/Frame: " << drawCount
+              << ", Unique: " << (uniqueRatio * 100.0) << "%"
+              << ", Baseline: " << baseline << " ms"
+              << ", Deduplicated: " << deduplicated << " ms"
+              << ", Uploaded: " << (double(cache.uploadedBytes) / frames / 1024.0) << " KB/frame"
+              << ", Saved: " << (double(cache.savedBytes) * 100.0 / baselineBytes) << "%"
+              << (checksum == 0 ? " " : "") << std::endl;
+}
+
+int main()
+{
+    std::cout << "Benchmarking constant upload deduplication..." << std::endl;
+
+    benchmark_draw_stream("Static Scene", 2000, 0.05, 100);
+    benchmark_draw_stream("Typical Scene", 2000, 0.5, 100);
+    benchmark_draw_stream("Unique Draws", 2000, 1.0, 100);
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include "gpu/descriptor_index_allocator.h"
+
+// Hammers the texture descriptor allocator from several threads at once, the way loader threads
+// allocate while the render thread frees retired textures. The mutex version mirrors the allocator
+// video.cpp used before.
+
+static constexpr uint32_t CAPACITY = 65536;
+static constexpr uint32_t ITERATION_COUNT = 200000;
+static constexpr uint32_t HELD_COUNT = 256;
+
+struct MutexDescriptorAllocator
+{
+    std::mutex mutex;
+    uint32_t capacity = 0;
+    std::vector<uint32_t> freed;
+
+    MutexDescriptorAllocator(uint32_t, uint32_t firstIndex)
+        : capacity(firstIndex)
+    {
+    }
+
+    uint32_t allocate()
+    {
+        std::lock_guard lock(mutex);
+
+        uint32_t value;
+        if (!freed.empty())
+        {
+            value = freed.back();
+            freed.pop_back();
+        }
+        else
+        {
+            value = capacity;
+            ++capacity;
+        }
+
+        return value;
+    }
+
+    void free(uint32_t value)
+    {
+        std::lock_guard lock(mutex);
+        freed.push_back(value);
+    }
+};
+
+template<typename TAllocator>
+static double Run(uint32_t threadCount)
+{
+    TAllocator allocator(CAPACITY, 1);
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (uint32_t t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([&]
+            {
+                std::vector<uint32_t> indices;
+                indices.reserve(HELD_COUNT);
+
+                for (uint32_t i = 0; i < ITERATION_COUNT; i++)
+                {
+                    if (indices.size() == HELD_COUNT)
+                    {
+                        allocator.free(indices[i % HELD_COUNT]);
+                        indices[i % HELD_COUNT] = allocator.allocate();
+                    }
+                    else
+                    {
+                        indices.push_back(allocator.allocate());
+                    }
+                }
+            });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main()
+{
+    uint32_t maxThreadCount = std::max(2u, std::thread::hardware_concurrency());
+
+    std::cout << "Descriptor allocator contention, " << ITERATION_COUNT << " operations per thread" << std::endl;
+
+    for (uint32_t threadCount = 1; threadCount <= maxThreadCount; threadCount *= 2)
+    {
+        double mutexTime = Run<MutexDescriptorAllocator>(threadCount);
+        double lockFreeTime = Run<DescriptorIndexAllocator>(threadCount);
+
+        std::cout << threadCount << " thread(s): mutex " << mutexTime << " ms, lock-free " << lockFreeTime
+            << " ms, speedup " << (mutexTime / lockFreeTime) << "x" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+#include "gpu/null_render_interface.h"
+
+using namespace plume;
+
+// Measures the CPU cost of driving the render interface with the GPU taken out of the picture.
+// Anything showing up here is overhead of the abstraction itself or of the callers, not the driver.
+
+template<typename TFunction>
+static double measure(TFunction&& function)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    function();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static void benchmark_resource_churn(RenderDevice* device, int iterations)
+{
+    double elapsed = measure([&]
+    {
+        for (int i = 0; i < iterations; ++i)
+        {
+            auto buffer = device->createBuffer(RenderBufferDesc::UploadBuffer(64 * 1024));
+            auto texture = device->createTexture(RenderTextureDesc::Texture2D(256, 256, 1, RenderFormat::R8G8B8A8_UNORM));
+            auto textureView = texture->createTextureView(RenderTextureViewDesc::Texture2D(RenderFormat::R8G8B8A8_UNORM));
+        }
+    });
+
+    std::cout << "Resource Churn, Iterations: " << iterations
+              << ", Time: " << elapsed << " ms"
+              << ", Per Iteration: " << (elapsed * 1000000.0 / iterations) << " ns"
+              << ", Leaked: " << g_nullRenderStats.getTotalLiveCount() << std::endl;
+}
+
+static void benchmark_upload(RenderDevice* device, size_t size, int iterations)
+{
+    auto buffer = device->createBuffer(RenderBufferDesc::UploadBuffer(size));
+    std::vector<uint8_t> source(size, 0xCD);
+
+    double elapsed = measure([&]
+    {
+        for (int i = 0; i < iterations; ++i)
+        {
+            void* dest = buffer->map();
+            memcpy(dest, source.data(), size);
+            buffer->unmap();
+        }
+    });
+
+    double throughput = (double(size) * iterations / (1024.0 * 1024.0)) / (elapsed / 1000.0);
+
+    std::cout << "Upload, Size: " << size
+              << ", Time: " << elapsed << " ms"
+              << ", Throughput: " << throughput << " MB/s" << std::endl;
+}
+
+static void benchmark_recording(RenderDevice* device, RenderCommandQueue* queue, int frames, int drawsPerFrame)
+{
+    auto commandList = queue->createCommandList();
+    auto commandFence = device->createCommandFence();
+    auto pipeline = device->createGraphicsPipeline(RenderGraphicsPipelineDesc());
+    auto vertexBuffer = device->createBuffer(RenderBufferDesc::VertexBuffer(1024 * 1024, RenderHeapType::DEFAULT));
+    auto indexBuffer = device->createBuffer(RenderBufferDesc::IndexBuffer(1024 * 1024, RenderHeapType::DEFAULT));
+
+    RenderVertexBufferView vertexBufferView(vertexBuffer.get(), 1024 * 1024);
+    RenderInputSlot inputSlot(0, 32);
+    RenderIndexBufferView indexBufferView(indexBuffer.get(), 1024 * 1024, RenderFormat::R16_UINT);
+    RenderViewport viewport(0.0f, 0.0f, 1280.0f, 720.0f);
+    RenderRect scissor(0, 0, 1280, 720);
+    uint32_t pushConstants[16] = {};
+
+    g_nullRenderStats.reset();
+
+    double elapsed = measure([&]
+    {
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            commandList->begin();
+
+            for (int draw = 0; draw < drawsPerFrame; ++draw)
+            {
+                commandList->setPipeline(pipeline.get());
+                commandList->setViewports(viewport);
+                commandList->setScissors(scissor);
+                commandList->setVertexBuffers(0, &vertexBufferView, 1, &inputSlot);
+                commandList->setIndexBuffer(&indexBufferView);
+                commandList->setGraphicsPushConstants(0, pushConstants, 0, sizeof(pushConstants));
+                commandList->drawIndexedInstanced(36, 1, 0, 0, 0);
+            }
+
+            commandList->end();
+
+            const RenderCommandList* commandLists[] = { commandList.get() };
+            queue->executeCommandLists(commandLists, 1, nullptr, 0, nullptr, 0, commandFence.get());
+            queue->waitForCommandFence(commandFence.get());
+        }
+    });
+
+    uint64_t commands = g_nullRenderStats.submittedCommands.load();
+
+    std::cout << "Recording, Frames: " << frames
+              << ", Draws/Frame: " << drawsPerFrame
+              << ", Time: " << elapsed << " ms"
+              << ", Per Command: " << (elapsed * 1000000.0 / double(commands)) << " ns"
+              << ", Commands: " << commands
+              << ", Draws: " << g_nullRenderStats.submittedDraws.load() << std::endl;
+}
+
+int main()
+{
+    std::cout << "Benchmarking null render interface..." << std::endl;
+
+    auto renderInterface = CreateNullInterface();
+    auto device = renderInterface->createDevice("");
+    auto queue = device->createCommandQueue(RenderCommandListType::DIRECT);
+
+    benchmark_resource_churn(device.get(), 100000);
+    benchmark_upload(device.get(), 4 * 1024 * 1024, 256);
+    benchmark_recording(device.get(), queue.get(), 1000, 2000);
+
+    return 0;
+}
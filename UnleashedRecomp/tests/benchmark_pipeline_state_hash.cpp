@@ -0,0 +1,158 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <random>
+
+#include <xxhash.h>
+#include <ankerl/unordered_dense.h>
+
+#include "gpu/pipeline_state_hash.h"
+
+// Replays a synthetic draw stream through the pipeline lookup, once hashing the whole pipeline state
+// per draw and once keeping an incremental hash up to date as fields change. Draws mostly switch
+// shaders and a handful of render states between a fixed set of materials, like the game does.
+
+#pragma pack(push, 1)
+struct PipelineState
+{
+    void* vertexShader = nullptr;
+    void* pixelShader = nullptr;
+    void* vertexDeclaration = nullptr;
+    bool instancing = false;
+    bool zEnable = true;
+    bool zWriteEnable = true;
+    uint32_t srcBlend = 0;
+    uint32_t destBlend = 0;
+    uint32_t cullMode = 0;
+    uint32_t zFunc = 0;
+    bool alphaBlendEnable = false;
+    uint32_t blendOp = 0;
+    float slopeScaledDepthBias = 0.0f;
+    int32_t depthBias = 0;
+    uint32_t srcBlendAlpha = 0;
+    uint32_t destBlendAlpha = 0;
+    uint32_t blendOpAlpha = 0;
+    uint32_t colorWriteEnable = 0xF;
+    uint32_t primitiveTopology = 0;
+    uint8_t vertexStrides[16]{};
+    uint32_t renderTargetFormat = 0;
+    uint32_t depthStencilFormat = 0;
+    uint32_t sampleCount = 1;
+    bool enableAlphaToCoverage = false;
+    uint32_t specConstants = 0;
+};
+#pragma pack(pop)
+
+struct Material
+{
+    void* vertexShader;
+    void* pixelShader;
+    void* vertexDeclaration;
+    uint8_t vertexStride;
+    bool alphaBlendEnable;
+    uint32_t cullMode;
+    uint32_t specConstants;
+};
+
+static std::vector<Material> CreateDrawStream(size_t drawCount, size_t materialCount)
+{
+    std::mt19937 rng(42);
+    std::vector<Material> materials;
+
+    for (size_t i = 0; i < materialCount; i++)
+    {
+        materials.push_back({ reinterpret_cast<void*>(uintptr_t(0x1000 + (rng() % 64) * 0x10)), reinterpret_cast<void*>(uintptr_t(0x2000 + i * 0x10)),
+            reinterpret_cast<void*>(uintptr_t(0x3000 + (rng() % 16) * 0x10)), uint8_t(12 + (rng() % 4) * 4), (rng() % 4) == 0, uint32_t(rng() % 3), uint32_t(rng() % 4) });
+    }
+
+    std::vector<Material> stream;
+    for (size_t i = 0; i < drawCount; i++)
+        stream.push_back(materials[rng() % materialCount]);
+
+    return stream;
+}
+
+template<typename TSetValue>
+static void ApplyMaterial(PipelineState& state, const Material& material, TSetValue&& setValue)
+{
+    setValue(state.vertexShader, material.vertexShader);
+    setValue(state.pixelShader, material.pixelShader);
+    setValue(state.vertexDeclaration, material.vertexDeclaration);
+    setValue(state.vertexStrides[0], material.vertexStride);
+    setValue(state.alphaBlendEnable, material.alphaBlendEnable);
+    setValue(state.cullMode, material.cullMode);
+    setValue(state.specConstants, material.specConstants);
+}
+
+static void benchmark_draw_stream(const char* name, size_t drawCount, size_t materialCount, int frames)
+{
+    auto stream = CreateDrawStream(drawCount, materialCount);
+    uint64_t checksum = 0;
+
+    PipelineState state;
+    ankerl::unordered_dense::map<uint64_t, uint64_t> pipelines;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int frame = 0; frame < frames; frame++)
+    {
+        for (auto& material : stream)
+        {
+            ApplyMaterial(state, material, [&]<typename T>(T& dest, const T& src)
+                {
+                    dest = src;
+                });
+
+            uint64_t hash = XXH3_64bits(&state, sizeof(state));
+            checksum += pipelines.try_emplace(hash, hash).first->second;
+        }
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    double fullHash = std::chrono::duration<double, std::milli>(end - start).count();
+
+    state = {};
+    pipelines.clear();
+    IncrementalStateHash<PipelineState> stateHash(state);
+
+    start = std::chrono::high_resolution_clock::now();
+
+    for (int frame = 0; frame < frames; frame++)
+    {
+        for (auto& material : stream)
+        {
+            ApplyMaterial(state, material, [&]<typename T>(T& dest, const T& src)
+                {
+                    if (dest != src)
+                    {
+                        dest = src;
+                        stateHash.Update(state, reinterpret_cast<uint8_t*>(&dest) - reinterpret_cast<uint8_t*>(&state), sizeof(T));
+                    }
+                });
+
+            uint64_t hash = stateHash.Get();
+            checksum += pipelines.try_emplace(hash, hash).first->second;
+        }
+    }
+
+    end = std::chrono::high_resolution_clock::now();
+    double incrementalHash = std::chrono::duration<double, std::milli>(end - start).count();
+
+    std::cout << name << ", Draws/Frame: " << drawCount
+              << ", Materials: " << materialCount
+              << ", Full Hash: " << fullHash << " ms"
+              << ", Incremental Hash: " << incrementalHash << " ms"
+              << ", Pipelines: " << pipelines.size()
+              << (checksum == 0 ? " " : "") << std::endl;
+}
+
+int main()
+{
+    std::cout << "Benchmarking pipeline state hashing..." << std::endl;
+
+    benchmark_draw_stream("Few Materials", 2000, 16, 200);
+    benchmark_draw_stream("Typical Scene", 2000, 256, 200);
+    benchmark_draw_stream("Many Materials", 2000, 2048, 200);
+
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "gpu/shader_cache_table.h"
+
+// Resolves a stage load worth of shader hashes against a sorted entry array, once with the binary search
+// the cache used to do and once through the open addressed table XenosRecomp emits. The entry count of
+// the generated shader cache (g_shaderCacheEntryCount) can be passed as the first argument to match a
+// specific build, otherwise a spread of sizes around it gets measured.
+
+struct Entry
+{
+    uint64_t hash;
+    uint32_t dxilOffset;
+    uint32_t dxilSize;
+    uint32_t spirvOffset;
+    uint32_t spirvSize;
+    uint32_t specConstantsMask;
+    void* guestShader;
+};
+
+struct Slot
+{
+    uint64_t hash;
+    uint32_t entryIndex;
+};
+
+static void benchmark_lookup(size_t entryCount, size_t lookupCount)
+{
+    std::mt19937_64 rng(42);
+
+    std::vector<Entry> entries(entryCount);
+    for (auto& entry : entries)
+        entry.hash = rng();
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) { return lhs.hash < rhs.hash; });
+
+    std::vector<uint64_t> hashes(entryCount);
+    for (size_t i = 0; i < entryCount; i++)
+        hashes[i] = entries[i].hash;
+
+    auto table = BuildShaderCacheTable<Slot>(hashes.data(), hashes.size());
+
+    // Mostly hits, with the occasional shader that isn't in the cache.
+    std::vector<uint64_t> lookups(lookupCount);
+    for (auto& lookup : lookups)
+        lookup = (rng() % 16) != 0 ? hashes[rng() % entryCount] : rng();
+
+    uint64_t checksum = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (uint64_t hash : lookups)
+    {
+        auto findResult = std::lower_bound(entries.begin(), entries.end(), hash, [](const Entry& lhs, uint64_t rhs)
+            {
+                return lhs.hash < rhs;
+            });
+
+        if (findResult != entries.end() && findResult->hash == hash)
+            checksum += findResult->spirvOffset + 1;
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    double binarySearch = std::chrono::duration<double, std::milli>(end - start).count();
+
+    uint64_t tableChecksum = 0;
+
+    start = std::chrono::high_resolution_clock::now();
+
+    for (uint64_t hash : lookups)
+    {
+        uint32_t entryIndex = FindShaderCacheTableIndex(table.data(), table.size() - 1, hash);
+        if (entryIndex != UINT32_MAX)
+            tableChecksum += entries[entryIndex].spirvOffset + 1;
+    }
+
+    end = std::chrono::high_resolution_clock::now();
+    double tableLookup = std::chrono::duration<double, std::milli>(end - start).count();
+
+    std::cout << "Entries: " << entryCount
+              << ", Lookups: " << lookupCount
+              << ", Binary Search: " << binarySearch << " ms"
+              << ", Table: " << tableLookup << " ms"
+              << ", Speedup: " << (binarySearch / tableLookup) << "x"
+              << (checksum == tableChecksum ? "" : ", MISMATCH") << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    std::cout << "Benchmarking shader cache lookups..." << std::endl;
+
+    if (argc > 1)
+    {
+        benchmark_lookup(std::strtoull(argv[1], nullptr, 10), 1000000);
+    }
+    else
+    {
+        benchmark_lookup(2048, 1000000);
+        benchmark_lookup(8192, 1000000);
+        benchmark_lookup(32768, 1000000);
+    }
+
+    return 0;
+}
@@ -0,0 +1,82 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "gpu/barrier_batch.h"
+
+enum class TestLayout
+{
+    Unknown,
+    ShaderRead,
+    ColorWrite,
+    CopyDest
+};
+
+struct TestBarrier
+{
+    int resource;
+    TestLayout layout;
+    bool discard;
+
+    TestBarrier(int resource, TestLayout layout, bool discard) : resource(resource), layout(layout), discard(discard)
+    {
+    }
+};
+
+TEST_CASE("BarrierBatch merges transitions per resource")
+{
+    BarrierBatch<int, TestLayout> batch;
+    CHECK(batch.IsEmpty());
+
+    batch.Add(1, TestLayout::Unknown, TestLayout::CopyDest);
+    batch.Add(2, TestLayout::ColorWrite, TestLayout::ShaderRead);
+    batch.Add(1, TestLayout::CopyDest, TestLayout::ShaderRead);
+    CHECK(batch.entries.size() == 2);
+
+    std::vector<TestBarrier> barriers;
+    CHECK(batch.Resolve(barriers) == 0);
+    CHECK(batch.IsEmpty());
+
+    REQUIRE(barriers.size() == 2);
+    CHECK(barriers[0].resource == 1);
+    CHECK(barriers[0].layout == TestLayout::ShaderRead);
+    CHECK(barriers[1].resource == 2);
+    CHECK(barriers[1].layout == TestLayout::ShaderRead);
+}
+
+TEST_CASE("BarrierBatch drops resources that return to their initial layout")
+{
+    BarrierBatch<int, TestLayout> batch;
+    batch.Add(1, TestLayout::ShaderRead, TestLayout::ColorWrite);
+    batch.Add(1, TestLayout::ColorWrite, TestLayout::ShaderRead);
+    batch.Add(2, TestLayout::ShaderRead, TestLayout::CopyDest);
+
+    std::vector<TestBarrier> barriers;
+    CHECK(batch.Resolve(barriers) == 1);
+
+    REQUIRE(barriers.size() == 1);
+    CHECK(barriers[0].resource == 2);
+    CHECK(barriers[0].layout == TestLayout::CopyDest);
+
+    // Resolving an empty batch doesn't produce anything.
+    barriers.clear();
+    CHECK(batch.Resolve(barriers) == 0);
+    CHECK(barriers.empty());
+}
+
+TEST_CASE("BarrierBatch keeps discarding transitions")
+{
+    BarrierBatch<int, TestLayout> batch;
+    batch.Add(1, TestLayout::ColorWrite, TestLayout::ShaderRead, true);
+    batch.Add(1, TestLayout::ShaderRead, TestLayout::ColorWrite);
+    batch.Add(2, TestLayout::ShaderRead, TestLayout::CopyDest);
+
+    std::vector<TestBarrier> barriers;
+    CHECK(batch.Resolve(barriers) == 0);
+
+    // The first resource ends up where it started, but its contents still have to be dropped.
+    REQUIRE(barriers.size() == 2);
+    CHECK(barriers[0].resource == 1);
+    CHECK(barriers[0].layout == TestLayout::ColorWrite);
+    CHECK(barriers[0].discard);
+    CHECK(barriers[1].resource == 2);
+    CHECK(!barriers[1].discard);
+}
@@ -0,0 +1,105 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "gpu/concurrent_hash_registry.h"
+
+#include <thread>
+#include <vector>
+
+struct Object
+{
+    uint64_t hash;
+};
+
+TEST_CASE("Objects are created once")
+{
+    ConcurrentHashRegistry<Object, 16> registry;
+    std::vector<std::unique_ptr<Object>> objects;
+
+    auto create = [&](uint64_t hash)
+        {
+            return registry.FindOrCreate(hash, [&]
+                {
+                    return objects.emplace_back(std::make_unique<Object>(Object{ hash })).get();
+                });
+        };
+
+    CHECK(registry.Find(1) == nullptr);
+
+    auto first = create(1);
+    CHECK(first->hash == 1);
+    CHECK(create(1) == first);
+    CHECK(registry.Find(1) == first);
+
+    // Colliding slots probe forward.
+    auto second = create(1 + registry.SLOT_COUNT);
+    CHECK(second != first);
+    CHECK(registry.Find(1 + registry.SLOT_COUNT) == second);
+    CHECK(registry.Find(1) == first);
+
+    CHECK(objects.size() == 2);
+    CHECK(registry.count == 2);
+}
+
+TEST_CASE("Objects past the capacity overflow")
+{
+    ConcurrentHashRegistry<Object, 4> registry;
+    std::vector<std::unique_ptr<Object>> objects;
+
+    for (uint64_t i = 1; i <= 8; i++)
+    {
+        registry.FindOrCreate(i * 0x1000, [&]
+            {
+                return objects.emplace_back(std::make_unique<Object>(Object{ i * 0x1000 })).get();
+            });
+    }
+
+    CHECK(registry.count == 4);
+    CHECK(registry.overflowed);
+    CHECK(objects.size() == 8);
+
+    for (uint64_t i = 1; i <= 8; i++)
+    {
+        auto object = registry.Find(i * 0x1000);
+        REQUIRE(object != nullptr);
+        CHECK(object->hash == i * 0x1000);
+    }
+
+    CHECK(registry.Find(0x1234) == nullptr);
+}
+
+TEST_CASE("Concurrent creation and lookup")
+{
+    constexpr size_t THREAD_COUNT = 8;
+    constexpr uint64_t HASH_COUNT = 512;
+
+    ConcurrentHashRegistry<Object, 512> registry;
+    std::vector<std::unique_ptr<Object>> objects;
+    std::atomic<uint32_t> mismatches = 0;
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < THREAD_COUNT; i++)
+    {
+        threads.emplace_back([&, i]
+            {
+                for (uint64_t j = 0; j < HASH_COUNT; j++)
+                {
+                    uint64_t hash = ((j + i * 37) % HASH_COUNT + 1) * 0x9E3779B97F4A7C15ull;
+
+                    auto object = registry.FindOrCreate(hash, [&]
+                        {
+                            return objects.emplace_back(std::make_unique<Object>(Object{ hash })).get();
+                        });
+
+                    if (object->hash != hash || registry.Find(hash) != object)
+                        ++mismatches;
+                }
+            });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    CHECK(mismatches == 0);
+    CHECK(objects.size() == HASH_COUNT);
+    CHECK(registry.count == HASH_COUNT);
+}
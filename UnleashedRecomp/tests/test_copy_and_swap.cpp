@@ -0,0 +1,70 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include <vector>
+#include "gpu/video_utils.h"
+
+static std::vector<CopyAndSwapPath> GetAvailablePaths()
+{
+    std::vector<CopyAndSwapPath> paths = { CopyAndSwapPath::Scalar };
+
+#if defined(__SSSE3__)
+    paths.push_back(CopyAndSwapPath::SSSE3);
+#endif
+#ifdef __ARM_NEON
+    paths.push_back(CopyAndSwapPath::NEON);
+#endif
+    if (IsAVX2Supported())
+        paths.push_back(CopyAndSwapPath::AVX2);
+
+    return paths;
+}
+
+template<typename T>
+static void CheckCopyAndSwap(CopyAndSwapPath path)
+{
+    // Odd counts and offsets make sure the tails and unaligned accesses are covered.
+    std::vector<T> src(300);
+    for (size_t i = 0; i < src.size(); i++)
+        src[i] = static_cast<T>(0x0102030405060708ull * (i + 1));
+
+    for (size_t offset = 0; offset < 3; offset++)
+    {
+        for (size_t count = 0; count < 200; count++)
+        {
+            std::vector<T> dest(count + offset + 1, T(0xCD));
+            CopyAndSwap(dest.data() + offset, src.data() + offset, count, path);
+
+            bool matches = true;
+            for (size_t i = 0; i < count; i++)
+                matches &= dest[offset + i] == ByteSwap(src[offset + i]);
+
+            CHECK(matches);
+
+            // Nothing past the end gets written.
+            CHECK(dest[offset + count] == T(0xCD));
+        }
+    }
+}
+
+TEST_CASE("CopyAndSwap matches scalar swap on every path")
+{
+    for (auto path : GetAvailablePaths())
+    {
+        CAPTURE(int(path));
+        CheckCopyAndSwap<uint16_t>(path);
+        CheckCopyAndSwap<uint32_t>(path);
+        CheckCopyAndSwap<uint64_t>(path);
+    }
+}
+
+TEST_CASE("CopyAndSwap picks a supported path")
+{
+    auto path = GetCopyAndSwapPath();
+
+#ifdef __ARM_NEON
+    CHECK(path == CopyAndSwapPath::NEON);
+#else
+    CHECK(path != CopyAndSwapPath::NEON);
+    CHECK((path == CopyAndSwapPath::AVX2) == IsAVX2Supported());
+#endif
+}
@@ -0,0 +1,84 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "gpu/descriptor_index_allocator.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Fresh indices start after the reserved ones")
+{
+    DescriptorIndexAllocator allocator(16, 4);
+
+    CHECK(allocator.allocate() == 4);
+    CHECK(allocator.allocate() == 5);
+    CHECK(allocator.allocate() == 6);
+    CHECK(allocator.getUsedCount() == 3);
+}
+
+TEST_CASE("Freed indices are reused before fresh ones")
+{
+    DescriptorIndexAllocator allocator(16);
+
+    uint32_t a = allocator.allocate();
+    uint32_t b = allocator.allocate();
+    uint32_t c = allocator.allocate();
+
+    allocator.free(a);
+    allocator.free(c);
+    CHECK(allocator.getUsedCount() == 1);
+
+    // Last freed comes back first.
+    CHECK(allocator.allocate() == c);
+    CHECK(allocator.allocate() == a);
+    CHECK(allocator.allocate() == 3);
+    CHECK(allocator.getUsedCount() == 4);
+
+    allocator.free(b);
+    CHECK(allocator.allocate() == b);
+}
+
+TEST_CASE("Concurrent allocations never hand out the same index twice")
+{
+    constexpr uint32_t THREAD_COUNT = 8;
+    constexpr uint32_t ITERATION_COUNT = 20000;
+    constexpr uint32_t HELD_COUNT = 64;
+
+    DescriptorIndexAllocator allocator(THREAD_COUNT * HELD_COUNT + 1, 1);
+    std::vector<std::vector<uint32_t>> held(THREAD_COUNT);
+    std::vector<std::thread> threads;
+
+    for (uint32_t t = 0; t < THREAD_COUNT; t++)
+    {
+        threads.emplace_back([&, t]
+            {
+                auto& indices = held[t];
+
+                for (uint32_t i = 0; i < ITERATION_COUNT; i++)
+                {
+                    if (indices.size() == HELD_COUNT)
+                    {
+                        allocator.free(indices[i % HELD_COUNT]);
+                        indices[i % HELD_COUNT] = allocator.allocate();
+                    }
+                    else
+                    {
+                        indices.push_back(allocator.allocate());
+                    }
+                }
+            });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    std::vector<uint32_t> all;
+    for (auto& indices : held)
+        all.insert(all.end(), indices.begin(), indices.end());
+
+    std::sort(all.begin(), all.end());
+    CHECK(std::adjacent_find(all.begin(), all.end()) == all.end());
+    CHECK(all.front() >= 1);
+    CHECK(all.back() <= THREAD_COUNT * HELD_COUNT);
+    CHECK(allocator.getUsedCount() == THREAD_COUNT * HELD_COUNT);
+}
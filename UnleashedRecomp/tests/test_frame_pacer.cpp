@@ -0,0 +1,90 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "gpu/frame_pacer.h"
+
+using namespace std::chrono_literals;
+
+TEST_CASE("Frame timing stats")
+{
+    FrameTimingStats stats;
+    CHECK(stats.GetAverage() == 0.0);
+    CHECK(stats.GetJitter() == 0.0);
+
+    stats.Add(16.0);
+    stats.Add(18.0);
+    stats.Add(16.0);
+    stats.Add(18.0);
+
+    CHECK(stats.GetAverage() == doctest::Approx(17.0));
+    CHECK(stats.GetJitter() == doctest::Approx(1.0));
+    CHECK(stats.GetMax() == 18.0);
+
+    // Old values fall out of the window.
+    for (size_t i = 0; i < FrameTimingStats::WINDOW_SIZE; i++)
+        stats.Add(10.0);
+
+    CHECK(stats.GetAverage() == doctest::Approx(10.0));
+    CHECK(stats.GetJitter() == doctest::Approx(0.0));
+}
+
+TEST_CASE("Wake latency estimate converges")
+{
+    FramePacer pacer;
+
+    for (size_t i = 0; i < 64; i++)
+        pacer.AddWakeLatency(200000.0);
+
+    CHECK(pacer.wakeLatency == doctest::Approx(200000.0).epsilon(0.01));
+    CHECK(pacer.wakeLatencyDeviation < 1000.0);
+    CHECK(pacer.GetSleepMargin() < 210us);
+}
+
+TEST_CASE("Sleep margin never goes negative")
+{
+    FramePacer pacer;
+
+    // Timers that wake up early would otherwise make the pacer sleep past the deadline.
+    for (size_t i = 0; i < 64; i++)
+        pacer.AddWakeLatency(-500000.0);
+
+    CHECK(pacer.wakeLatency < 0.0);
+    CHECK(pacer.GetSleepMargin() == FramePacer::Clock::duration::zero());
+}
+
+TEST_CASE("Pacer holds the frame time with an oversleeping timer")
+{
+    FramePacer pacer;
+
+    // Simulates a timer that always wakes up 300 microseconds late.
+    auto sleepUntil = [](FramePacer::Clock::time_point time)
+        {
+            SleepUntil(time + 300us);
+        };
+
+    pacer.Wait(4ms, sleepUntil);
+    auto start = FramePacer::Clock::now();
+
+    for (size_t i = 0; i < 50; i++)
+        pacer.Wait(4ms, sleepUntil);
+
+    double elapsed = std::chrono::duration<double, std::milli>(FramePacer::Clock::now() - start).count();
+    CHECK(elapsed >= 50 * 4.0 - 4.0);
+    CHECK(elapsed < 50 * 4.0 + 20.0);
+
+    // Learned the late wake ups, so the sleep ends before the deadline.
+    CHECK(pacer.wakeLatency > 250000.0);
+}
+
+TEST_CASE("Late frames resynchronize")
+{
+    FramePacer pacer;
+    pacer.Wait(2ms);
+
+    std::this_thread::sleep_for(10ms);
+
+    auto before = FramePacer::Clock::now();
+    pacer.Wait(2ms);
+    CHECK(FramePacer::Clock::now() - before < 2ms);
+    CHECK(pacer.spinNanoseconds == 0);
+    CHECK(pacer.next - before <= 3ms);
+}
@@ -0,0 +1,59 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "gpu/index_generation.h"
+
+TEST_CASE("Triangle fan indices grow without touching existing ones")
+{
+    std::vector<uint16_t> indices(4 * 3, 0xCDCD);
+    GenerateTriangleFanIndices(indices.data(), 0, 2);
+    GenerateTriangleFanIndices(indices.data(), 2, 2);
+
+    std::vector<uint16_t> expected = { 0, 1, 2, 0, 2, 3, 0, 3, 4, 0, 4, 5 };
+    CHECK(indices == expected);
+}
+
+TEST_CASE("Quad list indices")
+{
+    std::vector<uint16_t> indices(2 * 6);
+    GenerateQuadListIndices(indices.data(), 0, 1);
+    GenerateQuadListIndices(indices.data(), 1, 1);
+
+    std::vector<uint16_t> expected = { 0, 1, 2, 0, 2, 3, 4, 5, 6, 4, 6, 7 };
+    CHECK(indices == expected);
+}
+
+TEST_CASE("Strip restarts become degenerate triangles")
+{
+    uint16_t buffer[32];
+    auto convert = [&](const uint16_t* indices, uint32_t indexCount)
+        {
+            return std::vector<uint16_t>(buffer, buffer + ConvertStripRestartsToDegenerates(indices, indexCount, buffer));
+        };
+
+    SUBCASE("Even strip")
+    {
+        uint16_t indices[] = { 0, 1, 2, 3, 0xFFFF, 4, 5, 6 };
+        auto newIndices = convert(indices, 8);
+
+        std::vector<uint16_t> expected = { 0, 1, 2, 3, 3, 4, 4, 5, 6 };
+        CHECK(newIndices == expected);
+    }
+
+    SUBCASE("Odd strip keeps the winding")
+    {
+        uint16_t indices[] = { 0, 1, 2, 0xFFFF, 3, 4, 5 };
+        auto newIndices = convert(indices, 7);
+
+        std::vector<uint16_t> expected = { 0, 1, 2, 2, 2, 3, 3, 4, 5 };
+        CHECK(newIndices == expected);
+    }
+
+    SUBCASE("No restarts")
+    {
+        uint16_t indices[] = { 7, 8, 9 };
+        auto newIndices = convert(indices, 3);
+
+        std::vector<uint16_t> expected = { 7, 8, 9 };
+        CHECK(newIndices == expected);
+    }
+}
@@ -0,0 +1,71 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include <vector>
+#include "gpu/lru_map.h"
+
+TEST_CASE("LruMap insertion and eviction")
+{
+    LruMap<uint64_t, int> map(3);
+
+    CHECK(map.Insert(1, 10));
+    CHECK(map.Insert(2, 20));
+    CHECK(map.Insert(3, 30));
+    CHECK(map.Size() == 3);
+
+    SUBCASE("Existing keys are not inserted again")
+    {
+        CHECK_FALSE(map.Insert(2, 200));
+        CHECK(*map.Find(2) == 20);
+        CHECK(map.hitCount == 1);
+        CHECK(map.missCount == 3);
+    }
+
+    SUBCASE("Least recently used entry gets evicted")
+    {
+        // Touch the oldest entry, so the second one becomes the eviction candidate.
+        CHECK_FALSE(map.Insert(1, 10));
+        CHECK(map.Insert(4, 40));
+
+        CHECK(map.Size() == 3);
+        CHECK(map.evictionCount == 1);
+        CHECK(map.Find(2) == nullptr);
+        CHECK(map.Find(1) != nullptr);
+        CHECK(map.Find(3) != nullptr);
+        CHECK(map.Find(4) != nullptr);
+    }
+
+    SUBCASE("Find refreshes recency")
+    {
+        CHECK(map.Find(1) != nullptr);
+        CHECK(map.Insert(4, 40));
+        CHECK(map.Find(1) != nullptr);
+        CHECK(map.Find(2) == nullptr);
+    }
+
+    SUBCASE("Erased keys can be inserted again")
+    {
+        CHECK(map.Erase(3));
+        CHECK_FALSE(map.Erase(3));
+        CHECK(map.Size() == 2);
+        CHECK(map.Insert(3, 33));
+        CHECK(*map.Find(3) == 33);
+        CHECK(map.evictionCount == 0);
+    }
+
+    SUBCASE("Erased slots are reused")
+    {
+        CHECK(map.Erase(2));
+        CHECK(map.Insert(5, 50));
+        CHECK(map.nodes.size() == 3);
+        CHECK(*map.Find(5) == 50);
+    }
+
+    SUBCASE("Iteration order is most recently used first")
+    {
+        CHECK(map.Find(2) != nullptr);
+
+        std::vector<uint64_t> keys;
+        map.ForEach([&](uint64_t key, int) { keys.push_back(key); });
+        CHECK(keys == std::vector<uint64_t>{ 2, 3, 1 });
+    }
+}
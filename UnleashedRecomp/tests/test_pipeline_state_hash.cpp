@@ -0,0 +1,91 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "gpu/pipeline_state_hash.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// Packed and oddly sized like the real pipeline state, so fields straddle word boundaries.
+#pragma pack(push, 1)
+struct TestState
+{
+    void* vertexShader = nullptr;
+    void* pixelShader = nullptr;
+    bool zEnable = true;
+    uint32_t srcBlend = 1;
+    float depthBias = 0.0f;
+    uint8_t vertexStrides[16]{};
+    uint32_t specConstants = 0;
+    uint8_t sampleCount = 1;
+};
+#pragma pack(pop)
+
+template<typename T>
+static void SetValue(TestState& state, IncrementalStateHash<TestState>& hash, T& dest, const T& src)
+{
+    dest = src;
+    hash.Update(state, reinterpret_cast<uint8_t*>(&dest) - reinterpret_cast<uint8_t*>(&state), sizeof(T));
+}
+
+TEST_CASE("Incremental updates match a full rehash")
+{
+    TestState state;
+    IncrementalStateHash<TestState> hash(state);
+    std::mt19937 rng(42);
+
+    for (size_t i = 0; i < 10000; i++)
+    {
+        switch (rng() % 6)
+        {
+        case 0: SetValue(state, hash, state.pixelShader, reinterpret_cast<void*>(uintptr_t(rng() % 8))); break;
+        case 1: SetValue(state, hash, state.zEnable, bool(rng() & 1)); break;
+        case 2: SetValue(state, hash, state.srcBlend, uint32_t(rng() % 4)); break;
+        case 3: SetValue(state, hash, state.vertexStrides[rng() % 16], uint8_t(rng() % 4)); break;
+        case 4: SetValue(state, hash, state.specConstants, uint32_t(rng() % 4)); break;
+        case 5: SetValue(state, hash, state.sampleCount, uint8_t(1 << (rng() % 3))); break;
+        }
+
+        IncrementalStateHash<TestState> reference(state);
+        REQUIRE(hash.Get() == reference.Get());
+    }
+}
+
+TEST_CASE("Reverting a change restores the hash")
+{
+    TestState state;
+    IncrementalStateHash<TestState> hash(state);
+    uint64_t initial = hash.Get();
+
+    SetValue(state, hash, state.specConstants, 0x10u);
+    CHECK(hash.Get() != initial);
+
+    SetValue(state, hash, state.specConstants, 0u);
+    CHECK(hash.Get() == initial);
+}
+
+TEST_CASE("Moving a value to another field changes the hash")
+{
+    TestState lhs;
+    TestState rhs;
+    lhs.vertexStrides[0] = 12;
+    rhs.vertexStrides[8] = 12;
+
+    CHECK(IncrementalStateHash<TestState>(lhs).Get() != IncrementalStateHash<TestState>(rhs).Get());
+}
+
+TEST_CASE("Distinct states hash differently")
+{
+    TestState state;
+    std::vector<uint64_t> hashes;
+
+    for (uint32_t i = 0; i < 4096; i++)
+    {
+        state.specConstants = i;
+        state.srcBlend = i % 7;
+        hashes.push_back(IncrementalStateHash<TestState>(state).Get());
+    }
+
+    std::sort(hashes.begin(), hashes.end());
+    CHECK(std::adjacent_find(hashes.begin(), hashes.end()) == hashes.end());
+}
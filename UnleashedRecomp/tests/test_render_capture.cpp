@@ -0,0 +1,140 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include "gpu/render_capture.h"
+
+static std::filesystem::path GetTestCapturePath()
+{
+    return std::filesystem::temp_directory_path() / "test_render_capture.bin";
+}
+
+struct TestCommand
+{
+    uint32_t type;
+    uint64_t object;
+};
+
+TEST_CASE("RenderCapture round trip")
+{
+    auto path = GetTestCapturePath();
+    std::filesystem::remove(path);
+
+    uint8_t blob[] = { 1, 2, 3, 4, 5 };
+    uint8_t objectData[] = { 0xAA, 0xBB };
+
+    {
+        RenderCaptureWriter writer;
+        REQUIRE(writer.Open(path, sizeof(TestCommand)));
+
+        CHECK(writer.MarkObject(0x1000));
+        CHECK_FALSE(writer.MarkObject(0x1000));
+        CHECK_FALSE(writer.MarkObject(0));
+
+        RenderCaptureObject object{};
+        object.id = 0x1000;
+        object.resourceType = 2;
+        object.width = 640;
+        object.dataSize = sizeof(objectData);
+        writer.WriteObject(object, objectData);
+
+        TestCommand command{ 7, 0x1000 };
+        writer.Write(RenderCaptureRecordKind::Command, command.type, &command, sizeof(command));
+        writer.Write(RenderCaptureRecordKind::Blob, 0, blob, sizeof(blob));
+        writer.EndFrame();
+        writer.EndFrame();
+
+        CHECK(writer.recordCount == 5);
+        CHECK(writer.Close());
+    }
+
+    SUBCASE("Records are read back in order")
+    {
+        RenderCaptureReader reader;
+        REQUIRE(reader.Open(path, sizeof(TestCommand)));
+        CHECK(reader.header.frameCount == 2);
+        REQUIRE(reader.records.size() == 5);
+
+        auto& objectRecord = reader.records[0];
+        CHECK(objectRecord.kind == RenderCaptureRecordKind::Object);
+        CHECK(objectRecord.subtype == 2);
+        REQUIRE(objectRecord.size == sizeof(RenderCaptureObject) + sizeof(objectData));
+
+        RenderCaptureObject object;
+        memcpy(&object, objectRecord.data, sizeof(object));
+        CHECK(object.id == 0x1000);
+        CHECK(object.width == 640);
+        CHECK(memcmp(objectRecord.data + sizeof(object), objectData, sizeof(objectData)) == 0);
+
+        auto& commandRecord = reader.records[1];
+        CHECK(commandRecord.kind == RenderCaptureRecordKind::Command);
+        CHECK(commandRecord.subtype == 7);
+
+        TestCommand command;
+        memcpy(&command, commandRecord.data, sizeof(command));
+        CHECK(command.object == 0x1000);
+
+        CHECK(reader.records[2].kind == RenderCaptureRecordKind::Blob);
+        CHECK(memcmp(reader.records[2].data, blob, sizeof(blob)) == 0);
+        CHECK(reader.records[3].kind == RenderCaptureRecordKind::FrameEnd);
+        CHECK(reader.records[4].kind == RenderCaptureRecordKind::FrameEnd);
+    }
+
+    SUBCASE("Mismatching command layout is rejected")
+    {
+        RenderCaptureReader reader;
+        CHECK_FALSE(reader.Open(path, sizeof(TestCommand) + 8));
+    }
+
+    SUBCASE("Truncated capture keeps complete records")
+    {
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - sizeof(RenderCaptureWriter::RecordHeader) * 2 - 1);
+
+        RenderCaptureReader reader;
+        REQUIRE(reader.Open(path, sizeof(TestCommand)));
+        CHECK(reader.records.size() == 2);
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("RenderCommandTimings report")
+{
+    RenderCommandTimings timings;
+    timings.Add(1, 1000);
+    timings.Add(1, 3000);
+    timings.Add(4, 10000);
+
+    CHECK(timings.entries[1].count == 2);
+    CHECK(timings.entries[1].totalNs == 4000);
+    CHECK(timings.entries[1].minNs == 1000);
+    CHECK(timings.entries[1].maxNs == 3000);
+
+    auto path = std::filesystem::temp_directory_path() / "test_render_capture_report.txt";
+    FILE* file = fopen(path.string().c_str(), "w");
+    REQUIRE(file != nullptr);
+    timings.WriteReport(file, [](uint32_t type) { return type == 1 ? "Draw" : "Clear"; });
+    fclose(file);
+
+    std::string report;
+    file = fopen(path.string().c_str(), "r");
+    REQUIRE(file != nullptr);
+
+    char buffer[256];
+    while (fgets(buffer, sizeof(buffer), file) != nullptr)
+        report += buffer;
+
+    fclose(file);
+    std::filesystem::remove(path);
+
+    // The slowest command type comes first.
+    auto clearPosition = report.find("Clear");
+    auto drawPosition = report.find("Draw");
+    REQUIRE(clearPosition != std::string::npos);
+    REQUIRE(drawPosition != std::string::npos);
+    CHECK(clearPosition < drawPosition);
+
+    timings.Reset();
+    CHECK(timings.entries[1].count == 0);
+}
@@ -0,0 +1,56 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "gpu/render_pass_discard.h"
+
+struct TestFramebuffer
+{
+    uint32_t discard;
+};
+
+static FramebufferVariants<TestFramebuffer> CreateVariants()
+{
+    FramebufferVariants<TestFramebuffer> variants;
+    for (uint32_t i = 0; i < RENDER_PASS_DISCARD_VARIANT_COUNT; i++)
+        variants[i] = std::make_unique<TestFramebuffer>(TestFramebuffer{ i });
+
+    return variants;
+}
+
+TEST_CASE("Unbound framebuffers pick the requested variant")
+{
+    auto variants = CreateVariants();
+    TestFramebuffer other{};
+
+    CHECK(variants.Select(nullptr, RENDER_PASS_DISCARD_NONE) == RENDER_PASS_DISCARD_NONE);
+    CHECK(variants.Select(nullptr, RENDER_PASS_DISCARD_COLOR | RENDER_PASS_DISCARD_DEPTH) == (RENDER_PASS_DISCARD_COLOR | RENDER_PASS_DISCARD_DEPTH));
+    CHECK(variants.Select(&other, RENDER_PASS_DISCARD_DEPTH) == RENDER_PASS_DISCARD_DEPTH);
+}
+
+TEST_CASE("Bound variants stay bound")
+{
+    auto variants = CreateVariants();
+
+    // A draw after a clear keeps going in the pass the clear started.
+    CHECK(variants.Select(variants[RENDER_PASS_DISCARD_COLOR].get(), RENDER_PASS_DISCARD_NONE) == RENDER_PASS_DISCARD_COLOR);
+
+    // A clear after draws mustn't start a pass that discards them.
+    CHECK(variants.Select(variants[RENDER_PASS_DISCARD_NONE].get(), RENDER_PASS_DISCARD_COLOR) == RENDER_PASS_DISCARD_NONE);
+}
+
+TEST_CASE("Variants that were never created can't match")
+{
+    FramebufferVariants<TestFramebuffer> variants;
+    variants[RENDER_PASS_DISCARD_DEPTH] = std::make_unique<TestFramebuffer>();
+
+    CHECK(variants.Select(variants[RENDER_PASS_DISCARD_DEPTH].get(), RENDER_PASS_DISCARD_COLOR) == RENDER_PASS_DISCARD_DEPTH);
+    CHECK(variants.Select(variants[RENDER_PASS_DISCARD_NONE].get(), RENDER_PASS_DISCARD_COLOR) == RENDER_PASS_DISCARD_COLOR);
+}
+
+TEST_CASE("Clears discard only the attachments they cover")
+{
+    CHECK(GetClearDiscard(true, true, true, true) == (RENDER_PASS_DISCARD_COLOR | RENDER_PASS_DISCARD_DEPTH));
+    CHECK(GetClearDiscard(true, true, true, false) == RENDER_PASS_DISCARD_COLOR);
+    CHECK(GetClearDiscard(true, true, false, true) == RENDER_PASS_DISCARD_DEPTH);
+    CHECK(GetClearDiscard(false, true, true, false) == RENDER_PASS_DISCARD_NONE);
+    CHECK(GetClearDiscard(true, false, false, true) == RENDER_PASS_DISCARD_NONE);
+}
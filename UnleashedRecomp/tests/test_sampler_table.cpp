@@ -0,0 +1,60 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "gpu/sampler_table.h"
+
+#include <memory>
+
+TEST_CASE("Sampler keys only use the sampler bits")
+{
+    uint32_t key = PackSamplerKey(0x1FF << 10, 0x3F << 19, 0x3, 16);
+    CHECK(key == PackSamplerKey(0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF & ~0x1Cu, 16));
+
+    CHECK(PackSamplerKey(0, 0, 0, 0) != PackSamplerKey(1 << 10, 0, 0, 0));
+    CHECK(PackSamplerKey(0, 0, 0, 0) != PackSamplerKey(0, 1 << 19, 0, 0));
+    CHECK(PackSamplerKey(0, 0, 0, 0) != PackSamplerKey(0, 0, 1, 0));
+    CHECK(PackSamplerKey(0, 0, 0, 8) != PackSamplerKey(0, 0, 0, 16));
+}
+
+TEST_CASE("Interning assigns IDs once")
+{
+    auto table = std::make_unique<SamplerTable<1024>>();
+
+    auto [firstId, firstCreated] = table->Intern(0x1234);
+    CHECK(firstId == 1);
+    CHECK(firstCreated);
+
+    auto [secondId, secondCreated] = table->Intern(0x5678);
+    CHECK(secondId == 2);
+    CHECK(secondCreated);
+
+    auto [againId, againCreated] = table->Intern(0x1234);
+    CHECK(againId == 1);
+    CHECK(!againCreated);
+
+    CHECK(table->count == 3);
+    CHECK(table->lookupCount == 3);
+    CHECK(table->missCount == 2);
+    CHECK(table->useCounts[1] == 2);
+    CHECK(table->useCounts[2] == 1);
+}
+
+TEST_CASE("Full table")
+{
+    auto table = std::make_unique<SamplerTable<16>>();
+
+    // ID 0 is taken by the default sampler.
+    for (uint32_t i = 0; i < 15; i++)
+    {
+        auto [id, created] = table->Intern(i * 0x10000);
+        CHECK(id == i + 1);
+        CHECK(created);
+    }
+
+    auto [id, created] = table->Intern(0xABCD);
+    CHECK(id == table->INVALID_ID);
+    CHECK(!created);
+
+    // Existing keys still resolve.
+    for (uint32_t i = 0; i < 15; i++)
+        CHECK(table->Intern(i * 0x10000).first == i + 1);
+}
@@ -0,0 +1,46 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "gpu/shader_cache_table.h"
+
+struct Slot
+{
+    uint64_t hash;
+    uint32_t entryIndex;
+};
+
+TEST_CASE("Table is at most half full")
+{
+    uint64_t hashes[] = { 0x10, 0x20, 0x30 };
+    auto table = BuildShaderCacheTable<Slot>(hashes, std::size(hashes));
+    CHECK(table.size() == 8);
+
+    auto empty = BuildShaderCacheTable<Slot>(nullptr, 0);
+    REQUIRE(empty.size() == 1);
+    CHECK(FindShaderCacheTableIndex(empty.data(), 0, 0x1234) == UINT32_MAX);
+}
+
+TEST_CASE("Every hash finds its entry")
+{
+    std::vector<uint64_t> hashes;
+    for (uint64_t i = 0; i < 1000; i++)
+        hashes.push_back((i + 1) * 0x9E3779B97F4A7C15ull);
+
+    auto table = BuildShaderCacheTable<Slot>(hashes.data(), hashes.size());
+
+    for (size_t i = 0; i < hashes.size(); i++)
+        CHECK(FindShaderCacheTableIndex(table.data(), table.size() - 1, hashes[i]) == i);
+
+    CHECK(FindShaderCacheTableIndex(table.data(), table.size() - 1, 0x1234) == UINT32_MAX);
+}
+
+TEST_CASE("Colliding hashes probe forward")
+{
+    // All land in the same slot, including the missing one.
+    uint64_t hashes[] = { 0x100, 0x200, 0x300 };
+    auto table = BuildShaderCacheTable<Slot>(hashes, std::size(hashes));
+
+    CHECK(FindShaderCacheTableIndex(table.data(), table.size() - 1, 0x100) == 0);
+    CHECK(FindShaderCacheTableIndex(table.data(), table.size() - 1, 0x200) == 1);
+    CHECK(FindShaderCacheTableIndex(table.data(), table.size() - 1, 0x300) == 2);
+    CHECK(FindShaderCacheTableIndex(table.data(), table.size() - 1, 0x400) == UINT32_MAX);
+}
@@ -0,0 +1,154 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include "gpu/shader_module_cache.h"
+
+static std::filesystem::path GetTestCachePath()
+{
+    return std::filesystem::temp_directory_path() / "test_shader_module_cache.bin";
+}
+
+TEST_CASE("ShaderModuleCache round trip")
+{
+    auto path = GetTestCachePath();
+    std::filesystem::remove(path);
+
+    std::vector<uint8_t> moduleA = { 0x03, 0x02, 0x23, 0x07, 0xAA, 0xBB };
+    std::vector<uint8_t> moduleB = { 0x01, 0x02, 0x03 };
+
+    {
+        ShaderModuleCache cache;
+        REQUIRE(cache.Open(path, 0x1234));
+
+        std::vector<uint8_t> data;
+        CHECK_FALSE(cache.Load(0xDEADBEEF, 0, data));
+
+        cache.Store(0xDEADBEEF, 0, moduleA.data(), moduleA.size());
+        cache.Store(0xDEADBEEF, 4, moduleB.data(), moduleB.size());
+
+        REQUIRE(cache.Load(0xDEADBEEF, 0, data));
+        CHECK(data == moduleA);
+    }
+
+    SUBCASE("Entries persist across runs")
+    {
+        ShaderModuleCache cache;
+        REQUIRE(cache.Open(path, 0x1234));
+        CHECK(cache.entries.size() == 2);
+
+        std::vector<uint8_t> data;
+        REQUIRE(cache.Load(0xDEADBEEF, 4, data));
+        CHECK(data == moduleB);
+        REQUIRE(cache.Load(0xDEADBEEF, 0, data));
+        CHECK(data == moduleA);
+        CHECK_FALSE(cache.Load(0xDEADBEEF, 8, data));
+    }
+
+    SUBCASE("Build hash change discards everything")
+    {
+        ShaderModuleCache cache;
+        REQUIRE(cache.Open(path, 0x5678));
+        CHECK(cache.entries.empty());
+
+        std::vector<uint8_t> data;
+        CHECK_FALSE(cache.Load(0xDEADBEEF, 0, data));
+    }
+
+    SUBCASE("Truncated record is ignored and overwritten")
+    {
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+
+        ShaderModuleCache cache;
+        REQUIRE(cache.Open(path, 0x1234));
+        CHECK(cache.entries.size() == 1);
+
+        cache.Store(0xCAFE, 0, moduleB.data(), moduleB.size());
+
+        ShaderModuleCache reopened;
+        REQUIRE(reopened.Open(path, 0x1234));
+        CHECK(reopened.entries.size() == 2);
+
+        std::vector<uint8_t> data;
+        REQUIRE(reopened.Load(0xCAFE, 0, data));
+        CHECK(data == moduleB);
+    }
+
+    SUBCASE("Corrupted record is dropped with everything after it")
+    {
+        {
+            ShaderModuleCache cache;
+            REQUIRE(cache.Open(path, 0x1234));
+            cache.Store(0xCAFE, 0, moduleB.data(), moduleB.size());
+        }
+
+        // Flip the last byte of the second record, as if it never made it to the disk before the third one did.
+        uint64_t offset = sizeof(ShaderModuleCache::Header) + sizeof(ShaderModuleCache::RecordHeader) * 2 + moduleA.size() + moduleB.size() - 1;
+        {
+            std::fstream stream(path, std::ios::in | std::ios::out | std::ios::binary);
+            stream.seekp(offset);
+            stream.put(char(0xFF));
+        }
+
+        ShaderModuleCache cache;
+        REQUIRE(cache.Open(path, 0x1234));
+        CHECK(cache.entries.size() == 1);
+        CHECK(std::filesystem::file_size(path) == offset + 1 - moduleB.size() - sizeof(ShaderModuleCache::RecordHeader));
+
+        std::vector<uint8_t> data;
+        REQUIRE(cache.Load(0xDEADBEEF, 0, data));
+        CHECK(data == moduleA);
+        CHECK_FALSE(cache.Load(0xDEADBEEF, 4, data));
+        CHECK_FALSE(cache.Load(0xCAFE, 0, data));
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("ShaderModuleCache concurrent stores and loads")
+{
+    auto path = GetTestCachePath();
+    std::filesystem::remove(path);
+
+    constexpr uint32_t THREAD_COUNT = 4;
+    constexpr uint32_t MODULE_COUNT = 64;
+
+    {
+        ShaderModuleCache cache;
+        REQUIRE(cache.Open(path, 0x1234));
+
+        std::vector<std::thread> threads;
+        for (uint32_t i = 0; i < THREAD_COUNT; i++)
+        {
+            threads.emplace_back([&cache, i]
+            {
+                for (uint32_t j = 0; j < MODULE_COUNT; j++)
+                {
+                    std::vector<uint8_t> module(j + 1, uint8_t(i * MODULE_COUNT + j));
+                    cache.Store(i, j, module.data(), module.size());
+
+                    std::vector<uint8_t> data;
+                    if (cache.Load(i, j, data))
+                        CHECK(data == module);
+                }
+            });
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        CHECK(cache.entries.size() == THREAD_COUNT * MODULE_COUNT);
+    }
+
+    ShaderModuleCache cache;
+    REQUIRE(cache.Open(path, 0x1234));
+    CHECK(cache.entries.size() == THREAD_COUNT * MODULE_COUNT);
+
+    std::vector<uint8_t> data;
+    REQUIRE(cache.Load(3, 63, data));
+    CHECK(data == std::vector<uint8_t>(64, uint8_t(3 * MODULE_COUNT + 63)));
+
+    std::filesystem::remove(path);
+}
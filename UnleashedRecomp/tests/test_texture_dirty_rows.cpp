@@ -0,0 +1,172 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "gpu/texture_dirty_rows.h"
+#include "gpu/null_render_interface.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace plume;
+
+static constexpr uint32_t WIDTH = 64;
+static constexpr uint32_t HEIGHT = 64;
+static constexpr uint32_t ROW_SIZE = WIDTH * 4;
+static constexpr uint32_t PITCH = 512;
+
+TEST_CASE("First update uploads everything")
+{
+    std::vector<uint8_t> data(PITCH * HEIGHT, 0x11);
+    TextureDirtyRows dirtyRows;
+
+    auto& spans = dirtyRows.Update(data.data(), PITCH, ROW_SIZE, HEIGHT);
+    REQUIRE(spans.size() == 1);
+    CHECK(spans[0].firstRow == 0);
+    CHECK(spans[0].rowCount == HEIGHT);
+}
+
+TEST_CASE("Unchanged data uploads nothing")
+{
+    std::vector<uint8_t> data(PITCH * HEIGHT, 0x11);
+    TextureDirtyRows dirtyRows;
+    dirtyRows.Update(data.data(), PITCH, ROW_SIZE, HEIGHT);
+
+    CHECK(dirtyRows.Update(data.data(), PITCH, ROW_SIZE, HEIGHT).empty());
+
+    // Changes in the pitch padding don't count.
+    data[ROW_SIZE + 4] = 0x22;
+    CHECK(dirtyRows.Update(data.data(), PITCH, ROW_SIZE, HEIGHT).empty());
+}
+
+TEST_CASE("Changed rows are found and merged")
+{
+    std::vector<uint8_t> data(PITCH * HEIGHT, 0x11);
+    TextureDirtyRows dirtyRows;
+    dirtyRows.Update(data.data(), PITCH, ROW_SIZE, HEIGHT);
+
+    data[PITCH * 3] = 0x22;
+    data[PITCH * 5 + ROW_SIZE - 1] = 0x22;
+    data[PITCH * 40] = 0x22;
+
+    auto& spans = dirtyRows.Update(data.data(), PITCH, ROW_SIZE, HEIGHT);
+    REQUIRE(spans.size() == 2);
+    CHECK(spans[0].firstRow == 3);
+    CHECK(spans[0].rowCount == 3);
+    CHECK(spans[1].firstRow == 40);
+    CHECK(spans[1].rowCount == 1);
+
+    // The copy was updated, so the same data is clean again.
+    CHECK(dirtyRows.Update(data.data(), PITCH, ROW_SIZE, HEIGHT).empty());
+}
+
+TEST_CASE("Mostly dirty updates upload the whole slice")
+{
+    std::vector<uint8_t> data(PITCH * HEIGHT, 0x11);
+    TextureDirtyRows dirtyRows;
+    dirtyRows.Update(data.data(), PITCH, ROW_SIZE, HEIGHT);
+
+    for (uint32_t i = 0; i < HEIGHT; i += 2)
+        data[PITCH * i] = 0x22;
+
+    auto& spans = dirtyRows.Update(data.data(), PITCH, ROW_SIZE, HEIGHT);
+    REQUIRE(spans.size() == 1);
+    CHECK(spans[0].firstRow == 0);
+    CHECK(spans[0].rowCount == HEIGHT);
+
+    // The whole copy was updated, rows past the point where comparing stopped included.
+    CHECK(dirtyRows.Update(data.data(), PITCH, ROW_SIZE, HEIGHT).empty());
+    CHECK(dirtyRows.shadowed);
+}
+
+TEST_CASE("Repeatedly rewritten textures drop the copy")
+{
+    std::vector<uint8_t> data(PITCH * HEIGHT, 0x11);
+    TextureDirtyRows dirtyRows;
+    dirtyRows.Update(data.data(), PITCH, ROW_SIZE, HEIGHT);
+
+    for (uint32_t i = 0; i < TextureDirtyRows::FULL_UPDATES_BEFORE_UNSHADOW; i++)
+    {
+        CHECK(dirtyRows.shadowed);
+        std::fill(data.begin(), data.end(), uint8_t(0x20 + i));
+        CHECK(dirtyRows.Update(data.data(), PITCH, ROW_SIZE, HEIGHT).size() == 1);
+    }
+
+    CHECK_FALSE(dirtyRows.shadowed);
+    CHECK(dirtyRows.uploadedData.capacity() == 0);
+
+    // Unchanged data gets uploaded in full too, nothing is left to compare against.
+    auto& spans = dirtyRows.Update(data.data(), PITCH, ROW_SIZE, HEIGHT);
+    REQUIRE(spans.size() == 1);
+    CHECK(spans[0].rowCount == HEIGHT);
+}
+
+TEST_CASE("A partial update resets the full update streak")
+{
+    std::vector<uint8_t> data(PITCH * HEIGHT, 0x11);
+    TextureDirtyRows dirtyRows;
+    dirtyRows.Update(data.data(), PITCH, ROW_SIZE, HEIGHT);
+
+    for (uint32_t i = 0; i < TextureDirtyRows::FULL_UPDATES_BEFORE_UNSHADOW * 2; i++)
+    {
+        std::fill(data.begin(), data.end(), uint8_t(0x20 + i));
+        dirtyRows.Update(data.data(), PITCH, ROW_SIZE, HEIGHT);
+
+        data[0] = uint8_t(0x80 + i);
+        dirtyRows.Update(data.data(), PITCH, ROW_SIZE, HEIGHT);
+    }
+
+    CHECK(dirtyRows.shadowed);
+}
+
+TEST_CASE("Spans are placed at the alignment")
+{
+    std::vector<uint8_t> data(PITCH * HEIGHT, 0x11);
+    TextureDirtyRows dirtyRows;
+    dirtyRows.Update(data.data(), PITCH, ROW_SIZE, HEIGHT);
+
+    data[PITCH * 10] = 0x22;
+    data[PITCH * 30] = 0x22;
+    dirtyRows.Update(data.data(), PITCH, ROW_SIZE, HEIGHT);
+
+    CHECK(dirtyRows.PlaceSpans(PITCH, 0x400) == 0x400 + PITCH);
+    CHECK(dirtyRows.spans[0].uploadOffset == 0);
+    CHECK(dirtyRows.spans[1].uploadOffset == 0x400);
+}
+
+TEST_CASE("Partial updates record one copy per span")
+{
+    auto renderInterface = CreateNullInterface();
+    auto device = renderInterface->createDevice("");
+    auto queue = device->createCommandQueue(RenderCommandListType::DIRECT);
+    auto commandList = queue->createCommandList();
+    auto texture = device->createTexture(RenderTextureDesc::Texture2D(WIDTH, HEIGHT, 1, RenderFormat::R8G8B8A8_UNORM));
+    auto uploadBuffer = device->createBuffer(RenderBufferDesc::UploadBuffer(PITCH * HEIGHT));
+
+    std::vector<uint8_t> data(PITCH * HEIGHT, 0x11);
+    TextureDirtyRows dirtyRows;
+
+    auto record = [&]
+        {
+            commandList->begin();
+            dirtyRows.Update(data.data(), PITCH, ROW_SIZE, HEIGHT);
+            uint64_t size = dirtyRows.PlaceSpans(PITCH, 0x200);
+            CopyTextureDirtyRows(commandList.get(), texture.get(), RenderFormat::R8G8B8A8_UNORM, WIDTH, PITCH, dirtyRows.spans, uploadBuffer.get(), 0);
+            commandList->end();
+
+            return std::make_pair(static_cast<NullCommandList*>(commandList.get())->stats.copyCount, size);
+        };
+
+    auto [fullCopies, fullSize] = record();
+    CHECK(fullCopies == 1);
+    CHECK(fullSize == PITCH * HEIGHT);
+
+    auto [cleanCopies, cleanSize] = record();
+    CHECK(cleanCopies == 0);
+    CHECK(cleanSize == 0);
+
+    data[PITCH * 2] = 0x22;
+    data[PITCH * 50] = 0x22;
+
+    auto [partialCopies, partialSize] = record();
+    CHECK(partialCopies == 2);
+    CHECK(partialSize == 0x200 + PITCH);
+}
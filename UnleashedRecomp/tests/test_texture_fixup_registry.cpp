@@ -0,0 +1,132 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "gpu/texture_fixup_registry.h"
+
+#include <vector>
+
+static std::vector<uint8_t> CreateData(size_t size, uint8_t seed)
+{
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++)
+        data[i] = uint8_t(i * 31 + seed);
+
+    return data;
+}
+
+TEST_CASE("Identity hashes once")
+{
+    auto data = CreateData(256, 1);
+    TextureIdentity identity(data.data(), data.size());
+
+    CHECK(!identity.hash.has_value());
+    CHECK(identity.GetHash() == XXH3_64bits(data.data(), data.size()));
+    CHECK(identity.hash.has_value());
+
+    // Changing the data doesn't change a hash that was already computed.
+    data[0] ^= 0xFF;
+    CHECK(identity.GetHash() != XXH3_64bits(data.data(), data.size()));
+}
+
+TEST_CASE("Exact size fixups")
+{
+    auto match = CreateData(0x100, 1);
+    auto sameSize = CreateData(0x100, 2);
+    auto otherSize = CreateData(0x108, 1);
+
+    TextureFixupRegistry<int> registry;
+    registry.Add(0x100, XXH3_64bits(match.data(), match.size()), 1);
+
+    TextureIdentity matchIdentity(match.data(), match.size());
+    auto fixup = registry.Find(matchIdentity);
+    REQUIRE(fixup != nullptr);
+    CHECK(*fixup == 1);
+
+    TextureIdentity sameSizeIdentity(sameSize.data(), sameSize.size());
+    CHECK(registry.Find(sameSizeIdentity) == nullptr);
+    CHECK(sameSizeIdentity.hash.has_value());
+
+    // Textures of other sizes never get hashed.
+    TextureIdentity otherSizeIdentity(otherSize.data(), otherSize.size());
+    CHECK(registry.Find(otherSizeIdentity) == nullptr);
+    CHECK(!otherSizeIdentity.hash.has_value());
+
+    CHECK(registry.hashCount == 2);
+    CHECK(registry.skipCount == 1);
+}
+
+TEST_CASE("Minimum size fixups")
+{
+    auto match = CreateData(0x400, 3);
+    auto tooSmall = CreateData(0x80, 3);
+    auto unaligned = CreateData(0x401, 3);
+
+    TextureFixupRegistry<int> registry;
+    registry.AddMinimumSize(0x200, 8, XXH3_64bits(match.data(), match.size()), 2);
+    registry.AddMinimumSize(0x100, 8, 0x1234, 3);
+
+    CHECK(registry.IsCandidate(0x100, true));
+    CHECK(!registry.IsCandidate(0x100, false));
+    CHECK(!registry.IsCandidate(0x80, true));
+    CHECK(!registry.IsCandidate(0x401, true));
+
+    TextureIdentity matchIdentity(match.data(), match.size());
+    matchIdentity.blockCompressed = true;
+    auto fixup = registry.Find(matchIdentity);
+    REQUIRE(fixup != nullptr);
+    CHECK(*fixup == 2);
+
+    TextureIdentity tooSmallIdentity(tooSmall.data(), tooSmall.size());
+    tooSmallIdentity.blockCompressed = true;
+    CHECK(registry.Find(tooSmallIdentity) == nullptr);
+    CHECK(!tooSmallIdentity.hash.has_value());
+
+    TextureIdentity unalignedIdentity(unaligned.data(), unaligned.size());
+    unalignedIdentity.blockCompressed = true;
+    CHECK(registry.Find(unalignedIdentity) == nullptr);
+    CHECK(!unalignedIdentity.hash.has_value());
+
+    // Uncompressed textures never match, even with the right data.
+    TextureIdentity uncompressedIdentity(match.data(), match.size());
+    CHECK(registry.Find(uncompressedIdentity) == nullptr);
+    CHECK(!uncompressedIdentity.hash.has_value());
+}
+
+TEST_CASE("Skips only count hashes that were avoided")
+{
+    auto data = CreateData(0x100, 6);
+
+    TextureFixupRegistry<int> registry;
+    registry.Add(0x200, 0x1234, 1);
+
+    TextureIdentity identity(data.data(), data.size());
+    CHECK(registry.Find(identity) == nullptr);
+    CHECK(registry.skipCount == 1);
+
+    identity.GetHash();
+    CHECK(registry.Find(identity) == nullptr);
+    CHECK(registry.skipCount == 1);
+    CHECK(registry.hashCount == 0);
+}
+
+TEST_CASE("Exact and minimum size fixups together")
+{
+    auto exact = CreateData(0x10, 4);
+    auto minimum = CreateData(0x1000, 5);
+
+    TextureFixupRegistry<int> registry;
+    registry.AddMinimumSize(0x800, 8, XXH3_64bits(minimum.data(), minimum.size()), 5);
+    registry.Add(0x10, XXH3_64bits(exact.data(), exact.size()), 4);
+    registry.Add(0x10, 0x5678, 6);
+
+    TextureIdentity exactIdentity(exact.data(), exact.size());
+    TextureIdentity minimumIdentity(minimum.data(), minimum.size());
+    minimumIdentity.blockCompressed = true;
+
+    REQUIRE(registry.Find(exactIdentity) != nullptr);
+    CHECK(*registry.Find(exactIdentity) == 4);
+    REQUIRE(registry.Find(minimumIdentity) != nullptr);
+    CHECK(*registry.Find(minimumIdentity) == 5);
+
+    // Hashes are shared, looking up again doesn't hash again.
+    CHECK(registry.hashCount == 2);
+}
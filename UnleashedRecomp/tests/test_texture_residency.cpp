@@ -0,0 +1,105 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "gpu/texture_residency.h"
+
+struct TestTexture
+{
+    uint32_t lastUsedFrame = 0;
+    uint32_t mipLevels = 1;
+};
+
+TEST_CASE("Texture memory size")
+{
+    // 4x4 RGBA8 with a full mip chain: 64 + 16 + 4 bytes.
+    CHECK(ComputeTextureMemorySize(4, 4, 1, 3, 1, 32) == 84);
+
+    // BC1 is 64 bits per 4x4 block, mips smaller than a block still take a whole one.
+    CHECK(ComputeTextureMemorySize(8, 8, 1, 4, 1, 64, 4, 4) == 32 + 8 + 8 + 8);
+
+    // Cube maps count every face.
+    CHECK(ComputeTextureMemorySize(4, 4, 1, 1, 6, 32) == 64 * 6);
+}
+
+TEST_CASE("ResidencyTracker usage and budget")
+{
+    ResidencyTracker<TestTexture> tracker;
+    TestTexture textures[3];
+
+    tracker.budget = 1000;
+    tracker.Track(&textures[0], 400);
+    tracker.Track(&textures[1], 400);
+    CHECK(tracker.usage == 800);
+    CHECK(tracker.GetOverBudget() == 0);
+
+    tracker.Track(&textures[2], 500);
+    CHECK(tracker.usage == 1300);
+    CHECK(tracker.peakUsage == 1300);
+    CHECK(tracker.GetOverBudget() == 300);
+
+    tracker.Shrink(&textures[2], 125);
+    CHECK(tracker.usage == 925);
+    CHECK(tracker.reclaimedBytes == 375);
+    CHECK(tracker.downgradeCount == 1);
+
+    // Growing through Shrink is ignored.
+    tracker.Shrink(&textures[2], 2000);
+    CHECK(tracker.usage == 925);
+
+    // And shrinking through Restore.
+    tracker.Restore(&textures[2], 100);
+    CHECK(tracker.usage == 925);
+    CHECK(tracker.restoreCount == 0);
+
+    tracker.Restore(&textures[2], 500);
+    CHECK(tracker.usage == 1300);
+    CHECK(tracker.restoreCount == 1);
+
+    tracker.Shrink(&textures[2], 125);
+    CHECK(tracker.usage == 925);
+
+    tracker.Untrack(&textures[0]);
+    tracker.Untrack(&textures[0]);
+    CHECK(tracker.usage == 525);
+    CHECK(tracker.peakUsage == 1300);
+
+    SUBCASE("No budget means never over it")
+    {
+        tracker.budget = 0;
+        CHECK(tracker.GetOverBudget() == 0);
+    }
+}
+
+TEST_CASE("ResidencyTracker least recently used order")
+{
+    ResidencyTracker<TestTexture> tracker;
+    TestTexture textures[4];
+
+    textures[0].lastUsedFrame = 100;
+    textures[1].lastUsedFrame = 10;
+    textures[2].lastUsedFrame = 995;
+    textures[3].lastUsedFrame = 50;
+    textures[3].mipLevels = 4;
+    textures[1].mipLevels = 4;
+
+    for (auto& texture : textures)
+        tracker.Track(&texture, 100);
+
+    auto all = tracker.FindLeastRecentlyUsed(1000, 10, [](TestTexture*) { return true; });
+    REQUIRE(all.size() == 3);
+    CHECK(all[0] == &textures[1]);
+    CHECK(all[1] == &textures[3]);
+    CHECK(all[2] == &textures[0]);
+
+    auto filtered = tracker.FindLeastRecentlyUsed(1000, 10, [](TestTexture* texture) { return texture->mipLevels > 1; });
+    REQUIRE(filtered.size() == 2);
+    CHECK(filtered[0] == &textures[1]);
+
+    // Frame counters wrapping around still count as idle time.
+    textures[0].lastUsedFrame = UINT32_MAX - 5;
+    textures[1].lastUsedFrame = 10;
+    textures[2].lastUsedFrame = 5;
+    textures[3].lastUsedFrame = 5;
+    auto wrapped = tracker.FindLeastRecentlyUsed(10, 10, [](TestTexture*) { return true; });
+    REQUIRE(wrapped.size() == 1);
+    CHECK(wrapped[0] == &textures[0]);
+}
@@ -0,0 +1,220 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "gpu/texture_transcoder.h"
+
+#include <cmath>
+#include <random>
+
+// Reference decoders for the subset of ETC2 the encoder emits.
+static void DecodeETC1Block(const uint8_t* block, uint8_t* rgba)
+{
+    uint64_t bits = 0;
+    for (size_t i = 0; i < 8; i++)
+        bits = (bits << 8) | block[i];
+
+    bool differential = (bits >> 33) & 1;
+    bool flip = (bits >> 32) & 1;
+    uint32_t tables[2] = { uint32_t(bits >> 37) & 0x7, uint32_t(bits >> 34) & 0x7 };
+
+    int32_t bases[2][3];
+    for (size_t channel = 0; channel < 3; channel++)
+    {
+        uint32_t channelBits = uint32_t(bits >> (56 - channel * 8)) & 0xFF;
+        if (differential)
+        {
+            int32_t base = channelBits >> 3;
+            int32_t delta = int32_t(channelBits & 0x7) - ((channelBits & 0x4) ? 8 : 0);
+            int32_t second = base + delta;
+            REQUIRE(second >= 0);
+            REQUIRE(second <= 31);
+            bases[0][channel] = (base << 3) | (base >> 2);
+            bases[1][channel] = (second << 3) | (second >> 2);
+        }
+        else
+        {
+            bases[0][channel] = (channelBits >> 4) * 17;
+            bases[1][channel] = (channelBits & 0xF) * 17;
+        }
+    }
+
+    for (uint32_t y = 0; y < 4; y++)
+    {
+        for (uint32_t x = 0; x < 4; x++)
+        {
+            uint32_t subBlock = flip ? (y / 2) : (x / 2);
+            uint32_t bitIndex = x * 4 + y;
+            uint32_t index = (((bits >> (bitIndex + 16)) & 1) << 1) | ((bits >> bitIndex) & 1);
+            int32_t modifier = ETC1_MODIFIER_TABLES[tables[subBlock]][index & 1] * ((index & 2) ? -1 : 1);
+
+            for (size_t channel = 0; channel < 3; channel++)
+                rgba[(y * 4 + x) * 4 + channel] = uint8_t(std::clamp(bases[subBlock][channel] + modifier, 0, 255));
+
+            rgba[(y * 4 + x) * 4 + 3] = 0xFF;
+        }
+    }
+}
+
+static void DecodeEACBlock(const uint8_t* block, uint8_t* values, size_t stride)
+{
+    uint64_t bits = 0;
+    for (size_t i = 0; i < 8; i++)
+        bits = (bits << 8) | block[i];
+
+    int32_t base = int32_t(bits >> 56);
+    int32_t multiplier = int32_t(bits >> 52) & 0xF;
+    uint32_t table = uint32_t(bits >> 48) & 0xF;
+
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        uint32_t bitIndex = (i % 4) * 4 + (i / 4);
+        uint32_t index = uint32_t(bits >> (45 - bitIndex * 3)) & 0x7;
+        values[i * stride] = uint8_t(std::clamp(base + EAC_MODIFIER_TABLES[table][index] * multiplier, 0, 255));
+    }
+}
+
+static double GetRMSE(const uint8_t* lhs, const uint8_t* rhs, size_t channelCount, size_t stride = 4)
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < 16; i++)
+    {
+        for (size_t channel = 0; channel < channelCount; channel++)
+        {
+            double difference = double(lhs[i * stride + channel]) - double(rhs[i * stride + channel]);
+            sum += difference * difference;
+        }
+    }
+
+    return std::sqrt(sum / (16.0 * channelCount));
+}
+
+static void CreateBC1Block(uint16_t color0, uint16_t color1, uint32_t indices, uint8_t* block)
+{
+    block[0] = uint8_t(color0);
+    block[1] = uint8_t(color0 >> 8);
+    block[2] = uint8_t(color1);
+    block[3] = uint8_t(color1 >> 8);
+    for (size_t i = 0; i < 4; i++)
+        block[4 + i] = uint8_t(indices >> (i * 8));
+}
+
+TEST_CASE("BC1 decoding")
+{
+    uint8_t block[8];
+    uint8_t rgba[64];
+
+    // Four color mode, pure red to pure blue.
+    CreateBC1Block(0xF800, 0x001F, 0xE4E4E4E4, block);
+    DecodeBCBlock(TranscodeFormat::BC1, block, rgba);
+
+    CHECK(rgba[0] == 255);
+    CHECK(rgba[2] == 0);
+    CHECK(rgba[4 * 1 + 0] == 0);
+    CHECK(rgba[4 * 1 + 2] == 255);
+    CHECK(rgba[4 * 2 + 0] == 170);
+    CHECK(rgba[4 * 3 + 0] == 85);
+    CHECK(rgba[4 * 3 + 3] == 255);
+
+    // Three color mode with the transparent index.
+    CreateBC1Block(0x001F, 0xF800, 0xFFFFFFFF, block);
+    DecodeBCBlock(TranscodeFormat::BC1, block, rgba);
+    CHECK(rgba[3] == 0);
+    CHECK(GetTranscodeTarget(TranscodeFormat::BC1, block, 1) == TranscodeTarget::ETC2_RGBA8);
+
+    CreateBC1Block(0x001F, 0xF800, 0xAAAAAAAA, block);
+    CHECK(GetTranscodeTarget(TranscodeFormat::BC1, block, 1) == TranscodeTarget::ETC2_RGB8);
+}
+
+TEST_CASE("BC4 decoding")
+{
+    uint8_t block[8] = { 200, 100, 0, 0, 0, 0, 0, 0 };
+    uint8_t values[16];
+
+    // Index 1 in the first pixel, index 2 in the second.
+    block[2] = 0x01 | (0x02 << 3);
+    DecodeBC4Block(block, values, 1);
+
+    CHECK(values[0] == 100);
+    CHECK(values[1] == (6 * 200 + 100) / 7);
+    CHECK(values[2] == 200);
+}
+
+TEST_CASE("ETC2 encoding of solid colors is exact to the quantization")
+{
+    std::mt19937 rng(42);
+
+    for (size_t i = 0; i < 256; i++)
+    {
+        uint8_t rgba[64];
+        uint8_t color[4] = { uint8_t(rng()), uint8_t(rng()), uint8_t(rng()), 0xFF };
+        for (size_t j = 0; j < 16; j++)
+            memcpy(rgba + j * 4, color, 4);
+
+        uint8_t block[8];
+        uint8_t decoded[64];
+        EncodeETC2RGBBlock(rgba, block);
+        DecodeETC1Block(block, decoded);
+
+        CHECK(GetRMSE(rgba, decoded, 3) <= 4.0);
+    }
+}
+
+TEST_CASE("Transcoded BC blocks stay close to the original")
+{
+    std::mt19937 rng(1234);
+
+    for (size_t i = 0; i < 512; i++)
+    {
+        uint8_t source[16];
+        for (auto& value : source)
+            value = uint8_t(rng());
+
+        // Endpoints of a similar hue like most texture blocks have. ETC1 modes can only vary brightness
+        // within a sub-block, two unrelated hues would need the T and H modes.
+        uint32_t r = 4 + rng() % 28, g = 8 + rng() % 56, b = 4 + rng() % 28;
+        uint32_t darken = rng() % 4;
+        uint16_t color0 = uint16_t((r << 11) | (g << 5) | b);
+        uint16_t color1 = uint16_t(((r - darken - 1) << 11) | ((g - darken * 2 - 1) << 5) | (b - darken - 1));
+        CreateBC1Block(color0, color1, uint32_t(rng()), source + 8);
+
+        uint8_t original[64];
+        DecodeBCBlock(TranscodeFormat::BC3, source, original);
+
+        uint8_t transcoded[16];
+        TranscodeBlock(TranscodeFormat::BC3, TranscodeTarget::ETC2_RGBA8, source, transcoded);
+
+        uint8_t decoded[64];
+        DecodeETC1Block(transcoded + 8, decoded);
+        DecodeEACBlock(transcoded, decoded + 3, 4);
+
+        // Random alpha is the worst case for EAC, real textures do a lot better.
+        CHECK(GetRMSE(original, decoded, 3) < 8.0);
+        CHECK(GetRMSE(original + 3, decoded + 3, 1) < 24.0);
+    }
+}
+
+TEST_CASE("EAC encoding of gradients")
+{
+    uint8_t values[16];
+    for (size_t i = 0; i < 16; i++)
+        values[i] = uint8_t(64 + i * 8);
+
+    uint8_t block[8];
+    uint8_t decoded[16];
+    EncodeEACBlock(values, 1, block);
+    DecodeEACBlock(block, decoded, 1);
+
+    CHECK(GetRMSE(values, decoded, 1, 1) < 6.0);
+}
+
+TEST_CASE("Image decoding clips partial blocks")
+{
+    uint8_t block[8];
+    CreateBC1Block(0xFFFF, 0x0000, 0x00000000, block);
+
+    uint8_t image[2 * 3 * 4];
+    memset(image, 0, sizeof(image));
+    DecodeBCImage(TranscodeFormat::BC1, block, 2, 3, 1, image);
+
+    for (auto value : image)
+        CHECK(value == 255);
+}
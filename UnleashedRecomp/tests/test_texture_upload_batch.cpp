@@ -0,0 +1,55 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "gpu/texture_upload_batch.h"
+
+TEST_CASE("Decode thread count")
+{
+    CHECK(GetTextureDecodeThreadCount(0, 0) == 2);
+    CHECK(GetTextureDecodeThreadCount(0, 4) == 2);
+    CHECK(GetTextureDecodeThreadCount(0, 12) == 6);
+    CHECK(GetTextureDecodeThreadCount(0, 64) == 8);
+
+    // Configured counts win over the hardware.
+    CHECK(GetTextureDecodeThreadCount(1, 64) == 1);
+    CHECK(GetTextureDecodeThreadCount(12, 4) == 12);
+    CHECK(GetTextureDecodeThreadCount(1000, 4) == 64);
+}
+
+TEST_CASE("Images are laid out with aligned pitches and offsets")
+{
+    TextureUploadBatchLayout layout(0x100, 0x200);
+
+    REQUIRE(layout.Add(64, 64, UINT64_MAX));
+    REQUIRE(layout.Add(10, 3, UINT64_MAX));
+    REQUIRE(layout.Add(100, 1, UINT64_MAX));
+
+    CHECK(layout.images[0].rowPitch == 0x100);
+    CHECK(layout.images[0].offset == 0);
+
+    CHECK(layout.images[1].rowPitch == 0x100);
+    CHECK(layout.images[1].offset == 0x4000);
+
+    CHECK(layout.images[2].rowPitch == 0x200);
+    CHECK(layout.images[2].offset == 0x4400);
+
+    CHECK(layout.size == 0x4600);
+}
+
+TEST_CASE("Batches stop at the size limit")
+{
+    TextureUploadBatchLayout layout(0x100, 0x200);
+
+    // The first image always fits, even when it's over the limit by itself.
+    CHECK(layout.Add(1024, 1024, 0x1000));
+    CHECK(!layout.Add(1, 1, 0x1000));
+    CHECK(layout.images.size() == 1);
+
+    layout.Clear();
+    CHECK(layout.size == 0);
+
+    CHECK(layout.Add(64, 8, 0x1000));
+    CHECK(layout.Add(64, 8, 0x1000));
+    CHECK(!layout.Add(64, 16, 0x1000));
+    CHECK(layout.images.size() == 2);
+    CHECK(layout.size == 0x1000);
+}
@@ -0,0 +1,105 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include "gpu/trace_profiler.h"
+
+static std::string ReadFile(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream stream;
+    stream << file.rdbuf();
+    return stream.str();
+}
+
+TEST_CASE("TraceRecorder exports nested scopes as Chrome trace")
+{
+    auto path = std::filesystem::temp_directory_path() / "test_trace_profiler.json";
+
+    g_traceRecorder.SetThreadName("Test \"Main\" Thread");
+    g_traceRecorder.SetEnabled(true);
+
+    {
+        TRACE_SCOPE("Outer");
+        {
+            TRACE_SCOPE("Inner", "test");
+        }
+    }
+
+    CHECK(TraceScope::Depth() == 0);
+
+    std::thread worker([]
+        {
+            g_traceRecorder.SetThreadName("Worker");
+            TRACE_SCOPE("WorkerScope");
+        });
+
+    worker.join();
+
+    g_traceRecorder.Record("GPU Frame", "gpu", 0, 1000, TraceRecorder::GPU_THREAD_ID, 0);
+
+    REQUIRE(g_traceRecorder.WriteChromeTrace(path));
+
+    std::string json = ReadFile(path);
+    CHECK(json.starts_with("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+    CHECK(json.ends_with("]}"));
+    CHECK(json.find("\"name\":\"Outer\"") != std::string::npos);
+    CHECK(json.find("\"name\":\"Inner\",\"cat\":\"test\"") != std::string::npos);
+    CHECK(json.find("\"name\":\"WorkerScope\"") != std::string::npos);
+    CHECK(json.find("\"name\":\"GPU Frame\",\"cat\":\"gpu\"") != std::string::npos);
+    CHECK(json.find("Test \\\"Main\\\" Thread") != std::string::npos);
+    CHECK(json.find("\"name\":\"Worker\"") != std::string::npos);
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Disabled TraceRecorder records no scopes")
+{
+    g_traceRecorder.SetEnabled(false);
+    uint64_t start = g_traceRecorder.writeIndex.load();
+
+    {
+        TRACE_SCOPE("Outer");
+
+        // Scopes opened after enabling still record, the outer one doesn't when it closes.
+        g_traceRecorder.SetEnabled(true);
+        {
+            TRACE_SCOPE("Inner");
+            CHECK(TraceScope::Depth() == 1);
+        }
+    }
+
+    CHECK(TraceScope::Depth() == 0);
+    CHECK(g_traceRecorder.writeIndex.load() - start == 1);
+
+    g_traceRecorder.SetEnabled(false);
+    {
+        TRACE_SCOPE("Disabled");
+    }
+
+    CHECK(g_traceRecorder.writeIndex.load() - start == 1);
+}
+
+TEST_CASE("TraceRecorder keeps only the most recent events")
+{
+    uint64_t start = g_traceRecorder.writeIndex.load();
+
+    for (size_t i = 0; i < TraceRecorder::CAPACITY + 16; i++)
+        g_traceRecorder.Record("Spam", "cpu", i, 1, 1, 0);
+
+    CHECK(g_traceRecorder.writeIndex.load() - start == TraceRecorder::CAPACITY + 16);
+
+    auto path = std::filesystem::temp_directory_path() / "test_trace_profiler_ring.json";
+    REQUIRE(g_traceRecorder.WriteChromeTrace(path));
+
+    std::string json = ReadFile(path);
+    size_t count = 0;
+    for (size_t pos = json.find("\"ph\":\"X\""); pos != std::string::npos; pos = json.find("\"ph\":\"X\"", pos + 1))
+        ++count;
+
+    CHECK(count == TraceRecorder::CAPACITY);
+
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,154 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "gpu/transient_resource_planner.h"
+
+TEST_CASE("Disjoint lifetimes share memory")
+{
+    std::vector<TransientResource> resources =
+    {
+        { 0x400, 1, 2 },
+        { 0x400, 3, 4 },
+        { 0x200, 5, 6 }
+    };
+
+    CHECK(PlaceTransientResources(resources, 0x100) == 0x400);
+    CHECK(resources[0].offset == 0);
+    CHECK(resources[1].offset == 0);
+    CHECK(resources[2].offset == 0);
+}
+
+TEST_CASE("Overlapping lifetimes get their own memory")
+{
+    std::vector<TransientResource> resources =
+    {
+        { 0x400, 1, 4 },
+        { 0x300, 2, 5 },
+        { 0x100, 6, 7 }
+    };
+
+    CHECK(PlaceTransientResources(resources, 0x100) == 0x700);
+    CHECK(resources[0].offset == 0);
+    CHECK(resources[1].offset == 0x400);
+    CHECK(resources[2].offset == 0);
+}
+
+TEST_CASE("Gaps get filled and offsets aligned")
+{
+    // The short lived resource in the middle leaves a gap between the long lived ones that the small ones fit in.
+    std::vector<TransientResource> resources =
+    {
+        { 0x800, 1, 10 },
+        { 0x800, 1, 3 },
+        { 0x800, 1, 10 },
+        { 0x100, 5, 6 },
+        { 0x80, 5, 5 }
+    };
+
+    CHECK(PlaceTransientResources(resources, 0x100) == 0x1800);
+    CHECK(resources[1].offset == 0x800);
+    CHECK(resources[3].offset == 0x800);
+    CHECK(resources[4].offset == 0x900);
+
+    for (size_t i = 0; i < resources.size(); i++)
+    {
+        CHECK((resources[i].offset % 0x100) == 0);
+
+        for (size_t j = i + 1; j < resources.size(); j++)
+        {
+            bool timeOverlap = resources[i].firstUse <= resources[j].lastUse && resources[j].firstUse <= resources[i].lastUse;
+            bool memoryOverlap = resources[i].offset < resources[j].offset + resources[j].size && resources[j].offset < resources[i].offset + resources[i].size;
+            CHECK(!(timeOverlap && memoryOverlap));
+        }
+    }
+}
+
+TEST_CASE("Resources cleared every frame are transient")
+{
+    TransientLifetimeTracker<int> tracker;
+
+    for (int frame = 0; frame < 3; frame++)
+    {
+        tracker.Use(1, 0x1000, true);
+        tracker.Use(1, 0x1000, false);
+        tracker.Use(2, 0x1000, true);
+        tracker.Use(2, 0x1000, false);
+
+        auto plan = tracker.EndFrame(0x100);
+        CHECK(plan.transientCount == 2);
+        CHECK(plan.persistentCount == 0);
+        CHECK(plan.dedicatedSize == 0x2000);
+        CHECK(plan.aliasedSize == 0x1000);
+    }
+}
+
+TEST_CASE("Resources read before being overwritten are persistent")
+{
+    TransientLifetimeTracker<int> tracker;
+
+    tracker.Use(1, 0x1000, true);
+    tracker.Use(2, 0x1000, true);
+    tracker.Use(3, 0x1000, false);
+    tracker.EndFrame(0x100);
+
+    // The first use of a new resource has nothing to carry over.
+    CHECK(!tracker.lifetimes[3].persistent);
+
+    tracker.Use(1, 0x1000, false);
+    tracker.Use(1, 0x1000, true);
+    tracker.Use(2, 0x1000, true);
+
+    auto plan = tracker.EndFrame(0x100);
+    CHECK(tracker.lifetimes[1].persistent);
+    CHECK(plan.persistentCount == 1);
+    CHECK(plan.transientCount == 1);
+
+    // Resource 3 wasn't used this frame and keeps its memory.
+    CHECK(plan.dedicatedSize == 0x3000);
+    CHECK(plan.aliasedSize == 0x3000);
+
+    // Once persistent, always persistent.
+    tracker.Use(1, 0x1000, true);
+    CHECK(tracker.EndFrame(0x100).persistentCount == 1);
+
+    tracker.Forget(1);
+    CHECK(tracker.EndFrame(0x100).dedicatedSize == 0x2000);
+}
+
+TEST_CASE("Placements are checked against the current frame")
+{
+    TransientLifetimeTracker<int> tracker;
+
+    tracker.Use(1, 0x1000, true);
+    tracker.Use(1, 0x1000, false);
+    tracker.Use(2, 0x1000, true);
+    tracker.Use(2, 0x1000, false);
+
+    auto plan = tracker.EndFrame(0x100);
+    REQUIRE(plan.transientCount == 2);
+    REQUIRE(tracker.keys.size() == 2);
+
+    std::vector<std::pair<int, TransientResource>> placement;
+    for (size_t i = 0; i < tracker.keys.size(); i++)
+        placement.emplace_back(tracker.keys[i], tracker.resources[i]);
+
+    CHECK(placement[0].second.offset == placement[1].second.offset);
+
+    // Same order of uses as the frame it was made for.
+    tracker.Use(1, 0x1000, true);
+    tracker.Use(1, 0x1000, false);
+    tracker.Use(2, 0x1000, true);
+    CHECK(tracker.IsPlacementValid(placement));
+
+    // Using the first one again while the second one is in use breaks it.
+    tracker.Use(1, 0x1000, false);
+    CHECK(!tracker.IsPlacementValid(placement));
+
+    // Resources that weren't used this frame don't conflict with anything.
+    tracker.EndFrame(0x100);
+    tracker.Use(2, 0x1000, true);
+    CHECK(tracker.IsPlacementValid(placement));
+
+    // Reading what a placed resource held in an earlier frame breaks the placement.
+    tracker.Use(1, 0x1000, false);
+    CHECK(!tracker.IsPlacementValid(placement));
+}
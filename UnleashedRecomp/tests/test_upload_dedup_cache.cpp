@@ -0,0 +1,44 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include <cstring>
+#include "gpu/upload_dedup_cache.h"
+
+TEST_CASE("UploadDedupCache reuses identical blocks")
+{
+    UploadDedupCache<uint32_t> cache;
+    uint32_t uploadCount = 0;
+    auto upload = [&] { return ++uploadCount; };
+
+    uint32_t constants[64] = {};
+    CHECK(cache.Get(constants, sizeof(constants), upload) == 1);
+    CHECK(cache.Get(constants, sizeof(constants), upload) == 1);
+
+    constants[3] = 0x3F800000;
+    CHECK(cache.Get(constants, sizeof(constants), upload) == 2);
+
+    // Going back to an earlier block within the same frame still finds it.
+    constants[3] = 0;
+    CHECK(cache.Get(constants, sizeof(constants), upload) == 1);
+
+    CHECK(uploadCount == 2);
+    CHECK(cache.hitCount == 2);
+    CHECK(cache.missCount == 2);
+    CHECK(cache.uploadedBytes == 2 * sizeof(constants));
+    CHECK(cache.savedBytes == 2 * sizeof(constants));
+
+    SUBCASE("Blocks only differing in size are kept apart")
+    {
+        CHECK(cache.Get(constants, sizeof(constants) / 2, upload) == 3);
+    }
+
+    SUBCASE("Reset forgets the uploads but keeps the stats")
+    {
+        cache.Reset();
+        CHECK(cache.Get(constants, sizeof(constants), upload) == 3);
+        CHECK(cache.missCount == 3);
+
+        cache.ResetStats();
+        CHECK(cache.hitCount == 0);
+        CHECK(cache.savedBytes == 0);
+    }
+}
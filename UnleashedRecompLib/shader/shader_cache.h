@@ -14,6 +14,17 @@ struct ShaderCacheEntry
 extern ShaderCacheEntry g_shaderCacheEntries[];
 extern const size_t g_shaderCacheEntryCount;
 
+// Open addressed table over g_shaderCacheEntries, keyed by the low bits of the hash.
+// Empty slots have an entry index of UINT32_MAX.
+struct ShaderCacheTableSlot
+{
+    const uint64_t hash;
+    const uint32_t entryIndex;
+};
+
+extern const ShaderCacheTableSlot g_shaderCacheTable[];
+extern const size_t g_shaderCacheTableMask;
+
 extern const uint8_t g_compressedDxilCache[];
 extern const size_t g_dxilCacheCompressedSize;
 extern const size_t g_dxilCacheDecompressedSize;
@@ -172,6 +172,10 @@ namespace plume {
         BC7_TYPELESS,
         BC7_UNORM,
         BC7_UNORM_SRGB,
+        ETC2_R8G8B8_UNORM,
+        ETC2_R8G8B8A8_UNORM,
+        EAC_R11_UNORM,
+        EAC_R11G11_UNORM,
         MAX
     };
 
@@ -598,6 +602,8 @@ namespace plume {
         case RenderFormat::BC4_UNORM:
         case RenderFormat::BC4_SNORM:
         case RenderFormat::BC4_TYPELESS:
+        case RenderFormat::ETC2_R8G8B8_UNORM:
+        case RenderFormat::EAC_R11_UNORM:
             return 8;
         case RenderFormat::BC2_UNORM:
         case RenderFormat::BC2_UNORM_SRGB:
@@ -623,6 +629,8 @@ namespace plume {
         case RenderFormat::ASTC_10x10_SRGB:
         case RenderFormat::ASTC_12x12_UNORM:
         case RenderFormat::ASTC_12x12_SRGB:
+        case RenderFormat::ETC2_R8G8B8A8_UNORM:
+        case RenderFormat::EAC_R11G11_UNORM:
             return 16;
         default:
             assert(false && "Unknown format.");
@@ -725,6 +733,10 @@ namespace plume {
         case RenderFormat::BC7_TYPELESS:
         case RenderFormat::BC7_UNORM:
         case RenderFormat::BC7_UNORM_SRGB:
+        case RenderFormat::ETC2_R8G8B8_UNORM:
+        case RenderFormat::ETC2_R8G8B8A8_UNORM:
+        case RenderFormat::EAC_R11_UNORM:
+        case RenderFormat::EAC_R11G11_UNORM:
             return 4;
         default:
             assert(false && "Unknown format.");
@@ -893,11 +905,16 @@ namespace plume {
         RenderTexture *texture = nullptr;
         RenderTextureLayout layout = RenderTextureLayout::UNKNOWN;
 
+        // Transitions from an undefined layout instead of the last one, for textures whose memory was written
+        // through another texture placed in the same heap. The contents are lost.
+        bool discard = false;
+
         RenderTextureBarrier() = default;
 
-        RenderTextureBarrier(RenderTexture *texture, RenderTextureLayout layout) {
+        RenderTextureBarrier(RenderTexture *texture, RenderTextureLayout layout, bool discard = false) {
             this->texture = texture;
             this->layout = layout;
+            this->discard = discard;
         }
     };
 
@@ -996,6 +1013,15 @@ namespace plume {
         RenderTextureFlags flags = RenderTextureFlag::NONE;
         bool committed = false;
 
+        // A texture with a heap size gets at least that much memory. Textures created with it as their heap texture
+        // get placed in that memory at the given offset instead of getting memory of their own, so textures that are
+        // never in use at the same time can share memory. A placed texture falls back to its own memory if it needs
+        // more than the given range or can't be bound to the heap's memory. The heap texture has to outlive it.
+        uint64_t heapSize = 0;
+        const RenderTexture *heapTexture = nullptr;
+        uint64_t heapOffset = 0;
+        uint64_t heapRangeSize = 0;
+
         RenderTextureDesc() = default;
 
         static RenderTextureDesc Texture(RenderTextureDimension dimension, uint32_t width, uint32_t height, uint32_t depth, uint32_t mipLevels, uint32_t arraySize, RenderFormat format, RenderTextureFlags flags = RenderTextureFlag::NONE) {
@@ -1335,6 +1361,10 @@ namespace plume {
         uint32_t inputElementsCount = 0;
         const RenderSpecConstant *specConstants = nullptr;
         uint32_t specConstantsCount = 0;
+
+        // Links the pipeline out of cached library parts when the device supports it. Much faster to create
+        // than a full compile but may run slower, so it's meant to be replaced by a full compile later.
+        bool fastLink = false;
     };
 
     struct RenderRaytracingPipelineLibrarySymbol {
@@ -1768,6 +1798,11 @@ namespace plume {
         const RenderTextureView *depthAttachmentView = nullptr;
         bool depthAttachmentReadOnly = false;
 
+        // The first render pass after binding the framebuffer overwrites these attachments entirely, so their previous
+        // contents don't need to be loaded. Passes that resume on the same binding load them as usual.
+        bool colorAttachmentsDiscarded = false;
+        bool depthAttachmentDiscarded = false;
+
         RenderFramebufferDesc() = default;
 
         RenderFramebufferDesc(const RenderTexture **colorAttachments, uint32_t colorAttachmentsCount, const RenderTexture *depthAttachment = nullptr, bool depthAttachmentReadOnly = false) {
@@ -1905,6 +1940,10 @@ namespace plume {
         RenderDeviceVendor vendor = RenderDeviceVendor::UNKNOWN;
         uint64_t driverVersion = 0;
         uint64_t dedicatedVideoMemory = 0;
+
+        // How much of the video memory the driver expects the application to use, which accounts for what other
+        // processes are using. Zero if the driver doesn't report it.
+        uint64_t videoMemoryBudget = 0;
     };
 
     struct RenderDeviceCapabilities {
@@ -1950,6 +1989,13 @@ namespace plume {
 
         // Query Pools.
         bool queryPools = false;
+
+        // Pipelines.
+        bool graphicsPipelineLibrary = false;
+
+        // Texture compression.
+        bool textureCompressionBC = false;
+        bool textureCompressionETC2 = false;
     };
 
     struct RenderInterfaceCapabilities {
@@ -80,18 +80,37 @@ namespace plume {
         VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME,
         VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME,
         VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME,
+        VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME,
         VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME,
         VK_EXT_SAMPLE_LOCATIONS_EXTENSION_NAME,
         VK_EXT_LOAD_STORE_OP_NONE_EXTENSION_NAME,
         VK_KHR_PRESENT_ID_EXTENSION_NAME,
         VK_KHR_PRESENT_WAIT_EXTENSION_NAME,
         VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME,
+        VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
         // Vulkan spec requires this to be enabled if supported by the driver.
         VK_KHR_PORTABILITY_SUBSET_EXTENSION_NAME,
     };
 
     // Common functions.
 
+    // FNV-1a, only used to key cached pipeline libraries.
+    struct PipelineLibraryHash {
+        uint64_t value = 14695981039346656037ULL;
+
+        void add(const void *data, size_t size) {
+            const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+            for (size_t i = 0; i < size; i++) {
+                value = (value ^ bytes[i]) * 1099511628211ULL;
+            }
+        }
+
+        template<typename T>
+        void add(const T &data) {
+            add(&data, sizeof(T));
+        }
+    };
+
     static uint32_t roundUp(uint32_t value, uint32_t powerOf2Alignment) {
         return (value + powerOf2Alignment - 1) & ~(powerOf2Alignment - 1);
     }
@@ -272,6 +291,14 @@ namespace plume {
             return VK_FORMAT_ASTC_12x12_UNORM_BLOCK;
         case RenderFormat::ASTC_12x12_SRGB:
             return VK_FORMAT_ASTC_12x12_SRGB_BLOCK;
+        case RenderFormat::ETC2_R8G8B8_UNORM:
+            return VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK;
+        case RenderFormat::ETC2_R8G8B8A8_UNORM:
+            return VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK;
+        case RenderFormat::EAC_R11_UNORM:
+            return VK_FORMAT_EAC_R11_UNORM_BLOCK;
+        case RenderFormat::EAC_R11G11_UNORM:
+            return VK_FORMAT_EAC_R11G11_UNORM_BLOCK;
         default:
             assert(false && "Unknown format.");
             return VK_FORMAT_UNDEFINED;
@@ -1016,6 +1043,64 @@ namespace plume {
             createInfo.flags |= VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
         }
 
+        const VulkanTexture *heapTexture = static_cast<const VulkanTexture *>(desc.heapTexture);
+        if ((heapTexture != nullptr) && (heapTexture->allocation != VK_NULL_HANDLE)) {
+            VkResult res = vkCreateImage(device->vk, &imageInfo, nullptr, &vk);
+            if (res != VK_SUCCESS) {
+                fprintf(stderr, "vkCreateImage failed with error code 0x%X.\n", res);
+                return;
+            }
+
+            VkMemoryRequirements memoryRequirements = {};
+            vkGetImageMemoryRequirements(device->vk, vk, &memoryRequirements);
+
+            const bool memoryTypeSupported = (memoryRequirements.memoryTypeBits & (1U << heapTexture->allocationInfo.memoryType)) != 0;
+            const bool offsetAligned = (desc.heapOffset % memoryRequirements.alignment) == 0;
+            const bool rangeFits = (memoryRequirements.size <= desc.heapRangeSize) && ((desc.heapOffset + memoryRequirements.size) <= heapTexture->allocationInfo.size);
+            if (memoryTypeSupported && offsetAligned && rangeFits) {
+                res = vmaBindImageMemory2(device->allocator, heapTexture->allocation, desc.heapOffset, vk, nullptr);
+                if (res == VK_SUCCESS) {
+                    placed = true;
+                    createImageView(imageInfo.format);
+                    return;
+                }
+
+                fprintf(stderr, "vmaBindImageMemory2 failed with error code 0x%X.\n", res);
+            }
+
+            // Give the texture its own memory instead.
+            vkDestroyImage(device->vk, vk, nullptr);
+            vk = VK_NULL_HANDLE;
+        }
+
+        if (desc.heapSize > 0) {
+            VkResult res = vkCreateImage(device->vk, &imageInfo, nullptr, &vk);
+            if (res != VK_SUCCESS) {
+                fprintf(stderr, "vkCreateImage failed with error code 0x%X.\n", res);
+                return;
+            }
+
+            VkMemoryRequirements memoryRequirements = {};
+            vkGetImageMemoryRequirements(device->vk, vk, &memoryRequirements);
+            memoryRequirements.size = std::max(memoryRequirements.size, VkDeviceSize(desc.heapSize));
+
+            res = vmaAllocateMemory(device->allocator, &memoryRequirements, &createInfo, &allocation, &allocationInfo);
+            if (res == VK_SUCCESS) {
+                res = vmaBindImageMemory(device->allocator, allocation, vk);
+            }
+
+            if (res != VK_SUCCESS) {
+                fprintf(stderr, "Allocating the texture heap failed with error code 0x%X.\n", res);
+                vmaDestroyImage(device->allocator, vk, allocation);
+                vk = VK_NULL_HANDLE;
+                allocation = VK_NULL_HANDLE;
+                return;
+            }
+
+            createImageView(imageInfo.format);
+            return;
+        }
+
         VkResult res = vmaCreateImage(device->allocator, &imageInfo, &createInfo, &vk, &allocation, &allocationInfo);
         if (res != VK_SUCCESS) {
             fprintf(stderr, "vmaCreateImage failed with error code 0x%X.\n", res);
@@ -1297,9 +1382,12 @@ namespace plume {
         assert(format != RenderShaderFormat::UNKNOWN);
         assert(format == RenderShaderFormat::SPIRV);
 
+        static std::atomic<uint64_t> nextId = 1;
+
         this->device = device;
         this->format = format;
         this->entryPointName = (entryPointName != nullptr) ? std::string(entryPointName) : std::string();
+        this->id = nextId++;
 
         VkShaderModuleCreateInfo shaderInfo = {};
         shaderInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
@@ -1636,12 +1724,147 @@ namespace plume {
             renderTargetFormats[i] = toVk(desc.renderTargetFormat[i]);
         }
 
+        const VulkanPipelineLayout *pipelineLayout = static_cast<const VulkanPipelineLayout *>(desc.pipelineLayout);
+
+        // Split the state into the four library parts, reuse the parts that were already compiled for other pipelines and
+        // link them without optimizations. Falls through to a full compile if anything fails along the way.
+        if (desc.fastLink && device->capabilities.graphicsPipelineLibrary && !desc.multisampling.sampleLocationsEnabled) {
+            const VkFormat depthTargetFormat = toVk(desc.depthTargetFormat);
+            const VkSampleCountFlagBits sampleCount = VkSampleCountFlagBits(desc.multisampling.sampleCount);
+            VkRenderPass libraryRenderPass = device->getPipelineLibraryRenderPass(renderTargetFormats.data(), desc.renderTargetCount, depthTargetFormat, sampleCount);
+
+            PipelineLibraryHash renderPassHash;
+            renderPassHash.add(renderTargetFormats.data(), renderTargetFormats.size() * sizeof(VkFormat));
+            renderPassHash.add(depthTargetFormat);
+            renderPassHash.add(sampleCount);
+
+            PipelineLibraryHash shaderHash;
+            shaderHash.add(pipelineLayout->vk);
+            shaderHash.add(specData.data(), specData.size() * sizeof(uint32_t));
+            for (const VkSpecializationMapEntry &entry : specEntries) {
+                shaderHash.add(entry.constantID);
+            }
+
+            VkGraphicsPipelineCreateInfo libraryInfo = {};
+            libraryInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+            libraryInfo.layout = pipelineLayout->vk;
+            libraryInfo.renderPass = libraryRenderPass;
+
+            // Vertex input interface.
+            VkGraphicsPipelineCreateInfo vertexInputInfo = libraryInfo;
+            vertexInputInfo.layout = VK_NULL_HANDLE;
+            vertexInputInfo.renderPass = VK_NULL_HANDLE;
+            vertexInputInfo.pVertexInputState = &vertexInput;
+            vertexInputInfo.pInputAssemblyState = &inputAssembly;
+
+            PipelineLibraryHash vertexInputHash;
+            vertexInputHash.add(VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT);
+            vertexInputHash.add(vertexBindings.data(), vertexBindings.size() * sizeof(VkVertexInputBindingDescription));
+            vertexInputHash.add(vertexAttributes.data(), vertexAttributes.size() * sizeof(VkVertexInputAttributeDescription));
+            vertexInputHash.add(inputAssembly.topology);
+            vertexInputHash.add(inputAssembly.primitiveRestartEnable);
+
+            // Pre-rasterization shaders.
+            thread_local std::vector<VkPipelineShaderStageCreateInfo> preRasterizationStages;
+            thread_local std::vector<VkPipelineShaderStageCreateInfo> fragmentStages;
+            preRasterizationStages.clear();
+            fragmentStages.clear();
+            for (const VkPipelineShaderStageCreateInfo &stage : stages) {
+                if (stage.stage == VK_SHADER_STAGE_FRAGMENT_BIT) {
+                    fragmentStages.emplace_back(stage);
+                }
+                else {
+                    preRasterizationStages.emplace_back(stage);
+                }
+            }
+
+            VkGraphicsPipelineCreateInfo preRasterizationInfo = libraryInfo;
+            preRasterizationInfo.pStages = preRasterizationStages.data();
+            preRasterizationInfo.stageCount = uint32_t(preRasterizationStages.size());
+            preRasterizationInfo.pViewportState = &viewportState;
+            preRasterizationInfo.pRasterizationState = &rasterization;
+            preRasterizationInfo.pDynamicState = &dynamicState;
+
+            PipelineLibraryHash preRasterizationHash = shaderHash;
+            preRasterizationHash.add(VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT);
+            preRasterizationHash.add(renderPassHash.value);
+            preRasterizationHash.add((desc.vertexShader != nullptr) ? static_cast<const VulkanShader *>(desc.vertexShader)->id : 0);
+            preRasterizationHash.add((desc.geometryShader != nullptr) ? static_cast<const VulkanShader *>(desc.geometryShader)->id : 0);
+            preRasterizationHash.add(viewportState.viewportCount);
+            preRasterizationHash.add(rasterization.depthClampEnable);
+            preRasterizationHash.add(rasterization.cullMode);
+            preRasterizationHash.add(rasterization.depthBiasEnable);
+            preRasterizationHash.add(rasterization.depthBiasConstantFactor);
+            preRasterizationHash.add(rasterization.depthBiasClamp);
+            preRasterizationHash.add(rasterization.depthBiasSlopeFactor);
+            preRasterizationHash.add(dynamicStates.data(), dynamicStates.size() * sizeof(VkDynamicState));
+
+            // Fragment shader.
+            VkGraphicsPipelineCreateInfo fragmentInfo = libraryInfo;
+            fragmentInfo.pStages = fragmentStages.data();
+            fragmentInfo.stageCount = uint32_t(fragmentStages.size());
+            fragmentInfo.pDepthStencilState = &depthStencil;
+            fragmentInfo.pMultisampleState = &multisampling;
+
+            PipelineLibraryHash fragmentHash = shaderHash;
+            fragmentHash.add(VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT);
+            fragmentHash.add(renderPassHash.value);
+            fragmentHash.add((desc.pixelShader != nullptr) ? static_cast<const VulkanShader *>(desc.pixelShader)->id : 0);
+            fragmentHash.add(depthStencil.depthTestEnable);
+            fragmentHash.add(depthStencil.depthWriteEnable);
+            fragmentHash.add(depthStencil.depthCompareOp);
+            fragmentHash.add(depthStencil.stencilTestEnable);
+            fragmentHash.add(depthStencil.front);
+            fragmentHash.add(depthStencil.back);
+            fragmentHash.add(multisampling.alphaToCoverageEnable);
+
+            // Fragment output interface.
+            VkGraphicsPipelineCreateInfo fragmentOutputInfo = libraryInfo;
+            fragmentOutputInfo.layout = VK_NULL_HANDLE;
+            fragmentOutputInfo.pColorBlendState = &colorBlend;
+            fragmentOutputInfo.pMultisampleState = &multisampling;
+
+            PipelineLibraryHash fragmentOutputHash;
+            fragmentOutputHash.add(VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT);
+            fragmentOutputHash.add(renderPassHash.value);
+            fragmentOutputHash.add(colorBlendAttachments.data(), colorBlendAttachments.size() * sizeof(VkPipelineColorBlendAttachmentState));
+            fragmentOutputHash.add(colorBlend.logicOpEnable);
+            fragmentOutputHash.add(colorBlend.logicOp);
+            fragmentOutputHash.add(multisampling.alphaToCoverageEnable);
+
+            VkPipeline libraries[] = {
+                device->getPipelineLibrary(vertexInputHash.value, vertexInputInfo, VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT),
+                device->getPipelineLibrary(preRasterizationHash.value, preRasterizationInfo, VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT),
+                device->getPipelineLibrary(fragmentHash.value, fragmentInfo, VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT),
+                device->getPipelineLibrary(fragmentOutputHash.value, fragmentOutputInfo, VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT)
+            };
+
+            if ((libraryRenderPass != VK_NULL_HANDLE) && std::find(std::begin(libraries), std::end(libraries), VK_NULL_HANDLE) == std::end(libraries)) {
+                VkPipelineLibraryCreateInfoKHR linkInfo = {};
+                linkInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+                linkInfo.pLibraries = libraries;
+                linkInfo.libraryCount = uint32_t(std::size(libraries));
+
+                VkGraphicsPipelineCreateInfo linkedInfo = {};
+                linkedInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+                linkedInfo.pNext = &linkInfo;
+                linkedInfo.layout = pipelineLayout->vk;
+
+                VkResult res = vkCreateGraphicsPipelines(device->vk, device->pipelineCache, 1, &linkedInfo, nullptr, &vk);
+                if (res == VK_SUCCESS) {
+                    return;
+                }
+
+                fprintf(stderr, "vkCreateGraphicsPipelines failed to link pipeline libraries with error code 0x%X.\n", res);
+                vk = VK_NULL_HANDLE;
+            }
+        }
+
         renderPass = createRenderPass(device, renderTargetFormats.data(), desc.renderTargetCount, toVk(desc.depthTargetFormat), VkSampleCountFlagBits(desc.multisampling.sampleCount));
         if (renderPass == VK_NULL_HANDLE) {
             return;
         }
 
-        const VulkanPipelineLayout *pipelineLayout = static_cast<const VulkanPipelineLayout *>(desc.pipelineLayout);
         VkGraphicsPipelineCreateInfo pipelineInfo = {};
         pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
         pipelineInfo.pStages = stages.data();
@@ -2626,6 +2849,24 @@ namespace plume {
             return;
         }
 
+        // Only the load operations differ, so the pass stays compatible with the framebuffer and the pipelines.
+        const bool discardDepth = desc.depthAttachmentDiscarded && !desc.depthAttachmentReadOnly && (subpass.pDepthStencilAttachment != nullptr);
+        if (desc.colorAttachmentsDiscarded || discardDepth) {
+            for (uint32_t i = 0; i < attachments.size(); i++) {
+                const bool isDepthAttachment = (subpass.pDepthStencilAttachment != nullptr) && (i == depthReference.attachment);
+                if (isDepthAttachment ? discardDepth : desc.colorAttachmentsDiscarded) {
+                    attachments[i].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                    attachments[i].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                }
+            }
+
+            res = vkCreateRenderPass(device->vk, &passInfo, nullptr, &discardRenderPass);
+            if (res != VK_SUCCESS) {
+                fprintf(stderr, "vkCreateRenderPass failed with error code 0x%X.\n", res);
+                return;
+            }
+        }
+
         VkFramebufferCreateInfo fbInfo = {};
         fbInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
         fbInfo.renderPass = renderPass;
@@ -2650,6 +2891,10 @@ namespace plume {
         if (renderPass != VK_NULL_HANDLE) {
             vkDestroyRenderPass(device->vk, renderPass, nullptr);
         }
+
+        if (discardRenderPass != VK_NULL_HANDLE) {
+            vkDestroyRenderPass(device->vk, discardRenderPass, nullptr);
+        }
     }
 
     uint32_t VulkanFramebuffer::getWidth() const {
@@ -2861,13 +3106,19 @@ namespace plume {
             imageMemoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT; // TODO
             imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
             imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-            imageMemoryBarrier.oldLayout = toImageLayout(interfaceTexture->textureLayout);
+            imageMemoryBarrier.oldLayout = textureBarrier.discard ? VK_IMAGE_LAYOUT_UNDEFINED : toImageLayout(interfaceTexture->textureLayout);
             imageMemoryBarrier.newLayout = toImageLayout(textureBarrier.layout);
             imageMemoryBarrier.subresourceRange.levelCount = interfaceTexture->desc.mipLevels;
             imageMemoryBarrier.subresourceRange.layerCount = interfaceTexture->desc.arraySize;
             imageMemoryBarrier.subresourceRange.aspectMask = toAspectFlags(interfaceTexture->desc.format, interfaceTexture->desc.flags);
             imageMemoryBarriers.emplace_back(imageMemoryBarrier);
             srcStageMask |= toStageFlags(interfaceTexture->barrierStages, geometryEnabled, rtEnabled);
+
+            // The memory might have been used by other textures placed in the same heap since this one was last used.
+            if (interfaceTexture->placed) {
+                srcStageMask |= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+            }
+
             interfaceTexture->textureLayout = textureBarrier.layout;
             interfaceTexture->barrierStages = stages;
         }
@@ -3095,6 +3346,8 @@ namespace plume {
         else {
             targetFramebuffer = nullptr;
         }
+
+        targetFramebufferStarted = false;
     }
 
     void VulkanCommandList::setDepthBias(float depthBias, float depthBiasClamp, float slopeScaledDepthBias) {
@@ -3218,6 +3471,24 @@ namespace plume {
             imageCopy.imageExtent.depth = srcLocation.placedFootprint.depth;
             vkCmdCopyBufferToImage(vk, srcBuffer->vk, dstTexture->vk, toImageLayout(dstTexture->textureLayout), 1, &imageCopy);
         }
+        else if ((dstLocation.type == RenderTextureCopyType::PLACED_FOOTPRINT) && (srcLocation.type == RenderTextureCopyType::SUBRESOURCE)) {
+            assert(dstBuffer != nullptr);
+            assert(srcTexture != nullptr);
+
+            const uint32_t blockWidth = RenderFormatBlockWidth(srcTexture->desc.format);
+            VkBufferImageCopy imageCopy = {};
+            imageCopy.bufferOffset = dstLocation.placedFootprint.offset;
+            imageCopy.bufferRowLength = ((dstLocation.placedFootprint.rowWidth + blockWidth - 1) / blockWidth) * blockWidth;
+            imageCopy.bufferImageHeight = ((dstLocation.placedFootprint.height + blockWidth - 1) / blockWidth) * blockWidth;
+            imageCopy.imageSubresource.aspectMask = toAspectFlags(srcTexture->desc.format, srcTexture->desc.flags);
+            imageCopy.imageSubresource.baseArrayLayer = srcLocation.subresource.arrayIndex;
+            imageCopy.imageSubresource.layerCount = 1;
+            imageCopy.imageSubresource.mipLevel = srcLocation.subresource.mipLevel;
+            imageCopy.imageExtent.width = dstLocation.placedFootprint.width;
+            imageCopy.imageExtent.height = dstLocation.placedFootprint.height;
+            imageCopy.imageExtent.depth = dstLocation.placedFootprint.depth;
+            vkCmdCopyImageToBuffer(vk, srcTexture->vk, toImageLayout(srcTexture->textureLayout), dstBuffer->vk, 1, &imageCopy);
+        }
         else {
             VkImageCopy imageCopy = {};
             imageCopy.srcSubresource.aspectMask = toAspectFlags(srcTexture->desc.format, srcTexture->desc.flags);
@@ -3459,14 +3730,18 @@ namespace plume {
         assert(targetFramebuffer != nullptr);
 
         if (activeRenderPass == VK_NULL_HANDLE) {
+            // The discarding pass is only valid for the first pass after binding, the ones that resume
+            // after a barrier or a copy split the pass have to keep what was drawn before the split.
+            const bool discard = !targetFramebufferStarted && (targetFramebuffer->discardRenderPass != VK_NULL_HANDLE);
             VkRenderPassBeginInfo beginInfo = {};
             beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-            beginInfo.renderPass = targetFramebuffer->renderPass;
+            beginInfo.renderPass = discard ? targetFramebuffer->discardRenderPass : targetFramebuffer->renderPass;
             beginInfo.framebuffer = targetFramebuffer->vk;
             beginInfo.renderArea.extent.width = targetFramebuffer->width;
             beginInfo.renderArea.extent.height = targetFramebuffer->height;
             vkCmdBeginRenderPass(vk, &beginInfo, VkSubpassContents::VK_SUBPASS_CONTENTS_INLINE);
-            activeRenderPass = targetFramebuffer->renderPass;
+            activeRenderPass = beginInfo.renderPass;
+            targetFramebufferStarted = true;
         }
     }
 
@@ -3842,6 +4117,14 @@ namespace plume {
             featuresChain = &presentWaitFeatures;
         }
 
+        VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT graphicsPipelineLibraryFeatures = {};
+        const bool graphicsPipelineLibrarySupported = supportedOptionalExtensions.find(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) != supportedOptionalExtensions.end() && supportedOptionalExtensions.find(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME) != supportedOptionalExtensions.end();
+        if (graphicsPipelineLibrarySupported) {
+            graphicsPipelineLibraryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+            graphicsPipelineLibraryFeatures.pNext = featuresChain;
+            featuresChain = &graphicsPipelineLibraryFeatures;
+        }
+
         VkPhysicalDeviceRobustness2FeaturesEXT robustnessFeatures = {};
         robustnessFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ROBUSTNESS_2_FEATURES_EXT;
         robustnessFeatures.pNext = featuresChain;
@@ -3923,6 +4206,25 @@ namespace plume {
             createDeviceChain = &presentWaitFeatures;
         }
 
+        bool graphicsPipelineLibrary = graphicsPipelineLibraryFeatures.graphicsPipelineLibrary;
+        if (graphicsPipelineLibrary) {
+            VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT graphicsPipelineLibraryProperties = {};
+            graphicsPipelineLibraryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT;
+
+            VkPhysicalDeviceProperties2 deviceProperties2 = {};
+            deviceProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+            deviceProperties2.pNext = &graphicsPipelineLibraryProperties;
+            vkGetPhysicalDeviceProperties2(physicalDevice, &deviceProperties2);
+
+            // Linking can take as long as a full compile without fast linking, which defeats the point.
+            graphicsPipelineLibrary = graphicsPipelineLibraryProperties.graphicsPipelineLibraryFastLinking;
+        }
+
+        if (graphicsPipelineLibrary) {
+            graphicsPipelineLibraryFeatures.pNext = createDeviceChain;
+            createDeviceChain = &graphicsPipelineLibraryFeatures;
+        }
+
         const bool nullDescriptor = robustnessFeatures.nullDescriptor;
         if (nullDescriptor) {
             robustnessFeatures.pNext = createDeviceChain;
@@ -4057,6 +4359,9 @@ namespace plume {
 
         VmaAllocatorCreateInfo allocatorInfo = {};
         allocatorInfo.flags |= bufferDeviceAddress ? VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT : 0;
+
+        const bool memoryBudgetSupported = supportedOptionalExtensions.find(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) != supportedOptionalExtensions.end();
+        allocatorInfo.flags |= memoryBudgetSupported ? VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT : 0;
         allocatorInfo.physicalDevice = physicalDevice;
         allocatorInfo.device = vk;
         allocatorInfo.pVulkanFunctions = &vmaFunctions;
@@ -4094,15 +4399,23 @@ namespace plume {
             }
         }
 
+        uint32_t memoryHeapIndex = 0;
         for (uint32_t i = 0; i < memoryProps->memoryHeapCount; i++) {
-            if (memoryProps->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
-                memoryHeapSize = std::max(memoryProps->memoryHeaps[i].size, memoryHeapSize);
+            if ((memoryProps->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) && (memoryProps->memoryHeaps[i].size > memoryHeapSize)) {
+                memoryHeapSize = memoryProps->memoryHeaps[i].size;
+                memoryHeapIndex = i;
             }
         }
 
         // Fill description.
         description.dedicatedVideoMemory = memoryHeapSize;
 
+        if (memoryBudgetSupported && (memoryHeapSize > 0)) {
+            VmaBudget heapBudgets[VK_MAX_MEMORY_HEAPS] = {};
+            vmaGetHeapBudgets(allocator, heapBudgets);
+            description.videoMemoryBudget = heapBudgets[memoryHeapIndex].budget;
+        }
+
         // Fill capabilities.
         capabilities.geometryShader = deviceFeatures.features.geometryShader;
         capabilities.raytracing = rtSupported;
@@ -4113,6 +4426,9 @@ namespace plume {
         capabilities.scalarBlockLayout = scalarBlockLayout;
         capabilities.bufferDeviceAddress = bufferDeviceAddress;
         capabilities.presentWait = presentWait;
+        capabilities.graphicsPipelineLibrary = graphicsPipelineLibrary;
+        capabilities.textureCompressionBC = deviceFeatures.features.textureCompressionBC;
+        capabilities.textureCompressionETC2 = deviceFeatures.features.textureCompressionETC2;
         capabilities.displayTiming = supportedOptionalExtensions.find(VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME) != supportedOptionalExtensions.end();
         capabilities.maxTextureSize = physicalDeviceProperties.limits.maxImageDimension2D;
         capabilities.preferHDR = memoryHeapSize > (512 * 1024 * 1024);
@@ -4412,7 +4728,71 @@ namespace plume {
         }
     }
 
+    VkRenderPass VulkanDevice::getPipelineLibraryRenderPass(const VkFormat *renderTargetFormat, uint32_t renderTargetCount, VkFormat depthTargetFormat, VkSampleCountFlagBits sampleCount) {
+        PipelineLibraryHash hash;
+        hash.add(renderTargetFormat, renderTargetCount * sizeof(VkFormat));
+        hash.add(depthTargetFormat);
+        hash.add(sampleCount);
+
+        // All the parts of a linked pipeline have to agree on the render pass, so they share one per set of formats.
+        const std::scoped_lock lock(pipelineLibraryMutex);
+        VkRenderPass &renderPass = pipelineLibraryRenderPasses[hash.value];
+        if (renderPass == VK_NULL_HANDLE) {
+            renderPass = VulkanGraphicsPipeline::createRenderPass(this, renderTargetFormat, renderTargetCount, depthTargetFormat, sampleCount);
+        }
+
+        return renderPass;
+    }
+
+    VkPipeline VulkanDevice::getPipelineLibrary(uint64_t hash, const VkGraphicsPipelineCreateInfo &createInfo, VkGraphicsPipelineLibraryFlagsEXT libraryFlags) {
+        {
+            const std::scoped_lock lock(pipelineLibraryMutex);
+            auto it = pipelineLibraries.find(hash);
+            if (it != pipelineLibraries.end()) {
+                return it->second;
+            }
+        }
+
+        // Compiled outside the lock, so threads compiling different parts don't wait on each other.
+        VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo = {};
+        libraryInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+        libraryInfo.pNext = createInfo.pNext;
+        libraryInfo.flags = libraryFlags;
+
+        VkGraphicsPipelineCreateInfo pipelineInfo = createInfo;
+        pipelineInfo.pNext = &libraryInfo;
+        pipelineInfo.flags |= VK_PIPELINE_CREATE_LIBRARY_BIT_KHR;
+
+        VkPipeline library = VK_NULL_HANDLE;
+        VkResult res = vkCreateGraphicsPipelines(vk, pipelineCache, 1, &pipelineInfo, nullptr, &library);
+        if (res != VK_SUCCESS) {
+            fprintf(stderr, "vkCreateGraphicsPipelines failed to create pipeline library with error code 0x%X.\n", res);
+            return VK_NULL_HANDLE;
+        }
+
+        const std::scoped_lock lock(pipelineLibraryMutex);
+        auto [it, inserted] = pipelineLibraries.emplace(hash, library);
+        if (!inserted) {
+            vkDestroyPipeline(vk, library, nullptr);
+        }
+
+        return it->second;
+    }
+
     void VulkanDevice::release() {
+        for (auto &[hash, library] : pipelineLibraries) {
+            vkDestroyPipeline(vk, library, nullptr);
+        }
+
+        for (auto &[hash, renderPass] : pipelineLibraryRenderPasses) {
+            if (renderPass != VK_NULL_HANDLE) {
+                vkDestroyRenderPass(vk, renderPass, nullptr);
+            }
+        }
+
+        pipelineLibraries.clear();
+        pipelineLibraryRenderPasses.clear();
+
         if (allocator != VK_NULL_HANDLE) {
         if (pipelineCache != VK_NULL_HANDLE) {
             if (g_savePipelineCacheCallback) {
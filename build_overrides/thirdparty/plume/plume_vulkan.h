@@ -9,6 +9,7 @@
 
 #include "plume_render_interface.h"
 
+#include <atomic>
 #include <vector>
 #include <cstdint>
 #include <mutex>
@@ -91,6 +92,7 @@ namespace plume {
         RenderTextureLayout textureLayout = RenderTextureLayout::UNKNOWN;
         RenderBarrierStages barrierStages = RenderBarrierStage::NONE;
         bool ownership = false;
+        bool placed = false;
         RenderTextureDesc desc;
 
         VulkanTexture() = default;
@@ -148,6 +150,9 @@ namespace plume {
         VulkanDevice *device = nullptr;
         RenderShaderFormat format = RenderShaderFormat::UNKNOWN;
 
+        // Never reused, unlike the module handle, so it's safe to use as a pipeline library key.
+        uint64_t id = 0;
+
         VulkanShader(VulkanDevice *device, const void *data, uint64_t size, const char *entryPointName, RenderShaderFormat format);
         ~VulkanShader() override;
         virtual void setName(const std::string &name) override;
@@ -273,6 +278,7 @@ namespace plume {
         VulkanDevice *device = nullptr;
         VkFramebuffer vk = VK_NULL_HANDLE;
         VkRenderPass renderPass = VK_NULL_HANDLE;
+        VkRenderPass discardRenderPass = VK_NULL_HANDLE;
         std::vector<const VulkanTexture *> colorAttachments;
         const VulkanTexture *depthAttachment = nullptr;
         std::unique_ptr<VulkanTextureView> depthAttachmentView = nullptr;
@@ -304,6 +310,7 @@ namespace plume {
         VkCommandPool commandPool = VK_NULL_HANDLE;
         VulkanCommandQueue *queue = nullptr;
         const VulkanFramebuffer *targetFramebuffer = nullptr;
+        bool targetFramebufferStarted = false;
         const VulkanPipelineLayout *activeComputePipelineLayout = nullptr;
         const VulkanPipelineLayout *activeGraphicsPipelineLayout = nullptr;
         const VulkanPipelineLayout *activeRaytracingPipelineLayout = nullptr;
@@ -424,6 +431,9 @@ namespace plume {
         std::unique_ptr<RenderBuffer> nullBuffer;
         bool loadStoreOpNoneSupported = false;
         bool nullDescriptorSupported = false;
+        std::mutex pipelineLibraryMutex;
+        std::unordered_map<uint64_t, VkPipeline> pipelineLibraries;
+        std::unordered_map<uint64_t, VkRenderPass> pipelineLibraryRenderPasses;
 
         VulkanDevice(VulkanInterface *renderInterface, const std::string &preferredDeviceName);
         ~VulkanDevice() override;
@@ -449,6 +459,8 @@ namespace plume {
         const RenderDeviceCapabilities &getCapabilities() const override;
         const RenderDeviceDescription &getDescription() const override;
         RenderSampleCounts getSampleCountsSupported(RenderFormat format) const override;
+        VkRenderPass getPipelineLibraryRenderPass(const VkFormat *renderTargetFormat, uint32_t renderTargetCount, VkFormat depthTargetFormat, VkSampleCountFlagBits sampleCount);
+        VkPipeline getPipelineLibrary(uint64_t hash, const VkGraphicsPipelineCreateInfo &createInfo, VkGraphicsPipelineLibraryFlagsEXT libraryFlags);
         void release();
         bool isValid() const;
         bool beginCapture() override;
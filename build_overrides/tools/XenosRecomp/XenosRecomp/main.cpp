@@ -207,6 +207,32 @@ int main(int argc, char** argv)
 
         fmt::println(outFile, "}};");
 
+        // Open addressed lookup table for the runtime, so finding an entry takes one probe in the common
+        // case instead of a binary search. Kept at most half full, the hashes are uniform enough to index
+        // with their low bits directly.
+        size_t tableSize = 1;
+        while (tableSize < shaders.size() * 2)
+            tableSize <<= 1;
+
+        std::vector<std::pair<XXH64_hash_t, uint32_t>> table(tableSize, { 0, UINT32_MAX });
+        uint32_t entryIndex = 0;
+
+        for (auto& [hash, shader] : shaders)
+        {
+            size_t slot = hash & (tableSize - 1);
+            while (table[slot].second != UINT32_MAX)
+                slot = (slot + 1) & (tableSize - 1);
+
+            table[slot] = { hash, entryIndex++ };
+        }
+
+        fmt::println(outFile, "const ShaderCacheTableSlot g_shaderCacheTable[] = {{");
+
+        for (auto& [hash, index] : table)
+            fmt::println(outFile, "\t{{ 0x{:X}, 0x{:X} }},", hash, index);
+
+        fmt::println(outFile, "}};\nconst size_t g_shaderCacheTableMask = 0x{:X};", tableSize - 1);
+
         int level = ZSTD_maxCLevel();
 
 #ifdef XENOS_RECOMP_DXIL
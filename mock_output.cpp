@@ -1,6 +1,10 @@
 #include "shader_cache.h"
 ShaderCacheEntry g_shaderCacheEntries[] = {
 };
+const ShaderCacheTableSlot g_shaderCacheTable[] = {
+	{ 0x0, 0xFFFFFFFF },
+};
+const size_t g_shaderCacheTableMask = 0x0;
 const uint8_t g_compressedSpirvCache[] = {
 	0x28, 0xB5, 0x2F, 0xFD, 0x20, 0x00, 0x01, 0x00, 0x00,
 };
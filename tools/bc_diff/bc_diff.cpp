@@ -45,6 +45,7 @@ int main(int argc, char** argv)
     std::filesystem::path newDirectoryPath = argv[2];
 
     std::vector<BlockCompressionDiffPatchEntry> entries;
+    std::vector<uint32_t> dataSizes;
     std::vector<BlockCompressionDiffPatch> patches;
     std::vector<uint8_t> patchBytes;
 
@@ -106,6 +107,7 @@ int main(int argc, char** argv)
                 entry.hash = XXH3_64bits(oldFileData.data(), oldFileData.size());
                 entry.patchesOffset = patchIndex * sizeof(BlockCompressionDiffPatch);
                 entry.patchCount = patchCount;
+                dataSizes.push_back(oldFileData.size());
 
                 printf("Generated BC patch for %s\n", oldFile.path().string().c_str());
             }
@@ -116,13 +118,29 @@ int main(int argc, char** argv)
         }
     }
 
-    std::sort(entries.begin(), entries.end(), [](auto& lhs, auto& rhs) { return lhs.hash < rhs.hash; });
+    std::vector<size_t> order(entries.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+
+    std::sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) { return entries[lhs].hash < entries[rhs].hash; });
+
+    std::vector<BlockCompressionDiffPatchEntry> sortedEntries;
+    std::vector<uint32_t> sortedDataSizes;
+    for (size_t i : order)
+    {
+        sortedEntries.push_back(entries[i]);
+        sortedDataSizes.push_back(dataSizes[i]);
+    }
+
+    entries = std::move(sortedEntries);
+    dataSizes = std::move(sortedDataSizes);
 
     BlockCompressionDiffPatchHeader header;
     header.entriesOffset = sizeof(BlockCompressionDiffPatchHeader);
     header.entryCount = entries.size();
+    header.dataSizesOffset = header.entriesOffset + sizeof(BlockCompressionDiffPatchEntry) * entries.size();
 
-    size_t patchesOffset = header.entriesOffset + sizeof(BlockCompressionDiffPatchEntry) * entries.size();
+    size_t patchesOffset = header.dataSizesOffset + sizeof(uint32_t) * dataSizes.size();
     size_t patchBytesOffset = patchesOffset + sizeof(BlockCompressionDiffPatch) * patches.size();
 
     for (auto& entry : entries)
@@ -140,6 +158,7 @@ int main(int argc, char** argv)
 
     fwrite(&header, sizeof(header), 1, file);
     fwrite(entries.data(), sizeof(BlockCompressionDiffPatchEntry), entries.size(), file);
+    fwrite(dataSizes.data(), sizeof(uint32_t), dataSizes.size(), file);
     fwrite(patches.data(), sizeof(BlockCompressionDiffPatch), patches.size(), file);
     fwrite(patchBytes.data(), 1, patchBytes.size(), file);
     fclose(file);
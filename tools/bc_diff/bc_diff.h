@@ -16,8 +16,10 @@ struct BlockCompressionDiffPatchEntry
     uint32_t patchCount;
 };
 
+// Files written before dataSizesOffset existed have their entries right after the first two fields.
 struct BlockCompressionDiffPatchHeader
 {
     uint32_t entriesOffset;
     uint32_t entryCount;
+    uint32_t dataSizesOffset; // File size of every patched texture, in the same order as the entries.
 };